@@ -0,0 +1,347 @@
+#include "cell.h"
+#include "vars.h"
+#include <ctype.h>
+#include <stdint.h>
+
+/*
+** Tính biểu thức $(( )) với số nguyên 64-bit có dấu, theo thứ tự ưu tiên
+** của C: , = op= ?: || && | ^ & == != < <= > >= << >> + - * / % ** đơn ngôi.
+** Phép toán tràn số được bọc (wrap) qua unsigned thay vì UB. Khi noeval > 0
+** (nhánh bị short-circuit) thì không gán biến và không báo lỗi chia 0.
+*/
+
+typedef struct s_arith {
+    const char *expr;   /* cả biểu thức, để báo lỗi */
+    const char *p;
+    const char *tok;    /* toán hạng đang tính (lỗi chia 0), NULL = tại p */
+    int err;
+    int noeval;
+} t_arith;
+
+static long long parse_comma(t_arith *a);
+static long long parse_assign(t_arith *a);
+static long long parse_unary(t_arith *a);
+
+static void skip_ws(t_arith *a) {
+    while (isspace((unsigned char)*a->p)) a->p++;
+}
+
+static int accept(t_arith *a, const char *op) {
+    size_t n = strlen(op);
+    skip_ws(a);
+    if (strncmp(a->p, op, n))
+        return 0;
+    // không nhận "<" khi thực ra là "<<", "&" khi là "&&"...
+    if (n == 1 && a->p[1] == op[0] && strchr("<>&|*", op[0]))
+        return 0;
+    if (n == 1 && a->p[1] == '=' && strchr("&^|", op[0]))
+        return 0;
+    if (n == 2 && a->p[2] == '=' && (!strcmp(op, "<<") || !strcmp(op, ">>")))
+        return 0;
+    a->p += n;
+    return 1;
+}
+
+// Báo lỗi kèm cả biểu thức và token gây lỗi, như bash
+static void fail(t_arith *a, const char *msg) {
+    const char *tok = a->tok ? a->tok : a->p;
+    if (!a->err) {
+        fprintf(stderr, "cell: %s: %s", a->expr, msg);
+        if (*tok)
+            fprintf(stderr, " (error token is \"%s\")", tok);
+        fputc('\n', stderr);
+    }
+    a->err = 1;
+}
+
+static long long binop_at(t_arith *a, char op, long long x, const char *rhs, long long y);
+
+static long long var_value(const char *name) {
+    const char *v = var_get(name);
+    return v ? strtoll(v, NULL, 0) : 0;
+}
+
+static void var_store(t_arith *a, const char *name, long long v) {
+    char buf[32];
+    if (a->noeval) return;
+    snprintf(buf, sizeof(buf), "%lld", v);
+    var_set(name, buf);
+}
+
+static int read_name(t_arith *a, char *name, size_t size) {
+    size_t n = 0;
+    skip_ws(a);
+    if (!(isalpha((unsigned char)*a->p) || *a->p == '_'))
+        return 0;
+    while ((isalnum((unsigned char)a->p[n]) || a->p[n] == '_') && n + 1 < size) {
+        name[n] = a->p[n];
+        n++;
+    }
+    name[n] = '\0';
+    a->p += n;
+    return 1;
+}
+
+static long long do_binop(t_arith *a, char op, long long x, long long y) {
+    uint64_t ux = x, uy = y;
+    switch (op) {
+    case '+': return (long long)(ux + uy);
+    case '-': return (long long)(ux - uy);
+    case '*': return (long long)(ux * uy);
+    case '/':
+    case '%':
+        if (y == 0) {
+            if (!a->noeval) fail(a, "division by zero");
+            return 0;
+        }
+        if (x == INT64_MIN && y == -1)
+            return op == '/' ? x : 0;
+        return op == '/' ? x / y : x % y;
+    case '<': return (long long)(ux << (y & 63));
+    case '>': return x >> (y & 63);
+    case '&': return x & y;
+    case '^': return x ^ y;
+    case '|': return x | y;
+    }
+    return 0;
+}
+
+// do_binop với lỗi (chia 0) trỏ vào toán hạng phải bắt đầu tại rhs
+static long long binop_at(t_arith *a, char op, long long x, const char *rhs, long long y) {
+    a->tok = rhs;
+    long long v = do_binop(a, op, x, y);
+    a->tok = NULL;
+    return v;
+}
+
+static long long parse_primary(t_arith *a) {
+    char name[128];
+    skip_ws(a);
+    if (*a->p == '(') {
+        a->p++;
+        long long v = parse_comma(a);
+        skip_ws(a);
+        if (*a->p != ')') { fail(a, "missing ')'"); return 0; }
+        a->p++;
+        return v;
+    }
+    if (isdigit((unsigned char)*a->p)) {
+        char *end;
+        long long v = (long long)strtoull(a->p, &end, 0);
+        a->p = end;
+        return v;
+    }
+    if (read_name(a, name, sizeof(name))) {
+        long long v = var_value(name);
+        skip_ws(a);
+        // hậu tố ++/--
+        if (!strncmp(a->p, "++", 2) || !strncmp(a->p, "--", 2)) {
+            var_store(a, name, *a->p == '+' ? v + 1 : v - 1);
+            a->p += 2;
+        }
+        return v;
+    }
+    fail(a, *a->p ? "syntax error" : "operand expected");
+    return 0;
+}
+
+static long long parse_unary(t_arith *a) {
+    char name[128];
+    skip_ws(a);
+    if (!strncmp(a->p, "++", 2) || !strncmp(a->p, "--", 2)) {
+        int inc = *a->p == '+';
+        a->p += 2;
+        if (!read_name(a, name, sizeof(name))) { fail(a, "variable expected"); return 0; }
+        long long v = var_value(name) + (inc ? 1 : -1);
+        var_store(a, name, v);
+        return v;
+    }
+    if (*a->p == '-') { a->p++; return (long long)(0 - (uint64_t)parse_unary(a)); }
+    if (*a->p == '+') { a->p++; return parse_unary(a); }
+    if (*a->p == '!') { a->p++; return !parse_unary(a); }
+    if (*a->p == '~') { a->p++; return ~parse_unary(a); }
+    return parse_primary(a);
+}
+
+// ** kết hợp phải và ưu tiên cao hơn * / %
+static long long parse_power(t_arith *a) {
+    long long base = parse_unary(a);
+    skip_ws(a);
+    if (!strncmp(a->p, "**", 2)) {
+        a->p += 2;
+        long long e = parse_power(a);
+        if (e < 0) { fail(a, "exponent less than 0"); return 0; }
+        uint64_t r = 1, b = base;
+        for (; e; e >>= 1, b *= b)
+            if (e & 1) r *= b;
+        return (long long)r;
+    }
+    return base;
+}
+
+static long long parse_mul(t_arith *a) {
+    long long v = parse_power(a);
+    for (;;) {
+        skip_ws(a);
+        char op = *a->p;
+        if ((op == '*' || op == '/' || op == '%') && a->p[1] != '=' && a->p[1] != '*') {
+            a->p++;
+            skip_ws(a);
+            const char *rhs = a->p;
+            v = binop_at(a, op, v, rhs, parse_power(a));
+        } else
+            return v;
+    }
+}
+
+static long long parse_add(t_arith *a) {
+    long long v = parse_mul(a);
+    for (;;) {
+        skip_ws(a);
+        char op = *a->p;
+        if ((op == '+' || op == '-') && a->p[1] != '=' && a->p[1] != op) {
+            a->p++;
+            v = do_binop(a, op, v, parse_mul(a));
+        } else
+            return v;
+    }
+}
+
+static long long parse_shift(t_arith *a) {
+    long long v = parse_add(a);
+    for (;;) {
+        if (accept(a, "<<")) v = do_binop(a, '<', v, parse_add(a));
+        else if (accept(a, ">>")) v = do_binop(a, '>', v, parse_add(a));
+        else return v;
+    }
+}
+
+static long long parse_rel(t_arith *a) {
+    long long v = parse_shift(a);
+    for (;;) {
+        if (accept(a, "<=")) v = v <= parse_shift(a);
+        else if (accept(a, ">=")) v = v >= parse_shift(a);
+        else if (accept(a, "<")) v = v < parse_shift(a);
+        else if (accept(a, ">")) v = v > parse_shift(a);
+        else return v;
+    }
+}
+
+static long long parse_eq(t_arith *a) {
+    long long v = parse_rel(a);
+    for (;;) {
+        if (accept(a, "==")) v = v == parse_rel(a);
+        else if (accept(a, "!=")) v = v != parse_rel(a);
+        else return v;
+    }
+}
+
+static long long parse_band(t_arith *a) {
+    long long v = parse_eq(a);
+    while (accept(a, "&")) v &= parse_eq(a);
+    return v;
+}
+
+static long long parse_bxor(t_arith *a) {
+    long long v = parse_band(a);
+    while (accept(a, "^")) v ^= parse_band(a);
+    return v;
+}
+
+static long long parse_bor(t_arith *a) {
+    long long v = parse_bxor(a);
+    while (accept(a, "|")) v |= parse_bxor(a);
+    return v;
+}
+
+static long long parse_land(t_arith *a) {
+    long long v = parse_bor(a);
+    while (accept(a, "&&")) {
+        if (!v) a->noeval++;
+        long long r = parse_bor(a);
+        if (!v) a->noeval--;
+        v = v && r;
+    }
+    return v;
+}
+
+static long long parse_lor(t_arith *a) {
+    long long v = parse_land(a);
+    while (accept(a, "||")) {
+        if (v) a->noeval++;
+        long long r = parse_land(a);
+        if (v) a->noeval--;
+        v = v || r;
+    }
+    return v;
+}
+
+static long long parse_cond(t_arith *a) {
+    long long c = parse_lor(a);
+    skip_ws(a);
+    if (*a->p != '?')
+        return c;
+    a->p++;
+    if (!c) a->noeval++;
+    long long x = parse_assign(a);
+    if (!c) a->noeval--;
+    skip_ws(a);
+    if (*a->p != ':') { fail(a, "expected ':'"); return 0; }
+    a->p++;
+    if (c) a->noeval++;
+    long long y = parse_cond(a);
+    if (c) a->noeval--;
+    return c ? x : y;
+}
+
+static long long parse_assign(t_arith *a) {
+    static const char *ops[] = { "<<=", ">>=", "+=", "-=", "*=", "/=", "%=",
+                                 "&=", "^=", "|=", "=", NULL };
+    const char *save = a->p;
+    char name[128];
+
+    if (read_name(a, name, sizeof(name))) {
+        skip_ws(a);
+        for (int i = 0; ops[i]; i++) {
+            size_t n = strlen(ops[i]);
+            if (strncmp(a->p, ops[i], n) || (n == 1 && a->p[1] == '='))
+                continue;
+            a->p += n;
+            skip_ws(a);
+            const char *at = a->p;
+            long long rhs = parse_assign(a), v = rhs;
+            if (n > 1) {
+                char op = ops[i][0];
+                v = binop_at(a, op, var_value(name), at, rhs);
+            }
+            var_store(a, name, v);
+            return v;
+        }
+    }
+    a->p = save;
+    return parse_cond(a);
+}
+
+static long long parse_comma(t_arith *a) {
+    long long v = parse_assign(a);
+    while (accept(a, ","))
+        v = parse_assign(a);
+    return v;
+}
+
+/**
+ * arith_eval - Evaluates a shell arithmetic expression
+ * @expr: Expression text (variables already expanded or referenced by name)
+ * @out: Receives the 64-bit result
+ * Return: 0 on success, -1 on syntax or evaluation error
+ */
+int arith_eval(const char *expr, long long *out) {
+    t_arith a = { .expr = expr, .p = expr };
+    skip_ws(&a);
+    a.expr = a.p;
+    *out = *a.p ? parse_comma(&a) : 0;
+    skip_ws(&a);
+    if (*a.p && !a.err)
+        fail(&a, "syntax error");
+    return a.err ? -1 : 0;
+}
@@ -0,0 +1,366 @@
+#include "cell.h"
+#include "cmdtab.h"
+#include <fcntl.h>
+#include <math.h>
+#include <time.h>
+#include <sys/resource.h>
+
+/*
+** bench [-n runs] [-w warmup] [-i] [--json|--csv] [--show-output] cmd... [, cmd2...]
+**
+** Chạy mỗi lệnh nhiều lần qua đường thực thi bình thường của shell
+** (cell_execute), đo wall time bằng CLOCK_MONOTONIC và user/sys bằng
+** getrusage (con + chính shell, để builtin cũng được tính). Các lệnh cách
+** nhau bởi token "," được so sánh với lệnh nhanh nhất. Lệnh thoát khác 0
+** làm bench dừng (thời gian của một lệnh không chạy được là vô nghĩa), trừ
+** khi có -i/--ignore-failure: khi đó số lần thất bại được ghi kèm kết quả.
+**
+** bench --dispatch [-n rounds] đo riêng chi phí tra tên lệnh của shell
+** (builtin_find) cho tên trúng builtin và tên trượt (lệnh ngoài), so với
+** cách duyệt strcmp cả bảng.
+*/
+
+#define BENCH_MAX_CMDS 16
+#define BENCH_DEFAULT_RUNS 10
+#define BENCH_DISPATCH_ROUNDS 100000
+
+extern int status;
+
+enum { M_WALL, M_USER, M_SYS, M_COUNT };
+static const char *metric_names[M_COUNT] = { "wall", "user", "sys" };
+
+typedef struct s_summary {
+    double mean, median, stddev, min, max, p95, p99;
+    int outliers;
+} t_summary;
+
+typedef struct s_bench_cmd {
+    char **argv;
+    char *sep;          /* token "," đứng trước argv, NULL hóa khi chạy */
+    int failures;       /* số lần chạy thoát khác 0 (chỉ khi -i) */
+    double *v[M_COUNT];
+    t_summary s[M_COUNT];
+} t_bench_cmd;
+
+static double tv_sec(struct timeval tv) {
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+// Phân vị theo nearest-rank trên mảng đã sắp xếp
+static double percentile(const double *sorted, int n, double p) {
+    int idx = (int)ceil(p / 100.0 * n) - 1;
+    if (idx < 0) idx = 0;
+    if (idx >= n) idx = n - 1;
+    return sorted[idx];
+}
+
+static void summarize(const double *v, int n, t_summary *s) {
+    double *x = Malloc(n * sizeof(double)), sum = 0, sq = 0;
+    memcpy(x, v, n * sizeof(double));
+    qsort(x, n, sizeof(double), cmp_double);
+    for (int i = 0; i < n; i++) sum += x[i];
+    s->mean = sum / n;
+    for (int i = 0; i < n; i++) sq += (x[i] - s->mean) * (x[i] - s->mean);
+    s->stddev = n > 1 ? sqrt(sq / (n - 1)) : 0;
+    s->median = n % 2 ? x[n / 2] : (x[n / 2 - 1] + x[n / 2]) / 2;
+    s->min = x[0];
+    s->max = x[n - 1];
+    s->p95 = percentile(x, n, 95);
+    s->p99 = percentile(x, n, 99);
+    // Outlier theo hàng rào Tukey: ngoài [Q1 - 1.5 IQR, Q3 + 1.5 IQR]
+    double q1 = percentile(x, n, 25), q3 = percentile(x, n, 75), iqr = q3 - q1;
+    s->outliers = 0;
+    for (int i = 0; i < n; i++)
+        if (x[i] < q1 - 1.5 * iqr || x[i] > q3 + 1.5 * iqr)
+            s->outliers++;
+    free(x);
+}
+
+static void fmt_time(char *buf, size_t size, double sec) {
+    if (sec >= 1) snprintf(buf, size, "%.3fs", sec);
+    else if (sec >= 1e-3) snprintf(buf, size, "%.3fms", sec * 1e3);
+    else if (sec >= 1e-6) snprintf(buf, size, "%.1fus", sec * 1e6);
+    else snprintf(buf, size, "%.0fns", sec * 1e9);
+}
+
+static void cmd_text(char **argv, char *buf, size_t size) {
+    buf[0] = '\0';
+    for (int i = 0; argv[i]; i++) {
+        strncat(buf, argv[i], size - strlen(buf) - 1);
+        if (argv[i + 1]) strncat(buf, " ", size - strlen(buf) - 1);
+    }
+}
+
+// Return: exit status của lệnh
+static int run_once(char **argv, int quiet, double out[M_COUNT]) {
+    struct rusage c0, c1, s0, s1;
+    struct timespec t0, t1;
+    int saved = -1;
+
+    fflush(stdout);
+    if (quiet) {
+        int devnull = open("/dev/null", O_WRONLY);
+        saved = dup(STDOUT_FILENO);
+        dup2(devnull, STDOUT_FILENO);
+        close(devnull);
+    }
+    getrusage(RUSAGE_CHILDREN, &c0);
+    getrusage(RUSAGE_SELF, &s0);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    cell_execute(argv, 0);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    getrusage(RUSAGE_SELF, &s1);
+    getrusage(RUSAGE_CHILDREN, &c1);
+    fflush(stdout);
+    if (saved != -1) {
+        dup2(saved, STDOUT_FILENO);
+        close(saved);
+    }
+    out[M_WALL] = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+    out[M_USER] = tv_sec(c1.ru_utime) - tv_sec(c0.ru_utime)
+                + tv_sec(s1.ru_utime) - tv_sec(s0.ru_utime);
+    out[M_SYS] = tv_sec(c1.ru_stime) - tv_sec(c0.ru_stime)
+               + tv_sec(s1.ru_stime) - tv_sec(s0.ru_stime);
+    return status;
+}
+
+static void print_human(t_bench_cmd *cs, int ncmd, int runs, int fastest) {
+    char text[256], a[16], b[16], c[16], d[16], e[16], f[16], g[16];
+    for (int k = 0; k < ncmd; k++) {
+        cmd_text(cs[k].argv, text, sizeof(text));
+        printf("Benchmark #%d: %s (%d runs)\n", k + 1, text, runs);
+        for (int m = 0; m < M_COUNT; m++) {
+            t_summary *s = &cs[k].s[m];
+            fmt_time(a, sizeof(a), s->mean); fmt_time(b, sizeof(b), s->stddev);
+            fmt_time(c, sizeof(c), s->median); fmt_time(d, sizeof(d), s->min);
+            fmt_time(e, sizeof(e), s->max); fmt_time(f, sizeof(f), s->p95);
+            fmt_time(g, sizeof(g), s->p99);
+            printf("  %-4s mean %9s ± %-9s median %9s  min %9s  max %9s  p95 %9s  p99 %9s\n",
+                   metric_names[m], a, b, c, d, e, f, g);
+        }
+        if (cs[k].s[M_WALL].outliers)
+            printf("  warning: %d statistical outlier(s) in wall time; "
+                   "consider more warmup runs or a quieter system\n", cs[k].s[M_WALL].outliers);
+        if (cs[k].failures)
+            printf("  warning: %d of %d run(s) exited with a non-zero status\n",
+                   cs[k].failures, runs);
+    }
+    if (ncmd < 2)
+        return;
+    cmd_text(cs[fastest].argv, text, sizeof(text));
+    printf("Summary\n  %s ran\n", text);
+    t_summary *fs = &cs[fastest].s[M_WALL];
+    for (int k = 0; k < ncmd; k++) {
+        if (k == fastest) continue;
+        t_summary *s = &cs[k].s[M_WALL];
+        double r = s->mean / fs->mean;
+        // Sai số của tỉ số theo lan truyền sai số tương đối
+        double err = r * sqrt(pow(s->stddev / s->mean, 2) + pow(fs->stddev / fs->mean, 2));
+        cmd_text(cs[k].argv, text, sizeof(text));
+        printf("    %.2f ± %.2f times faster than %s\n", r, err, text);
+    }
+}
+
+static void print_json(t_bench_cmd *cs, int ncmd, int runs, int fastest) {
+    char text[256];
+    printf("{\"runs\":%d,\"results\":[", runs);
+    for (int k = 0; k < ncmd; k++) {
+        cmd_text(cs[k].argv, text, sizeof(text));
+        printf("%s{\"command\":\"", k ? "," : "");
+        for (char *c = text; *c; c++) {
+            if (*c == '"' || *c == '\\') putchar('\\');
+            putchar(*c);
+        }
+        printf("\",\"relative\":%.6f", cs[k].s[M_WALL].mean / cs[fastest].s[M_WALL].mean);
+        printf(",\"outliers\":%d,\"failures\":%d", cs[k].s[M_WALL].outliers, cs[k].failures);
+        for (int m = 0; m < M_COUNT; m++) {
+            t_summary *s = &cs[k].s[m];
+            printf(",\"%s\":{\"mean\":%.9f,\"median\":%.9f,\"stddev\":%.9f,\"min\":%.9f,"
+                   "\"max\":%.9f,\"p95\":%.9f,\"p99\":%.9f}", metric_names[m],
+                   s->mean, s->median, s->stddev, s->min, s->max, s->p95, s->p99);
+        }
+        printf(",\"times\":[");
+        for (int i = 0; i < runs; i++)
+            printf("%s%.9f", i ? "," : "", cs[k].v[M_WALL][i]);
+        printf("]}");
+    }
+    printf("]}\n");
+}
+
+static void print_csv(t_bench_cmd *cs, int ncmd, int fastest) {
+    char text[256];
+    printf("command,metric,mean,median,stddev,min,max,p95,p99,outliers,failures,relative\n");
+    for (int k = 0; k < ncmd; k++) {
+        cmd_text(cs[k].argv, text, sizeof(text));
+        for (int m = 0; m < M_COUNT; m++) {
+            t_summary *s = &cs[k].s[m];
+            printf("\"%s\",%s,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%d,%d,%.6f\n", text,
+                   metric_names[m], s->mean, s->median, s->stddev, s->min, s->max,
+                   s->p95, s->p99, s->outliers, cs[k].failures,
+                   cs[k].s[M_WALL].mean / cs[fastest].s[M_WALL].mean);
+        }
+    }
+}
+
+// Tên thường gặp không phải builtin: mọi lệnh ngoài đều đi qua một lần tra trượt
+static const char *dispatch_misses[] = {
+    "ls", "git", "make", "cat", "gcc", "python3", "ssh", "vim", "sed", "awk",
+    "/usr/bin/env", "./configure", NULL
+};
+
+// Cách tra trước đây: strcmp lần lượt từng tên trong bảng
+static const t_builtin *linear_find(const char *name) {
+    for (int i = 0; g_builtin[i].builtin_name; i++)
+        if (!(g_builtin[i].flags & CMD_KEYWORD) && !strcmp(g_builtin[i].builtin_name, name))
+            return &g_builtin[i];
+    return NULL;
+}
+
+// ns trung bình mỗi lần tra
+static double dispatch_ns(const t_builtin *(*find)(const char *), const char **names, int n,
+                          long rounds) {
+    struct timespec a, b;
+    volatile uintptr_t sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (long r = 0; r < rounds; r++)
+        for (int i = 0; i < n; i++)
+            sink += (uintptr_t)find(names[i]);
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    (void)sink;
+    return ((b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec)) / ((double)rounds * n);
+}
+
+static int bench_dispatch(char **args) {
+    long rounds = BENCH_DISPATCH_ROUNDS;
+    int nhits = 0, nmiss = 0;
+
+    if (args[2] && (strcmp(args[2], "-n") || !args[3] || args[4]))
+        rounds = 0;
+    else if (args[2])
+        rounds = atol(args[3]);
+    if (rounds < 1) {
+        fprintf(stderr, "bench: usage: bench --dispatch [-n rounds]\n");
+        return 1;
+    }
+    while (g_builtin[nhits].builtin_name)
+        nhits++;
+    const char **hits = Malloc(nhits * sizeof(char *));
+    nhits = 0;
+    for (int i = 0; g_builtin[i].builtin_name; i++)
+        if (!(g_builtin[i].flags & CMD_KEYWORD))
+            hits[nhits++] = g_builtin[i].builtin_name;
+    while (dispatch_misses[nmiss])
+        nmiss++;
+
+    printf("%-8s %6s %12s %12s\n", "lookup", "names", "hash ns", "linear ns");
+    printf("%-8s %6d %12.1f %12.1f\n", "hit", nhits,
+           dispatch_ns(builtin_find, hits, nhits, rounds),
+           dispatch_ns(linear_find, hits, nhits, rounds));
+    printf("%-8s %6d %12.1f %12.1f\n", "miss", nmiss,
+           dispatch_ns(builtin_find, dispatch_misses, nmiss, rounds),
+           dispatch_ns(linear_find, dispatch_misses, nmiss, rounds));
+    free(hits);
+    return 0;
+}
+
+/*
+** Chạy warmup rồi runs lần một lệnh. Return: -1 nếu lệnh thoát khác 0 mà
+** không có -i (đã báo lỗi), 0 nếu không.
+*/
+static int bench_one(t_bench_cmd *c, int runs, int warmup, int quiet, int ignore) {
+    double sample[M_COUNT];
+    char text[256];
+    for (int r = -warmup; r < runs; r++) {
+        int st = run_once(c->argv, quiet, sample);
+        if (st != 0 && !ignore) {
+            cmd_text(c->argv, text, sizeof(text));
+            fprintf(stderr, "bench: '%s' exited with status %d; "
+                            "use -i to benchmark it anyway\n", text, st);
+            return -1;
+        }
+        if (r < 0)
+            continue;
+        c->failures += st != 0;
+        for (int m = 0; m < M_COUNT; m++)
+            c->v[m][r] = sample[m];
+    }
+    for (int m = 0; m < M_COUNT; m++)
+        summarize(c->v[m], runs, &c->s[m]);
+    return 0;
+}
+
+/**
+ * cell_bench - Benchmarks one or more commands
+ * @args: bench [-n runs] [-w warmup] [-i] [--json|--csv] [--show-output] cmd... [, cmd...]
+ *        or bench --dispatch [-n rounds]
+ * Return: 0 on success, 1 on bad usage or when a command fails without -i
+ */
+int cell_bench(char **args) {
+    t_bench_cmd cs[BENCH_MAX_CMDS];
+    int runs = BENCH_DEFAULT_RUNS, warmup = 0, fmt = 0, quiet = 1, ignore = 0, i = 1, ncmd = 0;
+    int rc = 0;
+
+    if (args[1] && !strcmp(args[1], "--dispatch"))
+        return bench_dispatch(args);
+
+    for (; args[i] && args[i][0] == '-'; i++) {
+        if (!strcmp(args[i], "-n") && args[i + 1]) runs = atoi(args[++i]);
+        else if (!strcmp(args[i], "-w") && args[i + 1]) warmup = atoi(args[++i]);
+        else if (!strcmp(args[i], "-i") || !strcmp(args[i], "--ignore-failure")) ignore = 1;
+        else if (!strcmp(args[i], "--json")) fmt = 1;
+        else if (!strcmp(args[i], "--csv")) fmt = 2;
+        else if (!strcmp(args[i], "--show-output")) quiet = 0;
+        else break;
+    }
+    if (!args[i] || runs < 1 || warmup < 0) {
+        fprintf(stderr, "bench: usage: bench [-n runs] [-w warmup] [-i] [--json|--csv] "
+                        "[--show-output] cmd... [, cmd...]\n");
+        return 1;
+    }
+    // Tách các lệnh tại token ","; token được trả lại trước khi return
+    memset(cs, 0, sizeof(cs));
+    cs[ncmd++].argv = &args[i];
+    for (int k = i; args[k] && rc == 0; k++) {
+        if (strcmp(args[k], ",")) continue;
+        if (ncmd == BENCH_MAX_CMDS || !args[k + 1]) {
+            fprintf(stderr, "bench: expected at most %d non-empty commands\n", BENCH_MAX_CMDS);
+            rc = 1;
+            break;
+        }
+        cs[ncmd].sep = args[k];
+        cs[ncmd++].argv = &args[k + 1];
+    }
+    for (int k = 1; k < ncmd; k++)
+        cs[k].argv[-1] = NULL;
+
+    int fastest = 0, done = 0;
+    for (; rc == 0 && done < ncmd; done++) {
+        for (int m = 0; m < M_COUNT; m++)
+            cs[done].v[m] = Malloc(runs * sizeof(double));
+        if (bench_one(&cs[done], runs, warmup, quiet, ignore) == -1) {
+            rc = 1;
+            done++;
+            break;
+        }
+        if (cs[done].s[M_WALL].mean < cs[fastest].s[M_WALL].mean)
+            fastest = done;
+    }
+
+    if (rc == 0) {
+        if (fmt == 1) print_json(cs, ncmd, runs, fastest);
+        else if (fmt == 2) print_csv(cs, ncmd, fastest);
+        else print_human(cs, ncmd, runs, fastest);
+    }
+
+    for (int k = 0; k < done; k++)
+        for (int m = 0; m < M_COUNT; m++)
+            free(cs[k].v[m]);
+    for (int k = 1; k < ncmd; k++)
+        cs[k].argv[-1] = cs[k].sep;
+    return rc;
+}
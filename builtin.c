@@ -9,24 +9,102 @@
 #include <fcntl.h>
 #include <utime.h>
 #include "processlist.h"
+#include "jobctl.h"
+#include "vars.h"
+#include "memacct.h"
+
+extern int status;
+
+/*
+** Ghi toàn bộ buf vào fd (echo -u tới coproc / fd do shell mở). SIGPIPE bị
+** chặn trong lúc ghi để đầu đọc đã đóng chỉ làm echo lỗi, không giết shell.
+*/
+static int write_fd(int fd, const char *buf, size_t len)
+{
+	sigset_t pipe_set, old;
+	int rc = 0;
+
+	sigemptyset(&pipe_set);
+	sigaddset(&pipe_set, SIGPIPE);
+	sigprocmask(SIG_BLOCK, &pipe_set, &old);
+	while (len > 0)
+	{
+		ssize_t n = write(fd, buf, len);
+		if (n == -1 && errno == EINTR)
+			continue;
+		if (n == -1)
+		{
+			fprintf(stderr, "echo: %d: %s\n", fd, strerror(errno));
+			rc = 1;
+			break;
+		}
+		buf += n;
+		len -= n;
+	}
+	// bỏ SIGPIPE đang treo trước khi mở chặn
+	struct timespec zero = {0, 0};
+	while (sigtimedwait(&pipe_set, NULL, &zero) > 0)
+		;
+	sigprocmask(SIG_SETMASK, &old, NULL);
+	return (rc);
+}
+
+/**
+ * cell_cd - Changes the shell's working directory
+ * @args: cd <dir>
+ * Return: 0 on success, 1 on a missing operand or a failed chdir
+ */
+int	cell_cd(char **args)
+{
+	if (!args[1])
+	{
+		fprintf(stderr, "cd: missing operand\n");
+		return (1);
+	}
+	return (Chdir(args[1]) == -1);
+}
+
 /**
  * cell_echo - Echo command implementation with optional newline suppression
  * @args: Command arguments (args[0] is "echo")
+ * -n: no trailing newline; -u fd: write to fd instead of stdout (coproc)
  * Return: 0 on success, 1 on failure
  */
 int	cell_echo(char **args)
 {
 	int start = 1;
+	int fd = -1;
 	bool newline = true;
 
 	if (!args || !args[0])
 		return (1);
 
-	// Check for the -n option
-	if (args[1] && !strcmp(args[1], "-n"))
+	// Check for the -n / -u fd options
+	while (args[start])
 	{
-		newline = false;
-		start = 2;
+		if (!strcmp(args[start], "-n"))
+			newline = false;
+		else if (!strcmp(args[start], "-u") && args[start + 1])
+			fd = atoi(args[++start]);
+		else
+			break;
+		start++;
+	}
+
+	if (fd >= 0)
+	{
+		t_str out = {0};
+		for (int i = start; args[i]; i++)
+		{
+			str_puts(&out, args[i]);
+			if (args[i + 1])
+				str_putc(&out, ' ');
+		}
+		if (newline)
+			str_putc(&out, '\n');
+		int rc = write_fd(fd, out.s ? out.s : "", out.len);
+		free(out.s);
+		return (rc);
 	}
 
 	// Print each argument separated by a space
@@ -90,13 +168,27 @@ int	cell_env(char **args)
 
 /**
  * cell_exit - Exit shell with status
+ * @args: exit [N]; without N the shell exits with the last status
  */
 int	cell_exit(char **args)
 {
-	(void)args;
-	dbzSpinnerLoading();
-	exit(EX_OK);
-} 
+	int code = status;
+	if (args[1]) {
+		char *end;
+		long n = strtol(args[1], &end, 10);
+		if (end == args[1] || *end) {
+			fprintf(stderr, "exit: %s: numeric argument required\n", args[1]);
+			code = 2;
+		} else {
+			code = n & 0xff;
+		}
+	}
+	// request của server: trả mã ngay cho client, không có hiệu ứng thoát
+	if (!cell_serving)
+		dbzSpinnerLoading();
+	fflush(stdout);
+	exit(code);
+}
 int cell_pwd(char **args) {
     char cwd[1024];
     if (getcwd(cwd, sizeof(cwd)) != NULL) {
@@ -114,44 +206,84 @@ int cell_clear(char **args) {
     return ret;
 }
 
-// Lưu lịch sử lệnh (đơn giản, tối đa 100 lệnh)
-#define HISTORY_SIZE 100
-char *history[HISTORY_SIZE];
+/*
+** Lịch sử lệnh: ring buffer HISTORY_MAX dòng và tối đa HISTORY_MAX_BYTES byte,
+** dòng cũ nhất bị đẩy ra khi vượt một trong hai. Đây là bản duy nhất: bộ soạn
+** dòng (LINEEDIT=1) đọc qua cell_history_at. Số thứ tự không đổi khi đẩy ra.
+*/
+#define HISTORY_MAX 1000
+#define HISTORY_MAX_BYTES (256 * 1024)
+static char *history[HISTORY_MAX];
+static int hist_first = 0;
+static size_t hist_bytes = 0;
+static int hist_base = 0;       /* số dòng đã bị đẩy ra */
 int history_count = 0;
 
+static void history_evict(void) {
+    char **e = &history[hist_first];
+    hist_bytes -= strlen(*e) + 1;
+    free(*e);
+    *e = NULL;
+    hist_first = (hist_first + 1) % HISTORY_MAX;
+    history_count--;
+    hist_base++;
+}
+
 void add_history(const char *cmd) {
-    if (history_count < HISTORY_SIZE) {
-        history[history_count++] = strdup(cmd);
-    } else {
-        free(history[0]);
-        memmove(history, history + 1, sizeof(char*) * (HISTORY_SIZE - 1));
-        history[HISTORY_SIZE - 1] = strdup(cmd);
+    size_t len = strlen(cmd) + 1;
+    if (len > HISTORY_MAX_BYTES)
+        return;
+    while (history_count == HISTORY_MAX || (history_count && hist_bytes + len > HISTORY_MAX_BYTES))
+        history_evict();
+    history[(hist_first + history_count++) % HISTORY_MAX] = strdup(cmd);
+    hist_bytes += len;
+}
+
+// Dòng thứ i (0 = cũ nhất còn giữ), NULL nếu ngoài khoảng
+const char *cell_history_at(int i) {
+    if (i < 0 || i >= history_count)
+        return NULL;
+    return history[(hist_first + i) % HISTORY_MAX];
+}
+
+void history_mem(t_memuse *u) {
+    for (int i = 0; i < history_count; i++) {
+        u->objects++;
+        u->bytes += mem_size(cell_history_at(i));
     }
 }
 
 int cell_help(char **args) {
+    printf("Các lệnh hỗ trợ trong tinyShell:\n\n");
+    for (int i = 0; g_builtin[i].builtin_name; i++)
+        if (g_builtin[i].help)
+            fputs(g_builtin[i].help, stdout);
     printf(
-        "Các lệnh hỗ trợ trong tinyShell:\n\n"
-        "  help, cellhelp      Hiển thị thông tin trợ giúp này\n"
-        "  cd <dir>            Đổi thư mục làm việc hiện tại\n"
-        "  exit                Thoát shell\n"
-        "  jobs                Liệt kê các tiến trình nền\n"
-        "  fg <pid>            Đưa tiến trình nền về foreground\n"
-        "  kill <pid>          Kết thúc tiến trình theo pid\n"
-        "  history             Hiển thị lịch sử lệnh\n"
+        "\n"
+        "  Ctrl-Z              Dừng job foreground, đưa vào danh sách jobs\n"
         "  !<n>                Thực thi lại lệnh thứ n trong history\n"
         "  <lệnh> &            Chạy lệnh ở chế độ nền (background)\n"
-        "  <lệnh1> | <lệnh2>   Kết hợp hai lệnh qua pipe\n"
+        "  <lệnh1> | <lệnh2>   Kết hợp các lệnh qua pipe (nhiều stage)\n"
+        "  <lệnh> |+ <c1> |+ <c2>  Nhân bản output cho nhiều consumer (tee/splice)\n"
         "  <lệnh> > file       Ghi output vào file\n"
         "  <lệnh> >> file      Ghi tiếp output vào file\n"
         "  <lệnh> < file       Đọc input từ file\n"
+        "  [n]> [n]>> [n]< [n]<> file, n>&m, n<&m, n>&-, &> file, &>> file\n"
+        "                      Chuyển hướng fd bất kỳ; cả builtin, hàm, done < f, } > f\n"
+        "  <(lệnh) / >(lệnh)   Thay bằng /dev/fd/N nối với lệnh con qua pipe\n"
+        "  NAME=value [lệnh]   Gán biến shell (hoặc env tạm thời cho lệnh)\n"
+        "  $VAR ${VAR} $?      Mở rộng biến; ${#v} ${v:o:n} ${v#p} ${v%%p} ${v/p/r} ${v:-d}\n"
+        "  $(( biểu thức ))    Số học số nguyên 64-bit\n"
+        "\n"
+        "  cell --server <sock>            Chạy shell như server trên UNIX socket\n"
+        "  cell --client <sock> [-C dir] [-e K=V] [-v] -- <lệnh>\n"
     );
     return 0;
 }
 
 int cell_history(char **args) {
     for (int i = 0; i < history_count; i++) {
-        printf("%2d  %s\n", i+1, history[i]);
+        printf("%2d  %s\n", hist_base + i + 1, cell_history_at(i));
     }
     return 0;
 }
@@ -220,6 +352,12 @@ int cell_touch(char **args) {
 Alias alias_table[MAX_ALIAS];
 int alias_count = 0;
 
+// Bảng alias là mảng tĩnh: chỉ tính các ô đang dùng, không có gì trên heap
+void alias_mem(t_memuse *u) {
+    u->objects += alias_count;
+    u->bytes += alias_count * sizeof(Alias);
+}
+
 // Hàm thêm alias
 void add_alias(const char *name, const char *value) {
     if (!name || !value || !*name || !*value) return; // Không thêm alias rỗng
@@ -280,21 +418,24 @@ int cell_alias(char **args) {
         printf("alias: %s: not found\n", args[1]);
     return 0;
 }
-int cell_kill(char **args) {
-    if (!args[1]) {
-        fprintf(stderr, "kill: missing PID\n");
-        return 1;
-    }
-    pid_t pid = atoi(args[1]);
-    int sig = SIGTERM; // hoặc cho phép chọn signal
-    if (args[2]) sig = atoi(args[2]);
-    if (kill(pid, sig) == -1) {
-        perror("kill");
-        return 1;
-    }
-    return 0;
-}
 int cell_jobs(char **args) {
+    if (args[1] && (!strcmp(args[1], "-o") || !strcmp(args[1], "-f"))) {
+        bg_proc *job = find_bg_job(args[2]);
+        if (!job) {
+            fprintf(stderr, "jobs: %s: no such job\n", args[2] ? args[2] : "");
+            return 1;
+        }
+        if (!job->ring) {
+            fprintf(stderr, "jobs: %s: output was not captured\n", args[2]);
+            return 1;
+        }
+        update_bg_status();
+        if (args[1][1] == 'f')
+            capture_follow(job);
+        else
+            capture_print(job->ring, stdout);
+        return 0;
+    }
     print_bg_list();
     return 0;
 }
@@ -305,18 +446,11 @@ int cell_time(char **args) {
         return 1;
     }
 
-    char cmd_line[512] = {0};
-    for (int i = 1; args[i]; i++) {
-        strcat(cmd_line, args[i]);
-        if (args[i + 1]) strcat(cmd_line, " ");
-    }
-
-    char **real_args = cell_split_line(cmd_line);
-
     struct timeval start, end;
     gettimeofday(&start, NULL);
 
-    cell_execute(real_args, 0);  // foreground
+    // các từ đã mở rộng: chạy thẳng, không ghép lại rồi tách lần nữa
+    cell_execute(&args[1], 0);  // foreground
 
     gettimeofday(&end, NULL);
 
@@ -325,10 +459,7 @@ int cell_time(char **args) {
 
     printf("real\t%.3fs\n", elapsed);
 
-    for (int i = 0; real_args[i]; i++) free(real_args[i]);
-    free(real_args);
-
-    return 0;
+    return status;  // mã thoát của lệnh được đo
 }
 
 int cell_dir(char **args) {
@@ -339,21 +470,31 @@ int cell_dir(char **args) {
 
 int cell_stop(char **args) {
     if (!args[1]) {
-        fprintf(stderr, "stop: thiếu PID\n");
+        fprintf(stderr, "stop: thiếu PID hoặc %%N\n");
         return 1;
     }
-    pid_t pid = atoi(args[1]);
-    if (kill(pid, SIGSTOP) == -1) {
+    bg_proc *job = find_bg_job(args[1]);
+    // job: dừng cả nhóm tiến trình (mọi stage của pipeline) cùng lúc
+    if ((job ? job_signal(job, SIGSTOP) : kill(atoi(args[1]), SIGSTOP)) == -1) {
         perror("stop");
         return 1;
     }
-    set_bg_status(pid, STOPPED);  // Cập nhật trạng thái
+    if (job && job->status != DONE)
+        job->status = STOPPED;  // Cập nhật trạng thái
     return 0;
 }
 
 int cell_fg(char **args) {
+    bg_proc *job = args[1] ? find_bg_job(args[1]) : bg_current();
+    if (job && job->status != DONE) {
+        printf("%s\n", job->cmd);
+        // giao terminal cho nhóm, SIGCONT cả nhóm, đợi tới khi xong hoặc Ctrl-Z
+        return job_wait_fg(job, 1);
+    }
+    if (job)
+        return bg_wait(&job, 1, 0, NULL);   // đã xong: trả mã thoát đã lưu
     if (!args[1]) {
-        fprintf(stderr, "fg: thiếu PID\n");
+        fprintf(stderr, "fg: không có job hiện tại\n");
         return 1;
     }
     pid_t pid = atoi(args[1]);
@@ -361,23 +502,70 @@ int cell_fg(char **args) {
         perror("fg");
         return 1;
     }
-    set_bg_status(pid, RUNNING);
     int status;
     Waitpid(pid, &status, 0);  // Đợi foreground hoàn thành
-    return 0;
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
+
+/*
+** Lệnh wait: wait [-n] [-p var] [pid|%job ...]
+** Không có tham số: đợi mọi job đang chạy. -n: trả về ngay khi job đầu
+** tiên kết thúc (job đã xong mà chưa báo được trả về trước), -p ghi pid
+** của job đó vào biến.
+*/
+int cell_wait(char **args) {
+    bg_proc *set[256], *done = NULL;
+    int n = 0, any = 0, i = 1, code = 0;
+    const char *pvar = NULL;
+
+    for (; args[i] && args[i][0] == '-'; i++) {
+        if (!strcmp(args[i], "-n")) any = 1;
+        else if (!strcmp(args[i], "-p") && args[i + 1]) pvar = args[++i];
+        else {
+            fprintf(stderr, "wait: usage: wait [-n] [-p var] [pid|%%job ...]\n");
+            return 2;
+        }
+    }
+    int all = !args[i];
+    update_bg_status();
+    if (all) {
+        for (bg_proc *p = bg_list(); p && n < 256; p = p->next)
+            if (p->status == RUNNING || (any && !p->waited))
+                set[n++] = p;
+    }
+    for (; args[i] && n < 256; i++) {
+        bg_proc *p = find_bg_job(args[i]);
+        if (!p) {
+            fprintf(stderr, "wait: %s: no such job\n", args[i]);
+            code = 127;
+            continue;
+        }
+        set[n++] = p;
+    }
+    if (n == 0)
+        return any ? 127 : code;
+    code = bg_wait(set, n, any, &done);
+    if (pvar && done) {
+        char buf[16];
+        snprintf(buf, sizeof(buf), "%d", (int)done->pid);
+        var_set(pvar, buf);
+    }
+    // wait không tham số luôn thành công như POSIX
+    return all && !any ? 0 : code;
 }
 
 int cell_resume(char **args) {
     if (!args[1]) {
-        fprintf(stderr, "resume: thiếu PID\n");
+        fprintf(stderr, "resume: thiếu PID hoặc %%N\n");
         return 1;
     }
-    pid_t pid = atoi(args[1]);
-    if (kill(pid, SIGCONT) == -1) {
+    bg_proc *job = find_bg_job(args[1]);
+    if ((job ? job_signal(job, SIGCONT) : kill(atoi(args[1]), SIGCONT)) == -1) {
         perror("resume");
         return 1;
     }
-    set_bg_status(pid, RUNNING);
+    if (job && job->status != DONE)
+        job->status = RUNNING;
     return 0;
 }
 
@@ -0,0 +1,255 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include "capture.h"
+#include "processlist.h"
+#include "memacct.h"
+#include "redir.h"
+#include <fcntl.h>
+#include <poll.h>
+#include "lineedit.h"
+
+/*
+** Capture output của job nền vào bộ nhớ
+**
+** Khi bật (`capture on`), job chạy nền bằng `&` ghi stdout/stderr vào một
+** pipe thay vì terminal. Shell đọc pipe đó ở chế độ non-blocking mỗi khi
+** chờ phím (rl_getc_function) và trước mỗi lần cập nhật trạng thái job, và
+** giữ phần cuối output trong ring buffer của job. Xem bằng `jobs -o %N`,
+** theo dõi liên tục bằng `jobs -f %N`.
+*/
+
+int capture_enabled = 0;
+static size_t ring_size = CAPTURE_DEFAULT_RING;
+static int spill_enabled = 0;
+
+t_ring *ring_new(size_t cap) {
+    t_ring *r = Malloc(sizeof(*r));
+    memset(r, 0, sizeof(*r));
+    r->buf = Malloc(cap);
+    r->cap = cap;
+    r->spill_fd = -1;
+    return r;
+}
+
+void ring_free(t_ring *r) {
+    if (!r) return;
+    if (r->spill_fd != -1) {
+        close(r->spill_fd);
+        unlink(r->spill_path);
+    }
+    free(r->buf);
+    free(r);
+}
+
+// Đẩy n byte cũ nhất ra khỏi ring (ghi spill nếu có)
+static void ring_evict(t_ring *r, size_t n) {
+    if (spill_enabled && r->spill_fd == -1) {
+        snprintf(r->spill_path, sizeof(r->spill_path), "/tmp/cell-job.XXXXXX");
+        r->spill_fd = mkstemp(r->spill_path);
+    }
+    while (n > 0) {
+        size_t chunk = r->cap - r->start;
+        if (chunk > n) chunk = n;
+        if (r->spill_fd == -1 || write(r->spill_fd, r->buf + r->start, chunk) != (ssize_t)chunk)
+            r->dropped += chunk;
+        r->start = (r->start + chunk) % r->cap;
+        r->len -= chunk;
+        n -= chunk;
+    }
+}
+
+static void ring_write(t_ring *r, const char *data, size_t n) {
+    r->total += n;
+    if (n > r->cap) {
+        ring_evict(r, r->len);
+        // Phần đầu của data không vừa ring: đi thẳng ra spill
+        size_t skip = n - r->cap;
+        if (r->spill_fd == -1 || write(r->spill_fd, data, skip) != (ssize_t)skip)
+            r->dropped += skip;
+        data += skip;
+        n = r->cap;
+        r->start = 0;
+    }
+    if (r->len + n > r->cap)
+        ring_evict(r, r->len + n - r->cap);
+    size_t end = (r->start + r->len) % r->cap;
+    size_t first = r->cap - end < n ? r->cap - end : n;
+    memcpy(r->buf + end, data, first);
+    memcpy(r->buf, data + first, n - first);
+    r->len += n;
+}
+
+/*
+** Tạo pipe cho job: đầu đọc non-blocking, CLOEXEC để các tiến trình con
+** khác không giữ nó. Pipe được nới rộng tới cỡ ring để job ít bị chặn khi
+** shell đang bận chạy lệnh foreground.
+*/
+int capture_pipe(int fd[2]) {
+    if (pipe(fd) == -1)
+        return -1;
+    fcntl(fd[0], F_SETFL, O_NONBLOCK);
+    fcntl(fd[0], F_SETFD, FD_CLOEXEC);
+    fcntl(fd[0], F_SETPIPE_SZ, (int)ring_size);
+    return 0;
+}
+
+/*
+** Trong tiến trình con của job nền: stderr (và stdout nếu out) vào pipe
+** capture. Chuyển hướng của lệnh (đã làm trong shell) được ưu tiên hơn.
+*/
+void capture_child(int cap[2], int out) {
+    if (cap[1] == -1)
+        return;
+    if (out && !redir_active(STDOUT_FILENO)) dup2(cap[1], STDOUT_FILENO);
+    if (!redir_active(STDERR_FILENO)) dup2(cap[1], STDERR_FILENO);
+    close(cap[0]);
+    close(cap[1]);
+}
+
+// Trong shell, sau khi fork xong mọi tiến trình của job: job giữ đầu đọc
+void capture_attach(struct bg_proc *job, int cap[2]) {
+    if (cap[0] == -1)
+        return;
+    close(cap[1]);
+    job->cap_fd = cap[0];
+    job->ring = capture_ring_new();
+}
+
+/**
+ * capture_drain - Reads everything currently available from a job's pipe
+ * Return: 1 once the writer side is closed (EOF), 0 otherwise
+ */
+int capture_drain(int fd, t_ring *r) {
+    char buf[16384];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n > 0) {
+            ring_write(r, buf, n);
+            continue;
+        }
+        if (n == -1 && errno == EINTR)
+            continue;
+        return n == 0;
+    }
+}
+
+void capture_drain_all(void) {
+    for (bg_proc *p = bg_list(); p; p = p->next) {
+        if (p->cap_fd != -1 && capture_drain(p->cap_fd, p->ring)) {
+            close(p->cap_fd);
+            p->cap_fd = -1;
+        }
+    }
+}
+
+void capture_mem(t_memuse *u) {
+    for (bg_proc *p = bg_list(); p; p = p->next) {
+        if (!p->ring)
+            continue;
+        u->objects++;
+        u->bytes += mem_size(p->ring) + mem_size(p->ring->buf);
+    }
+}
+
+void capture_print(t_ring *r, FILE *out) {
+    fflush(out);
+    if (r->spill_fd != -1) {
+        char buf[65536];
+        ssize_t n;
+        off_t off = 0;
+        while ((n = pread(r->spill_fd, buf, sizeof(buf), off)) > 0) {
+            fwrite(buf, 1, n, out);
+            off += n;
+        }
+    }
+    size_t first = r->cap - r->start < r->len ? r->cap - r->start : r->len;
+    fwrite(r->buf + r->start, 1, first, out);
+    fwrite(r->buf, 1, r->len - first, out);
+    fflush(out);
+    if (r->dropped)
+        fprintf(stderr, "[%llu earlier bytes dropped, enable 'capture spill on' to keep them]\n",
+                r->dropped);
+}
+
+// In n byte mới nhất trong ring
+static void ring_print_tail(t_ring *r, size_t n, FILE *out) {
+    if (n > r->len) n = r->len;
+    size_t pos = (r->start + r->len - n) % r->cap;
+    size_t first = r->cap - pos < n ? r->cap - pos : n;
+    fwrite(r->buf + pos, 1, first, out);
+    fwrite(r->buf, 1, n - first, out);
+    fflush(out);
+}
+
+/**
+ * capture_follow - Prints a job's output as it arrives, like `tail -f`
+ * Stops when the job closes its output or on Ctrl-C.
+ */
+void capture_follow(bg_proc *p) {
+    capture_print(p->ring, stdout);
+    cell_interrupted = 0;
+    while (p->cap_fd != -1 && !cell_interrupted) {
+        struct pollfd pfd = {.fd = p->cap_fd, .events = POLLIN};
+        if (poll(&pfd, 1, 200) <= 0)
+            continue;
+        unsigned long long before = p->ring->total;
+        int eof = capture_drain(p->cap_fd, p->ring);
+        ring_print_tail(p->ring, p->ring->total - before, stdout);
+        if (eof) {
+            close(p->cap_fd);
+            p->cap_fd = -1;
+        }
+    }
+}
+
+/*
+** Hàm đọc phím cho readline: trong lúc chờ người dùng gõ, vẫn rút dữ liệu
+** từ pipe của các job nền để chúng không bị chặn.
+*/
+int capture_getc(FILE *in) {
+    for (;;) {
+        struct pollfd pfds[64];
+        int n = 0;
+        pfds[n++] = (struct pollfd){.fd = fileno(in), .events = POLLIN};
+        for (bg_proc *p = bg_list(); p && n < 63; p = p->next) {
+            if (p->cap_fd != -1)
+                pfds[n++] = (struct pollfd){.fd = p->cap_fd, .events = POLLIN};
+            if (p->timer_fd != -1)
+                pfds[n++] = (struct pollfd){.fd = p->timer_fd, .events = POLLIN};
+        }
+        if (n == 1)
+            return rl_getc(in);
+        if (poll(pfds, n, -1) == -1 && errno != EINTR)
+            return rl_getc(in);
+        capture_drain_all();
+        bg_check_timers();
+        if (pfds[0].revents)
+            return rl_getc(in);
+    }
+}
+
+// Lệnh capture: bật/tắt và cấu hình capture output của job nền
+int cell_capture(char **args) {
+    if (!args[1]) {
+        printf("capture: %s, ring %zu bytes/job, spill %s\n",
+               capture_enabled ? "on" : "off", ring_size, spill_enabled ? "on" : "off");
+        return 0;
+    }
+    if (!strcmp(args[1], "on"))
+        capture_enabled = 1;
+    else if (!strcmp(args[1], "off"))
+        capture_enabled = 0;
+    else if (!strcmp(args[1], "size") && args[2] && atol(args[2]) > 0)
+        ring_size = atol(args[2]);
+    else if (!strcmp(args[1], "spill") && args[2])
+        spill_enabled = !strcmp(args[2], "on");
+    else {
+        fprintf(stderr, "capture: usage: capture [on|off] | size N | spill on|off\n");
+        return 1;
+    }
+    return 0;
+}
+
+t_ring *capture_ring_new(void) {
+    return ring_new(ring_size);
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <stdio.h>
+#include <sys/types.h>
+
+#define CAPTURE_DEFAULT_RING (64 * 1024)
+
+/*
+** Ring buffer giữ output gần nhất của một job nền. Khi đầy, dữ liệu cũ nhất
+** bị đẩy ra: ghi vào file spill trên đĩa nếu bật spill, nếu không thì bỏ.
+*/
+typedef struct s_ring {
+    char *buf;
+    size_t cap;
+    size_t start;
+    size_t len;
+    unsigned long long total;
+    unsigned long long dropped;
+    int spill_fd;
+    char spill_path[64];
+} t_ring;
+
+extern int capture_enabled;
+
+t_ring *ring_new(size_t cap);
+t_ring *capture_ring_new(void);
+void    ring_free(t_ring *r);
+int     capture_pipe(int fd[2]);
+int     capture_drain(int fd, t_ring *r);
+void    capture_drain_all(void);
+void    capture_print(t_ring *r, FILE *out);
+int     capture_getc(FILE *in);
+struct bg_proc;
+void    capture_child(int cap[2], int out);
+void    capture_attach(struct bg_proc *job, int cap[2]);
+void    capture_follow(struct bg_proc *p);
+int     cell_capture(char **args);
@@ -1,52 +1,73 @@
 #include "cell.h"
-#include <readline/readline.h>
-#include <readline/history.h>
+#include "lineedit.h"
+#include "redir.h"
+#include "onchange.h"
+#include "textutil.h"
+#include "memacct.h"
 #include <string.h>
 #include <stdlib.h>
 #include <fcntl.h>
 #include <signal.h>
 #include <unistd.h>
 #include "processlist.h"
+#include "pipeprof.h"
+#include "stats.h"
+#include "launchopts.h"
+#include "vars.h"
+#include "timeout.h"
+#include "jobctl.h"
+#include "coproc.h"
+#include "func.h"
+#include "parse.h"
+#include "cmdtab.h"
+#include "cmdhash.h"
 #define SPACE " \t\r\n"
 /* Global status variable for tracking command execution results */
 int	status = 0;
-static volatile sig_atomic_t child_running = 0; //...
-static pid_t child_pid = -1; //...
+volatile sig_atomic_t cell_interrupted = 0;
 
-t_builtin	g_builtin[] = 
+t_builtin	g_builtin[] =
 {
-	{.builtin_name = "echo", .foo=cell_echo},
-	{.builtin_name = "env", .foo=cell_env},
-	{.builtin_name = "exit", .foo=cell_exit},
-	{.builtin_name = "pwd", .foo=cell_pwd},
-        {.builtin_name = "clear", .foo=cell_clear},
-        {.builtin_name = "help", .foo=cell_help},
-        {.builtin_name = "history", .foo=cell_history},
-        {.builtin_name = "date", .foo=cell_date},
-        {.builtin_name = "whoami", .foo=cell_whoami},
-        {.builtin_name = "uptime", .foo=cell_uptime},
-        {.builtin_name = "touch", .foo=cell_touch},
-        {.builtin_name = "alias", .foo=cell_alias},
-        {.builtin_name = "kill", .foo=cell_kill},
-        { .builtin_name = "jobs", .foo = cell_jobs },
-        { .builtin_name = "list", .foo = cell_jobs },
-        {.builtin_name = "time", .foo = cell_time},
-        {.builtin_name = "dir", .foo = cell_dir},
-        {.builtin_name = "stop", .foo = cell_stop},
-        {.builtin_name = "fg", .foo = cell_fg},
-        {.builtin_name = "resume", .foo = cell_resume},
-        {.builtin_name = "path", .foo = cell_path},
-        {.builtin_name = "addpath", .foo = cell_addpath},
+#define CMD(name, fn, fl, h) { .builtin_name = name, .len = sizeof(name) - 1, .foo = fn, \
+                               .quiet = ((fl) & CMD_QUIET) != 0, .flags = (fl), .help = (h) },
+#define CMD_BG(name, fn, fl, h) { .builtin_name = name, .len = sizeof(name) - 1, .foo_bg = fn, \
+                                  .quiet = ((fl) & CMD_QUIET) != 0, .flags = (fl), .help = (h) },
+#define KEYWORD(name, h) { .builtin_name = name, .len = sizeof(name) - 1, .flags = CMD_KEYWORD, \
+                           .help = (h) },
+#include "cmdtab.def"
+#undef CMD
+#undef CMD_BG
+#undef KEYWORD
 	{.builtin_name = NULL},
 };
 
-const char *builtin_cmds[] = {
-	"echo", "env", "exit", "pwd", "clear", "help", "history", "date", "whoami", "uptime", "touch", "time", "dir", "stop", "fg", "resume", "path", "addpath", NULL
-};
+_Static_assert(CMD_COUNT <= STATS_MAX_BUILTINS, "builtin_calls is indexed by table position");
+
+/*
+** builtin_find - Tra tên lệnh trong bảng băm hoàn hảo sinh từ cmdtab.def:
+** một lần băm và đúng một lần so sánh, tên không có trong bảng (lệnh ngoài)
+** thường dừng ngay ở slot rỗng. Từ khóa của parse.c không phải builtin.
+*/
+const t_builtin *builtin_find(const char *name) {
+    size_t len;
+    uint32_t h = cmd_hash(name, CMD_HASH_SEED, CMD_NAME_MAX, &len);
+    if (len > CMD_NAME_MAX)
+        return NULL;
+    int k = cmd_slot[h & (CMD_HASH_SIZE - 1)];
+    if (!k)
+        return NULL;
+    const t_builtin *b = &g_builtin[k - 1];
+    if (b->len != len || memcmp(b->builtin_name, name, len) || (b->flags & CMD_KEYWORD))
+        return NULL;
+    return b;
+}
 
 void sigint_handler(int signo) { //...
-    if (child_running && child_pid > 0) {
-        kill(child_pid, SIGINT);  // Gửi SIGINT đến tiến trình con
+    cell_interrupted = 1; // vòng lặp của shell cũng dừng theo
+    pid_t pgid = job_fg_pgid();
+    if (pgid > 0) {
+        // shell không giao terminal (chạy từ script): chuyển tiếp cho cả nhóm job
+        killpg(pgid, SIGINT);
     } else {
         write(STDOUT_FILENO, "\n", 1); // Xuống dòng nếu không có tiến trình con
     }
@@ -61,7 +82,7 @@ char *command_generator(const char *text, int state) {
 		len = strlen(text);
 	}
 
-	while ((name = builtin_cmds[list_index++])) {
+	while ((name = g_builtin[list_index++].builtin_name)) {
 		if (strncmp(name, text, len) == 0) {
 			return strdup(name);
 		}
@@ -75,20 +96,35 @@ char **cell_completion(const char *text, int start, int end) {
 	return rl_completion_matches(text, command_generator);
 }
 
+static int prompt_stale = 1;
+
+// Chdir gọi khi thư mục đổi: prompt lấy lại cwd ở lần đọc dòng sau
+void prompt_invalidate(void) {
+    prompt_stale = 1;
+}
+
 char *cell_read_line(void) {
+    static char prompt[BUFSIZ + 64];
+    static int prompt_status = -1;
     char cwd[BUFSIZ];
-    char prompt[BUFSIZ + 64];
     char *line;
 
-    getcwd(cwd, BUFSIZ); // Lấy thư mục hiện tại
-
-    if (status) 
-        snprintf(prompt, sizeof(prompt),
-            ""Y"tinyShell"RST" [%s] (exit=%d) > ", cwd, status);
-    else
-        snprintf(prompt, sizeof(prompt),
-            ""Y"tinyShell"RST" [%s] > ", cwd);
+    // chỉ getcwd và dựng lại prompt khi thư mục hoặc mã thoát thay đổi
+    if (prompt_stale || status != prompt_status) {
+        if (!getcwd(cwd, BUFSIZ)) // Lấy thư mục hiện tại
+            snprintf(cwd, sizeof(cwd), "?");
+        if (status) 
+            snprintf(prompt, sizeof(prompt),
+                ""Y"tinyShell"RST" [%s] (exit=%d) > ", cwd, status);
+        else
+            snprintf(prompt, sizeof(prompt),
+                ""Y"tinyShell"RST" [%s] > ", cwd);
+        prompt_stale = 0;
+        prompt_status = status;
+    }
 
+    jobs_housekeep(); // thu hồi job nền đã xong, chỉ giữ JOBS_DONE_MAX job DONE
+    readbuf_release(); // phần read đọc dư của stdin (file) trả lại cho readline
     line = readline(prompt);
     if (line && *line)
         add_history(line);
@@ -96,69 +132,63 @@ char *cell_read_line(void) {
 }
 
 void cell_launch(char **args, int background) {
-    int in_redirect = -1, out_redirect = -1, append = 0;
-    // Tìm redirect
-    for (int i = 0; args[i]; i++) {
-        if (strcmp(args[i], "<") == 0 && args[i+1]) {
-            in_redirect = i;
-        } else if (strcmp(args[i], ">") == 0 && args[i+1]) {
-            out_redirect = i; append = 0;
-        } else if (strcmp(args[i], ">>") == 0 && args[i+1]) {
-            out_redirect = i; append = 1;
-        }
-    }
-
+    int cap[2] = {-1, -1};
+    if (background && capture_enabled && capture_pipe(cap) == -1)
+        perror("capture");
+    char label[256];
+    job_label(label, sizeof(label), args);
     pid_t pid = Fork();
     if (pid == 0) {
-        signal(SIGINT, SIG_DFL); //...
-        if (in_redirect != -1) {
-            int fd = open(args[in_redirect+1], O_RDONLY);
-            if (fd == -1) { perror("open"); exit(1);}
-            dup2(fd, STDIN_FILENO); close(fd);
-            args[in_redirect] = NULL;
-        }
-        if (out_redirect != -1) {
-            int fd;
-            if (append)
-                fd = open(args[out_redirect+1], O_WRONLY|O_CREAT|O_APPEND, 0644);
-            else
-                fd = open(args[out_redirect+1], O_WRONLY|O_CREAT|O_TRUNC, 0644);
-            if (fd == -1) { perror("open"); exit(1);}
-            dup2(fd, STDOUT_FILENO); close(fd);
-            args[out_redirect] = NULL;
+        job_child(0, !background); // nhóm tiến trình riêng, foreground thì nhận terminal
+        capture_child(cap, 1);
+        if (redir_has(args)) {
+            if (redir_apply(args, 0) == -1)
+                exit(1);
+            args = redir_words(args);
         }
-        Execvp(args[0], args); // chỉ phần trước redirect
+        launch_opts_apply();
+        Execvp(args[0], args);
         perror("execvp"); exit(1);
     } else {
+        job_setpgid(pid, 0);
         if (background) {
-            printf("[Background pid %d]\n", pid);
-            add_bg_proc(pid, args[0]); // hoặc truyền dòng lệnh gốc nếu có
+            bg_proc *job = add_bg_proc(pid, label);
+            printf("[%d] Background pid %d\n", job->id, pid);
+            launch_opts_attach(job);
+            capture_attach(job, cap);
+            if (timeout_active())
+                timeout_attach(job);
+        } else if (timeout_active()) {
+            job_tty_give(pid);
+            status = timeout_wait(&pid, 1, label);
+            job_tty_take();
         } else {
-            child_running = 1; //...
-            child_pid = pid; //...
-            Wait(&status);
-            child_running = 0; //...
-            child_pid = -1; //...
+            // Ctrl-Z: job vào danh sách jobs ở trạng thái Stopped
+            status = job_wait_fg(job_new(pid, &pid, 1, label), 0);
         }
     }
 }
 #define ALIAS_RECUR_LIMIT 10
 
-void cell_execute(char **args, int background) {
+static void run_builtin(const t_builtin *b, char **args, int background) {
+    int i = b - g_builtin;
+    if (i < STATS_MAX_BUILTINS)
+        STAT_INC(builtin_calls[i]);
+    status = b->foo_bg ? b->foo_bg(args, background) : b->foo(args);
+    if (status && !b->quiet)
+        p("%s failed\n", b->builtin_name);
+}
+
+static void execute_simple(char **args, int background) {
     static int alias_depth = 0;
-    int i;
-    const char *curr_builtin;
 
     if (!args || !args[0])
         return;
 
-    if (args[0] && strcmp(args[0], "time") == 0) {
-        cell_time(args);
-        return;
-    }
-
-    if (!strcmp(args[0], "jobs") || !strcmp(args[0], "list")) {
-        print_bg_list();
+    // time, timeout, limit, jobs không bị alias hay hàm che
+    const t_builtin *b = builtin_find(args[0]);
+    if (b && (b->flags & CMD_RESERVED)) {
+        run_builtin(b, args, background);
         return;
     }
 
@@ -169,142 +199,464 @@ void cell_execute(char **args, int background) {
             return;
         }
         alias_depth++;
+        STAT_INC(alias_expansions);
+        // Chỉ tách/mở rộng giá trị alias; tham số đã được mở rộng thì nối nguyên
         char new_cmd[512] = {0};
         snprintf(new_cmd, sizeof(new_cmd), "%s", alias_value);
-        for (int j = 1; args[j]; j++) {
-            strcat(new_cmd, " ");
-            strcat(new_cmd, args[j]);
-        }
-        char **new_args = cell_split_line(new_cmd);
-        cell_execute(new_args, background); // Truyền background cho alias
-        for (int i = 0; new_args[i]; i++) free(new_args[i]);
+        char **raw = cell_split_line(new_cmd);
+        char **head = cell_expand(raw);
+        int nh = 0, na = 0;
+        while (head[nh]) nh++;
+        while (args[na]) na++;
+        char **new_args = Malloc((nh + na + 1) * sizeof(char *));
+        memcpy(new_args, head, nh * sizeof(char *));
+        for (int j = 1; j <= na; j++)
+            new_args[nh + j - 1] = args[j];
+        // giá trị alias có thể là cả pipeline: ll='ls -l | less'
+        cell_run_args(new_args, background);
+        free_args(raw);
+        free_args(head);
         free(new_args);
         alias_depth--;
         return;
     }
-    i = 0;
-    while ((curr_builtin = g_builtin[i].builtin_name)) {
-        if (!strcmp(args[0], curr_builtin)) {
-            if ((status = (g_builtin[i].foo)(args)))
-                p("%s failed\n", curr_builtin);
-            return ;
-        }
-        i++;
+    // Hàm shell đứng trước builtin, như bash
+    t_node *fn = func_find(args[0]);
+    if (fn) {
+        status = func_run(fn, args, background);
+        return;
+    }
+    if (b) {
+        run_builtin(b, args, background);
+        return;
     }
     cell_launch(args, background); // Truyền background xuống launch
 }
 
+/*
+** cell_execute - Chạy một lệnh đơn; chuyển hướng của nó được làm ngay trong
+** shell quanh lệnh (builtin, hàm và lệnh ngoài như nhau) rồi trả fd lại.
+*/
+void cell_execute(char **args, int background) {
+    if (!args || !args[0])
+        return;
+    if (!redir_has(args)) {
+        execute_simple(args, background);
+        return;
+    }
+    char **words = redir_words(args);
+    if (background && words[0] && !builtin_find(words[0])) {
+        // job nền: chuyển hướng làm trong tiến trình con sau fork, để thông
+        // báo [N] pid của shell vẫn ra terminal
+        char **sorted = redir_sorted(args);
+        execute_simple(sorted, background);
+        free(sorted);
+        free(words);
+        return;
+    }
+    // exec chỉ có chuyển hướng: fd ở lại trong shell (exec 3>>log)
+    int keep = words[0] && !strcmp(words[0], "exec") && !words[1];
+    int mark = redir_mark();
+    if (redir_apply(args, !keep) == -1)
+        status = 1;
+    else if (words[0])
+        execute_simple(words, background);
+    else
+        status = 0;
+    if (!keep)
+        redir_undo(mark);
+    free(words);
+}
+
+/*
+** Bỏ qua một từ, kể cả phần trong nháy '...' "...", ký tự thoát \x,
+** $((...)), ${...} và lệnh số học ((...)) (có thể chứa khoảng trắng và
+** toán tử).
+*/
+static char *skip_word(char *p) {
+    if (p[0] == '(' && p[1] == '(') {
+        int depth = 0;
+        for (; *p; p++) {
+            if (*p == '(') depth++;
+            else if (*p == ')' && --depth == 0) return p + 1;
+        }
+        return p;
+    }
+    while (*p && !strchr(SPACE, *p) && !strchr("|<>;&", *p)) {
+        if (*p == '\'' || *p == '"') {
+            char q = *p++;
+            while (*p && *p != q) {
+                if (q == '"' && *p == '\\' && p[1]) p++;
+                p++;
+            }
+            if (*p) p++;
+        } else if (*p == '\\' && p[1]) {
+            p += 2;
+        } else if (*p == '$' && (p[1] == '(' || p[1] == '{')) {
+            char open = p[1], close = open == '(' ? ')' : '}';
+            int depth = 0;
+            for (p++; *p; p++) {
+                if (*p == open) depth++;
+                else if (*p == close && --depth == 0) { p++; break; }
+            }
+        } else {
+            p++;
+        }
+    }
+    return p;
+}
+
+// Độ dài toán tử chuyển hướng tại p: < > >> >| <> >& <& &> &>>
+static int redir_len(const char *p) {
+    if (p[0] == '&' && p[1] == '>')
+        return p[2] == '>' ? 3 : 2;
+    if (p[0] == '>')
+        return p[1] == '>' || p[1] == '&' || p[1] == '|' ? 2 : 1;
+    if (p[0] == '<')
+        return p[1] == '>' || p[1] == '&' ? 2 : 1;
+    return 0;
+}
+
+// Token toán tử chuyển hướng: REDIR_MARK + số fd (nếu có) + toán tử
+static char *redir_token(const char *fd, size_t nfd, const char *op, size_t nop) {
+    char *tok = malloc(nfd + nop + 2);
+    STAT_ADD(split_bytes, nfd + nop + 2);
+    tok[0] = REDIR_MARK;
+    memcpy(tok + 1, fd, nfd);
+    memcpy(tok + 1 + nfd, op, nop);
+    tok[1 + nfd + nop] = '\0';
+    return tok;
+}
+
 char **cell_split_line(char *line) {
     size_t bufsize = BUFSIZ;
     unsigned long position = 0;
+    int dbl = 0;    /* trong [[ ]]: < > là so sánh chuỗi, không phải chuyển hướng */
     char **tokens = malloc(bufsize * sizeof *tokens);
+    STAT_ADD(split_bytes, bufsize * sizeof *tokens);
     if (!tokens) { perror("malloc"); exit(EXIT_FAILURE); }
 
     char *p = line, *start;
     while (*p) {
-        while (*p && strchr(SPACE, *p)) p++;
+        while (*p && *p != '\n' && strchr(SPACE, *p)) p++;
         if (!*p) break;
-        if (*p == '|' || *p == '<' || *p == '>') {
+        if (*p == '#') {
+            // chú thích tới hết dòng
+            while (*p && *p != '\n') p++;
+            continue;
+        }
+        if (!dbl && *p == '&' && p[1] == '>') {
+            // &> / &>>: stdout và stderr cùng vào file
+            int len = redir_len(p);
+            tokens[position++] = redir_token("", 0, p, len);
+            p += len;
+        } else if (*p == '\n' || *p == ';' || *p == '&') {
+            // dấu phân cách lệnh: xuống dòng ; ;; & &&
+            int len = (*p != '\n' && p[1] == *p) ? 2 : 1;
+            tokens[position++] = strndup(p, len);
+            STAT_ADD(split_bytes, len + 1);
+            p += len;
+        } else if ((*p == '<' || *p == '>') && *(p+1) == '(') {
+            // process substitution <(cmd) / >(cmd): giữ nguyên cả cụm làm một token
+            int depth = 0;
+            start = p;
+            for (p++; *p; p++) {
+                if (*p == '(') depth++;
+                else if (*p == ')' && --depth == 0) { p++; break; }
+            }
+            size_t len = p - start;
+            char *tok = malloc(len+1);
+            STAT_ADD(split_bytes, len + 1);
+            strncpy(tok, start, len); tok[len] = 0;
+            tokens[position++] = tok;
+        } else if (!dbl && (*p == '<' || *p == '>')) {
+            int len = redir_len(p);
+            tokens[position++] = redir_token("", 0, p, len);
+            p += len;
+        } else if (*p == '|' && p[1] != '|') {
+            // | và fan-out |+ mang dấu PIPE_MARK
+            const char *op = p[1] == '+' ? FANOUT_OP : PIPE_OP;
+            tokens[position++] = strdup(op);
+            STAT_ADD(split_bytes, strlen(op) + 1);
+            p += strlen(op) - 1;
+        } else if (*p == '|' || *p == '<' || *p == '>') {
             int len = 1;
             if (*p == '>' && *(p+1) == '>') len = 2; // phát hiện >>
+            if (*p == '|' && *(p+1) == '|') len = 2; // ||
             char op[3] = {0};
             strncpy(op, p, len);
             tokens[position++] = strdup(op);
+            STAT_ADD(split_bytes, len + 1);
             p += len;
         } else {
             start = p;
-            while (*p && !strchr(SPACE, *p) && *p != '|' && *p != '<' && *p != '>') p++;
+            p = skip_word(p);
             size_t len = p - start;
-            char *tok = malloc(len+1);
-            strncpy(tok, start, len); tok[len] = 0;
-            tokens[position++] = tok;
+            if (!dbl && (*p == '<' || *p == '>') && p[1] != '('
+                && strspn(start, "0123456789") == len) {
+                // 2>file, 2>&1, 3<>f: số fd dính liền toán tử
+                int olen = redir_len(p);
+                tokens[position++] = redir_token(start, len, p, olen);
+                p += olen;
+            } else {
+                char *tok = malloc(len+1);
+                STAT_ADD(split_bytes, len + 1);
+                strncpy(tok, start, len); tok[len] = 0;
+                tokens[position++] = tok;
+                if (!strcmp(tok, "[[")) dbl = 1;
+                else if (!strcmp(tok, "]]")) dbl = 0;
+            }
         }
         if (position >= bufsize) {
+            STAT_ADD(split_bytes, bufsize * sizeof *tokens); // phần tăng thêm
             bufsize *= 2;
             tokens = realloc(tokens, bufsize * sizeof *tokens);
             if (!tokens) { perror("realloc"); exit(EXIT_FAILURE); }
         }
     }
     tokens[position] = NULL;
+    STAT_ADD(tokens, position);
     return tokens;
 }
+/*
+** Trả các token "|" đã bị thay bằng NULL khi tách stage về chỗ cũ, để
+** người gọi giải phóng được cả mảng args.
+*/
+static void pipe_unsplit(char ***argvs, char **seps, int n) {
+    for (int k = 1; k < n; k++)
+        argvs[k][-1] = seps[k];
+}
+
 void cell_pipe(char **args, int background) {
-    int i = 0;
-    while (args[i] && strcmp(args[i], "|") != 0) i++;
-    if (!args[i]) { 
+    t_stage_prof st[MAX_PIPE_STAGES];
+    char **argvs[MAX_PIPE_STAGES];
+    char *seps[MAX_PIPE_STAGES];
+    int n = 0;
+
+    char label[256];
+    job_label(label, sizeof(label), args);
+    // Tách args thành các stage tại mỗi toán tử "|"
+    memset(st, 0, sizeof(st));
+    argvs[n++] = args;
+    for (int i = 0; args[i]; i++) {
+        if (strcmp(args[i], PIPE_OP) == 0) {
+            if (n == MAX_PIPE_STAGES) {
+                fprintf(stderr, "pipe: too many stages (max %d)\n", MAX_PIPE_STAGES);
+                pipe_unsplit(argvs, seps, n);
+                return;
+            }
+            seps[n] = args[i];
+            args[i] = NULL;
+            argvs[n++] = &args[i+1];
+        }
+    }
+    if (n == 1) {
         cell_launch(args, background); // truyền background!
-        return; 
+        return;
     }
 
-    args[i] = NULL; // tách hai lệnh
-    char **args1 = args;
-    char **args2 = &args[i+1];
-
-    int fd[2];
-    pipe(fd);
-    pid_t pid1 = fork();
-    if (pid1 == 0) {
-        dup2(fd[1], STDOUT_FILENO);
-        close(fd[0]); close(fd[1]);
-        execvp(args1[0], args1);
-        perror("execvp"); exit(1);
-    }
-    pid_t pid2 = fork();
-    if (pid2 == 0) {
-        dup2(fd[0], STDIN_FILENO);
-        close(fd[0]); close(fd[1]);
-        execvp(args2[0], args2);
-        perror("execvp"); exit(1);
+    // Cả pipeline là một job: stage đầu lập nhóm, các stage sau gia nhập
+    int cap[2] = {-1, -1};
+    if (background && capture_enabled && capture_pipe(cap) == -1)
+        perror("capture");
+    int prev_in = -1;
+    pid_t pgid = 0, pids[MAX_PIPE_STAGES];
+    for (int k = 0; k < n; k++) {
+        char **argv = argvs[k];
+        int fd[2] = {-1, -1};
+        if (k < n - 1)
+            pipe(fd);
+        clock_gettime(CLOCK_MONOTONIC, &st[k].start);
+        pid_t pid = Fork();
+        if (pid == 0) {
+            job_child(pgid, !background);
+            if (prev_in != -1) {
+                dup2(prev_in, STDIN_FILENO);
+                close(prev_in);
+            }
+            if (fd[1] != -1) {
+                dup2(fd[1], STDOUT_FILENO);
+                close(fd[0]); close(fd[1]);
+            }
+            // job nền có capture: stdout của stage cuối, stderr của mọi stage
+            capture_child(cap, k == n - 1);
+            // chuyển hướng của stage đè lên pipe: a 2>&1 | b
+            if (redir_has(argv)) {
+                if (redir_apply(argv, 0) == -1)
+                    exit(1);
+                argv = redir_words(argv);
+            }
+            // stage là hàm hoặc builtin: chạy ngay trong tiến trình con này
+            if (argv[0] && (func_find(argv[0]) || builtin_find(argv[0]))) {
+                readbuf_own(STDIN_FILENO);
+                cell_execute(argv, 0);
+                exit(status);
+            }
+            launch_opts_apply();
+            STAT_INC(execs);
+            execvp(argv[0], argv);
+            STAT_INC(exec_failures);
+            perror("execvp"); exit(1);
+        }
+        job_setpgid(pid, pgid);
+        if (!pgid)
+            pgid = pid;
+        pids[k] = st[k].pid = pid;
+        st[k].cmd = argv[0] ? argv[0] : "";
+        if (prev_in != -1) close(prev_in);
+        if (fd[1] != -1) close(fd[1]);
+        prev_in = fd[0];
     }
-    close(fd[0]); close(fd[1]);
+    pipe_unsplit(argvs, seps, n);
+
     if (background) {
-        printf("[Background pipeline pid %d %d]\n", pid1, pid2);
+        bg_proc *job = add_bg_job(pgid, pids, n, label);
+        printf("[%d] Background pipeline pgid %d\n", job->id, pgid);
+        launch_opts_attach(job);
+        capture_attach(job, cap);
+        if (timeout_active())
+            timeout_attach(job);
+    } else if (timeout_active() || pipeprof_enabled) {
+        job_tty_give(pgid);
+        status = timeout_active() ? timeout_wait(pids, n, label) : pipeprof_wait(st, n);
+        job_tty_take();
     } else {
-        int status;
-        waitpid(pid1, &status, 0);
-        waitpid(pid2, &status, 0);
+        status = job_wait_fg(job_new(pgid, pids, n, label), 0);
+    }
+}
+static inline int has_fanout(char **args) {
+    for (int i = 0; args[i]; i++) {
+        if (strcmp(args[i], FANOUT_OP) == 0)
+            return 1;
     }
+    return 0;
 }
 static inline int has_pipe(char **args) {
     for (int i = 0; args[i]; i++) {
-        if (strcmp(args[i], "|") == 0)
+        if (strcmp(args[i], PIPE_OP) == 0)
             return 1;
     }
     return 0;
 }
-int main() {
+/*
+** cell_run_args - Thực thi một dòng đã tách và mở rộng
+*/
+void cell_run_args(char **args, int background) {
+    int subs_mark = procsub_expand(args);
+    const t_builtin *b = args[0] ? builtin_find(args[0]) : NULL;
+    if (b && (b->flags & CMD_LINE)) {
+        // timeout bao cả pipeline phía sau nó
+        run_builtin(b, args, background);
+    } else if (args[0] && has_fanout(args)) {
+        cell_fanout(args, background);
+    } else if (args[0] && has_pipe(args)) {
+        cell_pipe(args, background);
+    } else {
+        // Truyền biến background cho hàm thực thi
+        cell_execute(args, background);
+    }
+    procsub_finish(subs_mark);
+}
+
+/*
+** cell_run_words - Mở rộng và chạy một lệnh đơn (hoặc pipeline lệnh đơn)
+** từ token thô; token thô thuộc về người gọi (cây cú pháp) và không bị sửa.
+*/
+void cell_run_words(char **raw, int background) {
+    // Bỏ nháy, thay $VAR / ${...} / $((...)) trước khi thực thi
+    char **args = cell_expand(raw);
+    if (expand_failed) {
+        // lỗi mở rộng (chia 0, ${...} sai) hủy cả lệnh, như bash
+        free_args(args);
+        status = 1;
+        return;
+    }
+
+    // NAME=value đứng đầu: chỉ gán thì đặt biến shell, có lệnh theo sau
+    // thì là biến môi trường tạm thời của riêng lệnh đó
+    int nassign = 0;
+    while (args[nassign] && is_assignment(args[nassign])) nassign++;
+    char *saved_env[nassign + 1];
+    for (int i = 0; i < nassign; i++) {
+        if (!args[nassign]) {
+            var_assign(args[i]);
+            continue;
+        }
+        char *eq = strchr(args[i], '=');
+        *eq = '\0';
+        const char *old = getenv(args[i]);
+        saved_env[i] = old ? strdup(old) : NULL;
+        setenv(args[i], eq + 1, 1);
+    }
+    if (!args[nassign]) {
+        if (nassign) status = 0;
+        free_args(args);
+        return;
+    }
+    cell_run_args(args + nassign, background);
+    for (int i = 0; i < nassign; i++) {
+        if (saved_env[i]) setenv(args[i], saved_env[i], 1);
+        else unsetenv(args[i]);
+        free(saved_env[i]);
+    }
+    free_args(args);
+}
+
+static void cell_run_tree(t_node *tree, int r) {
+    if (r == PARSE_INCOMPLETE) {
+        fprintf(stderr, "cell: syntax error: unexpected end of input\n");
+        status = 2;
+    } else if (r == PARSE_ERROR) {
+        status = 2;
+    } else {
+        cell_interrupted = 0;
+        exec_node(tree);
+    }
+    free_node(tree);
+}
+
+/*
+** cell_run_line - Phân tích và thực thi một dòng lệnh (dùng chung cho REPL và server)
+*/
+void cell_run_line(char *line) {
+    t_node *tree;
+    uint64_t t0 = stats_now();
+    int r = parse_line(line, &tree);
+    stats_record(STAT_PARSE, t0);
+    cell_run_tree(tree, r);
+}
+
+int main(int argc, char **argv) {
     char *line;
-    char **args;
+
+    stats_init();
+    if (argc == 3 && !strcmp(argv[1], "--server"))
+        return cell_server(argv[2]);
+    if (argc >= 3 && !strcmp(argv[1], "--client"))
+        return cell_client(argv[2], argc - 3, argv + 3);
 
     rl_attempted_completion_function = cell_completion;
+    rl_getc_function = capture_getc;
     signal(SIGINT, sigint_handler); //...
+    jobctl_init();
     while ((line = cell_read_line())) {
-        args = cell_split_line(line);
-
-        // Xử lý background (&)
-        int background = 0;
-        int argc = 0;
-        while (args[argc]) argc++;
-        if (argc > 0 && strcmp(args[argc-1], "&") == 0) {
-            background = 1;
-            free(args[argc-1]);
-            args[argc-1] = NULL;
-        }
-
-        if (args[0] && !strcmp(args[0], "cd")) {
-            if (args[1]) {
-                Chdir(args[1]);
-            } else {
-                fprintf(stderr, "cd: missing operand\n");
-            }
-        } else if (args[0] && has_pipe(args)) {
-            cell_pipe(args, background);
-        } else {
-            // Truyền biến background cho hàm thực thi
-            cell_execute(args, background);
+        t_node *tree;
+        uint64_t t0 = stats_now();
+        int r = parse_line(line, &tree);
+        // if/while/for... chưa đóng: đọc thêm dòng với prompt phụ
+        char *more;
+        while (r == PARSE_INCOMPLETE && (more = readline("> "))) {
+            char *joined = Malloc(strlen(line) + strlen(more) + 2);
+            sprintf(joined, "%s\n%s", line, more);
+            free(line);
+            free(more);
+            line = joined;
+            free_node(tree);
+            t0 = stats_now();
+            r = parse_line(line, &tree);
         }
-        for (int i = 0; args[i]; i++) free(args[i]);
-        free(args);
+        stats_record(STAT_PARSE, t0);
+        cell_run_tree(tree, r);
         free(line);
     }
     return (EXIT_SUCCESS);
@@ -19,6 +19,7 @@
 # include <string.h>
 # include <sys/wait.h>
 # include <sysexits.h>
+# include <signal.h>
 
 /*
 ** ANSI Color codes for terminal output formatting:
@@ -46,6 +47,9 @@
 #define CELL_JR	0
 #define MAX_ALIAS 100
 
+extern volatile sig_atomic_t cell_interrupted; /* đặt bởi SIGINT khi không có lệnh con */
+extern int cell_serving; /* 1 khi đang chạy một request của cell --server */
+
 /*
 ** Status codes for shell operations
 */
@@ -55,14 +59,24 @@ enum{
 };
 
 /*
-** Structure for built-in command handling
+** Structure for built-in command handling (entries come from cmdtab.def)
 ** @builtin_name: Name of the built-in command
+** @len: strlen(builtin_name)
 ** @foo: Function pointer to the command implementation
+** @foo_bg: Implementation that also takes the background flag (timeout, limit)
+** @quiet: Non-zero return is a result (test, [), not a failure to report
+** @flags: CMD_* from cmdtab.h
+** @help: Lines printed by help, NULL when another entry covers this one
 */
 typedef struct s_builtin
 {
     const char *builtin_name;
+	size_t len;
 	int (*foo)(char **av);
+	int (*foo_bg)(char **av, int background);
+	bool quiet;
+	unsigned char flags;
+	const char *help;
 } t_builtin;
 typedef struct {
     char name[64];
@@ -71,16 +85,22 @@ typedef struct {
 
 extern Alias alias_table[MAX_ALIAS];
 extern int alias_count;
+extern t_builtin g_builtin[];
+const t_builtin *builtin_find(const char *name); /* NULL: không phải builtin */
+const char *get_alias(const char *name);
 /*
 ** Built-in command function prototypes
 ** Each returns 0 on success, non-zero on failure
 */
 int		cell_echo(char **args);  /* Echo command implementation */
+int     cell_cd(char **args);    /* Đổi thư mục */
 int		cell_env(char **args);   /* Environment variables display*/
 int     cell_pwd(char **args);     /* In thư mục hiện tại */
 int     cell_clear(char **args);   /* Xóa màn hình */
 int     cell_help(char **args);  //lenh help
 int     cell_history(char **args); //lenh xem lich su
+const char *cell_history_at(int i); /* dòng lịch sử thứ i, 0 = cũ nhất còn giữ */
+extern int history_count;
 int     cell_date(char **args); // lenh xem ngay
 int     cell_whoami(char **args); // lenh xem nguoi dung
 int     cell_uptime(char **args); //lenh xem tg may chay
@@ -94,8 +114,14 @@ int     cell_dir(char **args); // lệnh liệt kê thư mục
 int     cell_stop(char **args);    // dừng tiến trình
 int     cell_fg(char **args);      // đưa tiến trình về foreground
 int     cell_resume(char **args);  // tiếp tục tiến trình nền
+int     cell_wait(char **args);    // đợi job nền (pidfd + poll)
 int     cell_path(char **args);     // xem biến PATH
 int     cell_addpath(char **args);  // thêm thư mục vào PATH
+int     cell_memo(char **args);     // cache output của lệnh tất định
+int     cell_ulimit(char **args);   // giới hạn tài nguyên của shell
+int     cell_bench(char **args);    // đo hiệu năng lệnh nhiều lần
+int     cell_test(char **args);     // test / [
+int     cell_dbracket(char **args); // [[ ]]
 
 void 	dbzSpinnerLoading();  /* Animated loading spinner */
 void	printbanner(void);    /* Shell banner display */
@@ -104,7 +130,8 @@ void	printbanner(void);    /* Shell banner display */
 ** System call wrappers with error handling
 ** Each wrapper checks for errors and handles them appropriately
 */
-void	Chdir(const char *path);      /* Change directory */
+int	Chdir(const char *path);      /* Change directory */
+void	prompt_invalidate(void);       /* cwd changed, rebuild prompt */
 pid_t	Fork(void);                   /* Process creation */
 void	Execvp(const char *file, char *const argv[]); /* Execute program */
 pid_t	Wait(int *status);
@@ -113,6 +140,25 @@ void	*Malloc(size_t size);         /* Memory allocation */
 void	*Realloc(void *ptr, size_t size); /* Memory reallocation */
 char	*Getcwd(char *buf, size_t size); /* Get current directory */
 void	Getline(char **lineptr, size_t *n, FILE *stream); /* Read line */
+/*
+** Tokenizer đánh dấu toán tử pipe | và fan-out |+ bằng PIPE_MARK ở đầu token
+** (như REDIR_MARK của chuyển hướng): '|' trong nháy hay trong giá trị biến
+** là chữ thường, chỉ token có dấu mới tách pipeline.
+*/
+#define PIPE_MARK '\002'
+#define PIPE_OP   "\002|"
+#define FANOUT_OP "\002|+"
+
 char  **cell_split_line(char *line);
 void cell_pipe(char **args, int background);
+void cell_execute(char **args, int background);
+void cell_launch(char **args, int background); /* lệnh ngoài: fork + exec */
+void cell_fanout(char **args, int background); /* producer |+ c1 |+ c2 */
+int  procsub_expand(char **args);  /* <(cmd) / >(cmd) -> /dev/fd/N */
+void procsub_finish(int mark);
+void cell_run_line(char *line);
+void cell_run_args(char **args, int background); /* dòng đã tách và mở rộng */
+void cell_run_words(char **raw, int background); /* token thô: mở rộng rồi chạy */
+int  cell_server(const char *path);   /* cell --server <socket> */
+int  cell_client(const char *path, int ac, char **av);
 #endif
@@ -0,0 +1,80 @@
+#include "cmdtab.h"
+#include <stdio.h>
+#include <string.h>
+
+/*
+** cmdgen - chạy lúc build, in cmdhash.h ra stdout.
+**
+** Tìm seed để cmd_hash & (size - 1) không va chạm trên mọi tên trong
+** cmdtab.def, bắt đầu với size là lũy thừa 2 >= 2 * số lệnh và gấp đôi khi
+** không tìm được. Tên trùng trong bảng là lỗi build.
+*/
+
+#define CMDGEN_MAX_SIZE 4096
+#define CMDGEN_TRIES 1000000
+
+#define CMD(name, fn, flags, help) name,
+#define CMD_BG(name, fn, flags, help) name,
+#define KEYWORD(name, help) name,
+static const char *names[] = {
+#include "cmdtab.def"
+};
+#undef CMD
+#undef CMD_BG
+#undef KEYWORD
+
+#define NCMD ((int)(sizeof(names) / sizeof(names[0])))
+
+static unsigned char slot[CMDGEN_MAX_SIZE];
+
+static int try_seed(uint32_t seed, uint32_t size) {
+    size_t len;
+    memset(slot, 0, size);
+    for (int i = 0; i < NCMD; i++) {
+        uint32_t h = cmd_hash(names[i], seed, SIZE_MAX, &len) & (size - 1);
+        if (slot[h])
+            return 0;
+        slot[h] = i + 1;
+    }
+    return 1;
+}
+
+int main(void) {
+    size_t maxlen = 0, len;
+    uint32_t size = 1;
+
+    if (NCMD > 255) {
+        fprintf(stderr, "cmdgen: too many commands (%d) for an 8-bit slot table\n", NCMD);
+        return 1;
+    }
+    for (int i = 0; i < NCMD; i++) {
+        for (int j = 0; j < i; j++)
+            if (!strcmp(names[i], names[j])) {
+                fprintf(stderr, "cmdgen: duplicate command `%s' in cmdtab.def\n", names[i]);
+                return 1;
+            }
+        cmd_hash(names[i], 0, SIZE_MAX, &len);
+        if (len > maxlen)
+            maxlen = len;
+    }
+    while (size < 2u * NCMD)
+        size <<= 1;
+    for (; size <= CMDGEN_MAX_SIZE; size <<= 1) {
+        for (uint32_t seed = 1; seed <= CMDGEN_TRIES; seed++) {
+            if (!try_seed(seed, size))
+                continue;
+            printf("/* Sinh bởi cmdgen từ cmdtab.def lúc build, đừng sửa tay */\n");
+            printf("#define CMD_COUNT %d\n", NCMD);
+            printf("#define CMD_NAME_MAX %zu\n", maxlen);
+            printf("#define CMD_HASH_SEED %#xu\n", seed);
+            printf("#define CMD_HASH_SIZE %u\n\n", size);
+            printf("static const unsigned char cmd_slot[CMD_HASH_SIZE] = {");
+            for (uint32_t k = 0; k < size; k++)
+                printf("%s%d,", k % 16 ? " " : "\n    ", slot[k]);
+            printf("\n};\n");
+            return 0;
+        }
+    }
+    fprintf(stderr, "cmdgen: no collision-free seed up to %d slots\n", CMDGEN_MAX_SIZE);
+    return 1;
+}
@@ -0,0 +1,31 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+** Bảng lệnh của shell. cmdtab.def là nguồn duy nhất: g_builtin (dispatch),
+** help và hoàn thành lệnh đều sinh từ nó. Lúc build, cmdgen tìm một seed
+** để cmd_hash không có va chạm trên các tên trong bảng và ghi ra cmdhash.h
+** (bảng slot -> chỉ số lệnh). Tra một tên là băm một lần, so độ dài rồi
+** so byte với đúng một ứng viên; tên dài hơn CMD_NAME_MAX không cần băm.
+*/
+
+#define CMD_QUIET    0x01   /* mã khác 0 là kết quả, không in "X failed" */
+#define CMD_RESERVED 0x02   /* tra trước alias và hàm: time, timeout, limit, jobs */
+#define CMD_LINE     0x04   /* nhận cả dòng kể cả pipe: timeout bọc pipeline */
+#define CMD_KEYWORD  0x08   /* từ khóa của parse.c: chỉ có trong help và hoàn thành */
+
+// FNV-1a có seed; dừng sớm (*len = max + 1) khi tên dài hơn max
+static inline uint32_t cmd_hash(const char *s, uint32_t seed, size_t max, size_t *len) {
+    uint32_t h = 2166136261u ^ seed;
+    const char *p = s;
+    for (; *p; p++) {
+        if ((size_t)(p - s) == max) {
+            *len = max + 1;
+            return 0;
+        }
+        h = (h ^ (unsigned char)*p) * 16777619u;
+    }
+    *len = p - s;
+    return h ^ (h >> 15);
+}
@@ -0,0 +1,154 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include "coproc.h"
+#include "jobctl.h"
+#include "launchopts.h"
+#include "vars.h"
+#include <fcntl.h>
+
+/*
+** Hai pipe mở với O_CLOEXEC: chỉ shell giữ đầu bên này, lệnh ngoài chạy sau
+** không thừa kế nên khi shell đóng NAME[1] thì coproc thấy EOF. Shell nói
+** chuyện với coproc bằng echo -u / read -u trên các fd đó.
+*/
+
+typedef struct s_coproc {
+    char name[64];
+    pid_t pid;
+    int rfd;        /* output của coproc, -1 nếu đã đóng */
+    int wfd;        /* stdin của coproc, -1 nếu đã đóng */
+} t_coproc;
+
+static t_coproc coprocs[COPROC_MAX];
+
+static t_coproc *coproc_find(const char *name) {
+    for (int i = 0; i < COPROC_MAX; i++)
+        if (coprocs[i].pid && !strcmp(coprocs[i].name, name))
+            return &coprocs[i];
+    return NULL;
+}
+
+static int coproc_running(t_coproc *c) {
+    update_bg_status();
+    bg_proc *job = find_bg_proc(c->pid);
+    return job && job->status != DONE;
+}
+
+static void coproc_set_vars(t_coproc *c) {
+    char buf[16], pidvar[80];
+    var_unset(c->name);
+    snprintf(buf, sizeof(buf), "%d", c->rfd);
+    var_set_elem(c->name, 0, buf);
+    snprintf(buf, sizeof(buf), "%d", c->wfd);
+    var_set_elem(c->name, 1, buf);
+    snprintf(pidvar, sizeof(pidvar), "%s_PID", c->name);
+    snprintf(buf, sizeof(buf), "%d", (int)c->pid);
+    var_set(pidvar, buf);
+}
+
+static void coproc_forget(t_coproc *c) {
+    char pidvar[80];
+    if (c->rfd != -1) readbuf_close(c->rfd);
+    if (c->wfd != -1) close(c->wfd);
+    var_unset(c->name);
+    snprintf(pidvar, sizeof(pidvar), "%s_PID", c->name);
+    var_unset(pidvar);
+    memset(c, 0, sizeof(*c));
+}
+
+// `coproc NAME cmd`: NAME là tên biến nếu nó không phải lệnh có trong PATH
+static int is_command(const char *word) {
+    const char *path = getenv("PATH");
+    char file[1024];
+
+    if (strchr(word, '/'))
+        return 1;
+    while (path && *path) {
+        size_t len = strcspn(path, ":");
+        snprintf(file, sizeof(file), "%.*s/%s", (int)len, len ? path : ".", word);
+        if (!access(file, X_OK))
+            return 1;
+        path += len + (path[len] == ':');
+    }
+    return 0;
+}
+
+/**
+ * cell_coproc - Starts a helper process connected by two pipes
+ * @args: coproc [NAME] cmd...   or   coproc -c NAME (close its input)
+ * Return: 0 on success, 1 on failure, 2 on bad usage
+ */
+int cell_coproc(char **args) {
+    const char *name = "COPROC";
+    char **cmd = &args[1];
+    t_coproc *c;
+
+    if (args[1] && !strcmp(args[1], "-c")) {
+        // đóng stdin của coproc (gửi EOF); đầu đọc giữ lại để lấy nốt output
+        if (!args[2] || !(c = coproc_find(args[2]))) {
+            fprintf(stderr, "coproc: %s: no such coprocess\n", args[2] ? args[2] : "");
+            return 1;
+        }
+        if (c->wfd != -1) close(c->wfd);
+        c->wfd = -1;
+        coproc_set_vars(c);
+        return 0;
+    }
+    if (args[1] && args[2] && var_valid_name(args[1], strlen(args[1])) && !is_command(args[1])) {
+        name = args[1];
+        cmd = &args[2];
+    }
+    if (!cmd[0]) {
+        fprintf(stderr, "coproc: usage: coproc [NAME] cmd... | coproc -c NAME\n");
+        return 2;
+    }
+    if ((c = coproc_find(name))) {
+        if (coproc_running(c)) {
+            fprintf(stderr, "coproc: %s: still running (pid %d)\n", name, (int)c->pid);
+            return 1;
+        }
+        coproc_forget(c);
+    }
+    for (c = coprocs; c < coprocs + COPROC_MAX && c->pid; c++)
+        ;
+    if (c == coprocs + COPROC_MAX) {
+        fprintf(stderr, "coproc: too many coprocesses (max %d)\n", COPROC_MAX);
+        return 1;
+    }
+
+    int to[2], from[2];
+    if (pipe2(to, O_CLOEXEC) == -1) {
+        perror("coproc: pipe");
+        return 1;
+    }
+    if (pipe2(from, O_CLOEXEC) == -1) {
+        perror("coproc: pipe");
+        close(to[0]);
+        close(to[1]);
+        return 1;
+    }
+    char label[256];
+    job_label(label, sizeof(label), cmd);
+    pid_t pid = Fork();
+    if (pid == 0) {
+        job_child(0, 0);
+        dup2(to[0], STDIN_FILENO);
+        dup2(from[1], STDOUT_FILENO);
+        readbuf_own(STDIN_FILENO);
+        launch_opts_apply();
+        Execvp(cmd[0], cmd);
+    }
+    job_setpgid(pid, 0);
+    close(to[0]);
+    close(from[1]);
+
+    snprintf(c->name, sizeof(c->name), "%s", name);
+    c->pid = pid;
+    c->rfd = from[0];
+    c->wfd = to[1];
+    coproc_set_vars(c);
+    bg_proc *job = add_bg_proc(pid, label);
+    launch_opts_attach(job);
+    printf("[%d] coproc %s pid %d (fds %d %d)\n", job->id, name, pid, c->rfd, c->wfd);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+/*
+** coproc [NAME] cmd...: tiến trình trợ giúp sống lâu (bc, awk, jq...) nối với
+** shell bằng hai pipe. NAME[0] là fd đọc output của nó, NAME[1] là fd ghi
+** vào stdin của nó, NAME_PID là pid; job nằm trong danh sách jobs.
+*/
+#define COPROC_MAX 16
+
+int cell_coproc(char **args);
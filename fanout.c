@@ -0,0 +1,317 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/ioctl.h>
+#include "processlist.h"
+#include "jobctl.h"
+#include "launchopts.h"
+#include "timeout.h"
+
+/*
+** Fan-out: `producer |+ consumer1 |+ consumer2 ...`
+**
+** Output của producer được nhân bản trong kernel: shell tee(2) dữ liệu từ
+** pipe của producer sang pipe của từng consumer, rồi splice(2) phần đó sang
+** consumer cuối (vừa sao chép vừa tiêu thụ). Chỉ khi một consumer nhận thiếu
+** (pipe của nó đầy) thì phần còn lại mới được ghi qua user space, và việc ghi
+** chặn đó tạo backpressure lên producer thay vì đệm vô hạn. Consumer nào làm
+** nghẽn luồng quá FANOUT_STALL_WARN_MS sẽ được báo ra stderr.
+**
+** Cả fan-out là một job: producer lập nhóm tiến trình, các consumer và tiến
+** trình sao chép (chạy vòng tee/splice) gia nhập nhóm đó, nên Ctrl-C/Ctrl-Z,
+** fg/bg/stop/kill tác động lên tất cả như với pipeline thường.
+*/
+
+#define MAX_FANOUT 16
+#define FANOUT_CHUNK (1 << 16)
+#define FANOUT_STALL_WARN_MS 500
+
+extern int status;
+
+typedef struct s_consumer {
+    char **argv;
+    char *sep;          /* token "|+" bị thay bằng NULL trước argv */
+    pid_t pid;
+    int fd;             /* đầu ghi của pipe stdin consumer, -1 nếu đã đóng */
+    int rfd;            /* đầu đọc của pipe đó, tới khi consumer được tạo */
+    long long stall_us;
+    int warned;
+} t_consumer;
+
+static long long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000LL + ts.tv_nsec / 1000;
+}
+
+static int has_pipe_token(char **args) {
+    for (int i = 0; args[i]; i++)
+        if (!strcmp(args[i], PIPE_OP))
+            return 1;
+    return 0;
+}
+
+/*
+** Chạy một đoạn (lệnh đơn hoặc pipeline) với stdin/stdout cho trước, trong
+** nhóm pgid của job (0 = lập nhóm mới). Job nền có capture thì output không
+** đi vào pipe (của consumer) và stderr được gom vào cap. Tiến trình con phải đóng pipe của
+** các consumer khác, nếu không chúng sẽ không bao giờ thấy EOF.
+*/
+static pid_t spawn_segment(char **argv, int in_fd, int out_fd, int close_fd,
+                           t_consumer *cs, int n, pid_t pgid, int foreground, int cap[2]) {
+    fflush(stdout);
+    pid_t pid = Fork();
+    if (pid == 0) {
+        job_child(pgid, foreground);
+        signal(SIGPIPE, SIG_DFL);
+        if (in_fd != -1) { dup2(in_fd, STDIN_FILENO); close(in_fd); }
+        if (out_fd != -1) { dup2(out_fd, STDOUT_FILENO); close(out_fd); }
+        if (close_fd != -1) close(close_fd);
+        capture_child(cap, out_fd == -1);
+        for (int i = 0; i < n; i++) {
+            if (cs[i].fd != -1) close(cs[i].fd);
+            if (cs[i].rfd != -1) close(cs[i].rfd);
+        }
+        if (has_pipe_token(argv))
+            cell_pipe(argv, 0);
+        else
+            cell_execute(argv, 0);
+        fflush(stdout);
+        exit(status);
+    }
+    job_setpgid(pid, pgid);
+    return pid;
+}
+
+/*
+** Trả các token "|+" về chỗ cũ để người gọi giải phóng được cả mảng args.
+*/
+static void fanout_unsplit(t_consumer *cs, int n) {
+    for (int i = 0; i < n; i++)
+        cs[i].argv[-1] = cs[i].sep;
+}
+
+static void drop_consumer(t_consumer *c) {
+    if (c->fd != -1)
+        close(c->fd);
+    c->fd = -1;
+    if (c->rfd != -1)
+        close(c->rfd);
+    c->rfd = -1;
+}
+
+static void note_stall(t_consumer *c, int idx, long long t0) {
+    c->stall_us += now_us() - t0;
+    if (!c->warned && c->stall_us > FANOUT_STALL_WARN_MS * 1000LL) {
+        c->warned = 1;
+        fprintf(stderr, "fan-out: consumer #%d (%s) is slow, throttling the producer\n",
+                idx + 1, c->argv[0]);
+    }
+}
+
+/*
+** Ghi chặn phần dữ liệu còn thiếu cho một consumer, tính thời gian bị chặn.
+*/
+static void write_rest(t_consumer *c, int idx, const char *buf, size_t len) {
+    long long t0 = now_us();
+    while (len > 0 && c->fd != -1) {
+        ssize_t n = write(c->fd, buf, len);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            drop_consumer(c); // EPIPE: consumer đã thoát
+            break;
+        }
+        buf += n;
+        len -= n;
+    }
+    note_stall(c, idx, t0);
+}
+
+static int splice_all(t_consumer *c, int idx, int src, size_t len, char *buf) {
+    long long t0 = now_us();
+    while (len > 0) {
+        ssize_t n = splice(src, NULL, c->fd, NULL, len, SPLICE_F_MOVE);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) {
+            // Consumer cuối đã đóng: vẫn phải tiêu thụ dữ liệu khỏi pipe nguồn
+            note_stall(c, idx, t0);
+            drop_consumer(c);
+            ssize_t r = read(src, buf, len);
+            return r > 0 ? 0 : -1;
+        }
+        len -= n;
+    }
+    note_stall(c, idx, t0);
+    return 0;
+}
+
+/*
+** Vòng lặp nhân bản: src là đầu đọc pipe của producer.
+*/
+static void fanout_loop(int src, t_consumer *cs, int n) {
+    char *buf = Malloc(FANOUT_CHUNK);
+    size_t k[MAX_FANOUT];
+
+    for (;;) {
+        struct pollfd pfd = {.fd = src, .events = POLLIN};
+        int avail = 0;
+        if (poll(&pfd, 1, -1) == -1) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (ioctl(src, FIONREAD, &avail) == -1 || avail <= 0)
+            break; // producer đã đóng pipe
+        if (avail > FANOUT_CHUNK)
+            avail = FANOUT_CHUNK;
+
+        // Consumer còn sống cuối cùng là "sink": nhận dữ liệu bằng splice
+        int sink = -1;
+        for (int i = 0; i < n; i++)
+            if (cs[i].fd != -1) sink = i;
+        if (sink == -1)
+            break;
+
+        int all_full = 1;
+        for (int i = 0; i < sink; i++) {
+            k[i] = 0;
+            if (cs[i].fd == -1) continue;
+            ssize_t r = tee(src, cs[i].fd, avail, SPLICE_F_NONBLOCK);
+            if (r > 0)
+                k[i] = r;
+            else if (r == -1 && errno == EPIPE)
+                drop_consumer(&cs[i]);
+            if (cs[i].fd != -1 && k[i] < (size_t)avail)
+                all_full = 0;
+        }
+        if (all_full) {
+            if (splice_all(&cs[sink], sink, src, avail, buf) == -1)
+                break;
+            continue;
+        }
+        // Có consumer nhận thiếu: lấy chunk ra user space và ghi bù
+        ssize_t m = read(src, buf, avail);
+        if (m <= 0)
+            break;
+        for (int i = 0; i < sink; i++)
+            if (cs[i].fd != -1 && k[i] < (size_t)m)
+                write_rest(&cs[i], i, buf + k[i], m - k[i]);
+        write_rest(&cs[sink], sink, buf, m);
+    }
+    free(buf);
+    for (int i = 0; i < n; i++)
+        drop_consumer(&cs[i]);
+}
+
+/**
+ * cell_fanout - Runs `producer |+ c1 |+ c2 ...`
+ * @args: Tokens containing one or more "|+" separators
+ * @background: Run the whole fan-out in the background
+ */
+void cell_fanout(char **args, int background) {
+    t_consumer cs[MAX_FANOUT];
+    char **producer = args;
+    char label[256];
+    int n = 0;
+
+    job_label(label, sizeof(label), args);
+    memset(cs, 0, sizeof(cs));
+    for (int i = 0; args[i]; i++) {
+        if (strcmp(args[i], FANOUT_OP)) continue;
+        if (n == MAX_FANOUT) {
+            fprintf(stderr, "fan-out: too many consumers (max %d)\n", MAX_FANOUT);
+            fanout_unsplit(cs, n);
+            return;
+        }
+        cs[n].sep = args[i];
+        args[i] = NULL;
+        cs[n++].argv = &args[i + 1];
+    }
+    int bad = !producer[0] || n == 0;
+    for (int i = 0; i < n; i++)
+        if (!cs[i].argv[0])
+            bad = 1;
+    if (bad) {
+        fprintf(stderr, "fan-out: syntax error near |+\n");
+        fanout_unsplit(cs, n);
+        return;
+    }
+
+    // producer lập nhóm, consumer và tiến trình sao chép gia nhập; trong
+    // danh sách job consumer cuối đứng cuối nên mã thoát của job là của nó
+    int src[2] = {-1, -1}, cap[2] = {-1, -1};
+    pid_t pids[MAX_FANOUT + 2];
+    int np = 0, fg = !background;
+    // tạo đủ pipe trước khi fork: hết fd thì chưa có tiến trình nào phải dọn
+    for (int i = 0; i < n; i++)
+        cs[i].fd = cs[i].rfd = -1;
+    int ok = pipe2(src, O_CLOEXEC) == 0;
+    for (int i = 0; ok && i < n; i++) {
+        int fd[2];
+        ok = pipe2(fd, O_CLOEXEC) == 0;
+        if (ok) {
+            cs[i].rfd = fd[0];
+            cs[i].fd = fd[1];
+        }
+    }
+    if (!ok) {
+        perror("fan-out");
+        if (src[0] != -1) {
+            close(src[0]);
+            close(src[1]);
+        }
+        for (int i = 0; i < n; i++)
+            drop_consumer(&cs[i]);
+        fanout_unsplit(cs, n);
+        status = 1;
+        return;
+    }
+    if (background && capture_enabled && capture_pipe(cap) == -1)
+        perror("capture");
+    pid_t pgid = spawn_segment(producer, -1, src[1], src[0], cs, n, 0, fg, cap);
+    pids[np++] = pgid;
+    close(src[1]);
+    for (int i = 0; i < n; i++) {
+        int in = cs[i].rfd;
+        cs[i].rfd = -1;     /* con dup nó thành stdin, không đóng lần nữa */
+        cs[i].pid = spawn_segment(cs[i].argv, in, -1, src[0], cs, n, pgid, fg, cap);
+        close(in);
+    }
+    pid_t copier = Fork();
+    if (copier == 0) {
+        job_child(pgid, fg);
+        signal(SIGPIPE, SIG_IGN);
+        capture_child(cap, 0);
+        fanout_loop(src[0], cs, n);
+        for (int i = 0; i < n; i++)
+            if (cs[i].warned)
+                fprintf(stderr, "fan-out: consumer #%d (%s) stalled the stream for %.3fs\n",
+                        i + 1, cs[i].argv[0], cs[i].stall_us / 1e6);
+        exit(0);
+    }
+    job_setpgid(copier, pgid);
+    close(src[0]);
+    pids[np++] = copier;
+    for (int i = 0; i < n; i++) {
+        drop_consumer(&cs[i]);
+        pids[np++] = cs[i].pid;
+    }
+    fanout_unsplit(cs, n);
+
+    if (background) {
+        bg_proc *job = add_bg_job(pgid, pids, np, label);
+        printf("[%d] Background fan-out pgid %d\n", job->id, pgid);
+        launch_opts_attach(job);
+        capture_attach(job, cap);
+        if (timeout_active())
+            timeout_attach(job);
+    } else if (timeout_active()) {
+        job_tty_give(pgid);
+        status = timeout_wait(pids, np, label);
+        job_tty_take();
+    } else {
+        status = job_wait_fg(job_new(pgid, pids, np, label), 0);
+    }
+}
@@ -0,0 +1,175 @@
+#include "cell.h"
+#include "func.h"
+#include "vars.h"
+#include "jobctl.h"
+#include "redir.h"
+#include "memacct.h"
+
+extern int status;
+
+typedef struct s_func {
+    char *name;
+    t_node *body;
+    struct s_func *next;
+} t_func;
+
+static t_func *funcs[FUNC_BUCKETS];
+static int func_depth = 0;
+static int func_ret = 0;        /* `return` đang tháo các lệnh còn lại của hàm */
+
+static unsigned func_hash(const char *s) {
+    unsigned h = 2166136261u;
+    while (*s)
+        h = (h ^ (unsigned char)*s++) * 16777619u;
+    return h % FUNC_BUCKETS;
+}
+
+static t_func *func_lookup(const char *name) {
+    for (t_func *f = funcs[func_hash(name)]; f; f = f->next)
+        if (!strcmp(f->name, name))
+            return f;
+    return NULL;
+}
+
+/*
+** func_define - Lưu thân hàm vào bảng; cây của dòng lệnh sẽ bị giải phóng
+** nên thân hàm được giữ thêm một tham chiếu. Định nghĩa lại thì bỏ thân cũ.
+*/
+void func_define(const char *name, t_node *body) {
+    t_func *f = func_lookup(name);
+    if (!f) {
+        unsigned h = func_hash(name);
+        f = Malloc(sizeof(*f));
+        f->name = strdup(name);
+        f->body = NULL;
+        f->next = funcs[h];
+        funcs[h] = f;
+    }
+    body->refs++;
+    free_node(f->body);
+    f->body = body;
+}
+
+t_node *func_find(const char *name) {
+    t_func *f = func_lookup(name);
+    return f ? f->body : NULL;
+}
+
+int func_unset(const char *name) {
+    for (t_func **pp = &funcs[func_hash(name)]; *pp; pp = &(*pp)->next) {
+        if (!strcmp((*pp)->name, name)) {
+            t_func *f = *pp;
+            *pp = f->next;
+            free_node(f->body);
+            free(f->name);
+            free(f);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void func_mem(t_memuse *u) {
+    for (int h = 0; h < FUNC_BUCKETS; h++) {
+        for (t_func *f = funcs[h]; f; f = f->next) {
+            u->objects++;
+            u->bytes += mem_size(f) + mem_size(f->name) + node_bytes(f->body);
+        }
+    }
+}
+
+bool func_returning(void) {
+    return func_ret;
+}
+
+static int func_call(t_node *body, char **args) {
+    t_posargs saved;
+    int rc;
+
+    if (func_depth >= FUNC_MAX_DEPTH) {
+        fprintf(stderr, "cell: %s: maximum function nesting level exceeded (%d)\n",
+                args[0], FUNC_MAX_DEPTH);
+        return status = 1;
+    }
+    // thân hàm có thể tự định nghĩa lại chính nó khi đang chạy
+    body->refs++;
+    var_args_push(args + 1, &saved);
+    var_scope_push();
+    func_depth++;
+    rc = exec_func_body(body);
+    func_depth--;
+    func_ret = 0;
+    var_scope_pop();
+    var_args_pop(&saved);
+    free_node(body);
+    return status = rc;
+}
+
+/**
+ * func_run - Calls a shell function in the shell process
+ * @body: Parsed body from func_find
+ * @args: args[0] is the function name, the rest become $1..$n
+ * @background: Run the call in a forked child registered as a job
+ * Return: Exit status of the last command run, or the `return` value
+ */
+int func_run(t_node *body, char **args, int background) {
+    if (!background)
+        return func_call(body, args);
+    pid_t pid = Fork();
+    if (pid == 0) {
+        job_child(0, 0);
+        if (redir_has(args)) {
+            if (redir_apply(args, 0) == -1)
+                exit(1);
+            args = redir_words(args);
+        }
+        exit(func_call(body, args));
+    }
+    job_setpgid(pid, 0);
+    bg_proc *job = add_bg_proc(pid, args[0]);
+    printf("[%d] Background pid %d\n", job->id, pid);
+    return status = 0;
+}
+
+// Lệnh return [n]: thoát hàm với mã n (mặc định mã của lệnh cuối)
+int cell_return(char **args) {
+    if (func_depth == 0) {
+        fprintf(stderr, "return: can only `return' from a function\n");
+        return 1;
+    }
+    func_ret = 1;
+    return args[1] ? atoi(args[1]) & 0xff : status;
+}
+
+// Lệnh local NAME[=value]...: biến chỉ sống tới khi hàm trả về
+int cell_local(char **args) {
+    int rc = 0;
+    for (int i = 1; args[i]; i++) {
+        char *eq = strchr(args[i], '=');
+        size_t len = eq ? (size_t)(eq - args[i]) : strlen(args[i]);
+        char *name = strndup(args[i], len);
+        if (!var_valid_name(name, len)) {
+            fprintf(stderr, "local: `%s': not a valid identifier\n", args[i]);
+            rc = 1;
+        } else if (var_local(name) == -1) {
+            fprintf(stderr, "local: can only be used in a function\n");
+            free(name);
+            return 1;
+        } else if (eq) {
+            var_set(name, eq + 1);
+        }
+        free(name);
+    }
+    return rc;
+}
+
+// Lệnh shift [n]: bỏ n tham số vị trí đầu
+int cell_shift(char **args) {
+    int k = args[1] ? atoi(args[1]) : 1;
+    if (k < 0 || k > var_argc()) {
+        fprintf(stderr, "shift: %s: shift count out of range\n", args[1] ? args[1] : "1");
+        return 1;
+    }
+    var_args_shift(k);
+    return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+#include <stdbool.h>
+#include "parse.h"
+
+/*
+** Hàm shell: name() { ... }. Thân hàm là cây cú pháp đã phân tích, giữ
+** trong bảng băm theo tên và chạy ngay trong tiến trình shell; gọi hàm
+** không fork, không phân tích lại.
+*/
+#define FUNC_BUCKETS 64
+#define FUNC_MAX_DEPTH 1000     /* chặn đệ quy vô hạn trước khi tràn stack */
+
+void    func_define(const char *name, t_node *body);
+t_node *func_find(const char *name);
+int     func_unset(const char *name);
+int     func_run(t_node *body, char **args, int background);
+bool    func_returning(void);
+int     cell_return(char **args);
+int     cell_local(char **args);
+int     cell_shift(char **args);
@@ -0,0 +1,246 @@
+#include "cell.h"
+#include "jobctl.h"
+#include "stats.h"
+#include "redir.h"
+#include <strings.h>
+#include <termios.h>
+
+/*
+** Shell tương tác (stdin là terminal) giao terminal cho job foreground và
+** lấy lại khi job xong hoặc bị Ctrl-Z. Chạy từ script thì vẫn lập nhóm cho
+** từng job (để stop/kill/fg tác động cả nhóm), còn Ctrl-C được shell chuyển
+** tiếp tới nhóm foreground trong sigint_handler.
+*/
+
+static int interactive = 0;
+static int nested = 0;          /* tiến trình này đã là một phần của job */
+static pid_t shell_pgid = 0;
+static struct termios shell_tmodes;
+static volatile pid_t fg_pgid = 0;
+
+extern volatile sig_atomic_t cell_interrupted;
+
+static const struct { const char *name; int sig; } sig_names[] = {
+    { "HUP", SIGHUP }, { "INT", SIGINT }, { "QUIT", SIGQUIT }, { "KILL", SIGKILL },
+    { "USR1", SIGUSR1 }, { "USR2", SIGUSR2 }, { "PIPE", SIGPIPE }, { "ALRM", SIGALRM },
+    { "TERM", SIGTERM }, { "CHLD", SIGCHLD }, { "CONT", SIGCONT }, { "STOP", SIGSTOP },
+    { "TSTP", SIGTSTP }, { "TTIN", SIGTTIN }, { "TTOU", SIGTTOU }, { "WINCH", SIGWINCH },
+    { NULL, 0 },
+};
+
+// "9", "KILL", "SIGKILL", "kill" -> số tín hiệu; -1 nếu không hợp lệ
+int job_parse_signal(const char *s) {
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (*s && !*end)
+        return v >= 0 && v < NSIG ? (int)v : -1;
+    if (!strncasecmp(s, "SIG", 3))
+        s += 3;
+    for (int i = 0; sig_names[i].name; i++)
+        if (!strcasecmp(s, sig_names[i].name))
+            return sig_names[i].sig;
+    return -1;
+}
+
+void jobctl_init(void) {
+    if (!isatty(STDIN_FILENO))
+        return;
+    // bị chạy nền thì đợi tới khi được đưa lên foreground
+    while (tcgetpgrp(STDIN_FILENO) != (shell_pgid = getpgrp()))
+        kill(-shell_pgid, SIGTTIN);
+    signal(SIGTSTP, SIG_IGN);
+    signal(SIGTTIN, SIG_IGN);
+    signal(SIGTTOU, SIG_IGN);   /* tcsetpgrp từ shell khi nó không ở foreground */
+    tcgetattr(STDIN_FILENO, &shell_tmodes);
+    interactive = 1;
+}
+
+int job_nested(void) {
+    return nested;
+}
+
+/**
+ * job_child - Joins the job's process group in a freshly forked child
+ * @pgid: Group to join, 0 to lead a new one
+ * @foreground: Take the terminal as well (interactive shell only)
+ *
+ * A child forked by another job's child (a stage of a compound pipeline)
+ * stays in that job's group so the job is stopped and killed as a whole.
+ */
+void job_child(pid_t pgid, int foreground) {
+    if (!nested) {
+        setpgid(0, pgid);
+        if (foreground && interactive)
+            tcsetpgrp(STDIN_FILENO, getpgrp());
+    }
+    nested = 1;
+    signal(SIGINT, SIG_DFL);
+    signal(SIGTSTP, SIG_DFL);
+    signal(SIGTTIN, SIG_DFL);
+    signal(SIGTTOU, SIG_DFL);
+}
+
+// Gọi ở shell ngay sau fork, cùng với job_child: ai chạy trước cũng được
+void job_setpgid(pid_t pid, pid_t pgid) {
+    if (!nested)
+        setpgid(pid, pgid ? pgid : pid);
+}
+
+void job_tty_give(pid_t pgid) {
+    fg_pgid = pgid;
+    if (interactive && !nested)
+        tcsetpgrp(STDIN_FILENO, pgid);
+}
+
+void job_tty_take(void) {
+    fg_pgid = 0;
+    if (interactive && !nested) {
+        tcsetpgrp(STDIN_FILENO, shell_pgid);
+        tcsetattr(STDIN_FILENO, TCSADRAIN, &shell_tmodes);  /* job bị dừng có thể để tty ở raw mode */
+    }
+}
+
+pid_t job_fg_pgid(void) {
+    return fg_pgid;
+}
+
+// Một killpg cho cả nhóm; job bên trong job khác không có nhóm riêng
+int job_signal(bg_proc *job, int sig) {
+    if (!nested)
+        return killpg(job->pgid, sig);
+    int r = -1;
+    for (int k = 0; k < job->nprocs; k++)
+        if ((job->alive & (1u << k)) && kill(job->procs[k], sig) == 0)
+            r = 0;
+    return r;
+}
+
+/**
+ * job_wait_fg - Runs a job in the foreground until it finishes or stops
+ * @job: Job record; one with id 0 is a fresh foreground job owned here
+ * @cont: Send SIGCONT to the group first (fg of a stopped job)
+ * Return: Exit code of the last process, or 128+SIGTSTP if the job was
+ *         stopped, in which case it joins the job list
+ */
+int job_wait_fg(bg_proc *job, int cont) {
+    uint64_t t0 = stats_now();
+
+    job_tty_give(job->pgid);
+    if (cont)
+        job_signal(job, SIGCONT);
+    job->status = RUNNING;
+    while (!bg_reap(job, 1) && job->status == RUNNING)
+        ;
+    job_tty_take();
+    stats_record(STAT_WAIT, t0);
+    if (job->status == STOPPED) {
+        if (!job->id)
+            job_link(job);
+        printf("\n[%d]+ Stopped\t%s\n", job->id, job->cmd);
+        return 128 + SIGTSTP;
+    }
+    int code = job->exit_code;
+    job->waited = 1;
+    if (code == 128 + SIGINT) {
+        cell_interrupted = 1;   /* Ctrl-C vào job cũng dừng vòng lặp của shell */
+        if (interactive && !nested)
+            write(STDOUT_FILENO, "\n", 1);
+    }
+    if (!job->id)
+        job_free(job);
+    return code;
+}
+
+// Dòng lệnh của job để hiển thị trong jobs / thông báo Stopped
+void job_label(char *buf, size_t n, char **args) {
+    size_t len = 0;
+    buf[0] = '\0';
+    for (int i = 0; args[i] && len + 1 < n; i++)
+        len += snprintf(buf + len, n - len, i ? " %s" : "%s", args[i] + (redir_is_op(args[i]) || args[i][0] == PIPE_MARK));
+}
+
+static bg_proc *job_arg(const char *cmd, const char *spec) {
+    bg_proc *job = spec ? find_bg_job(spec) : bg_current();
+    if (!job || job->status == DONE)
+        fprintf(stderr, "%s: %s: no such job\n", cmd, spec ? spec : "current");
+    return job && job->status != DONE ? job : NULL;
+}
+
+// bg [%N|pid]: tiếp tục job đang dừng ở chế độ nền
+int cell_bg(char **args) {
+    bg_proc *job = job_arg("bg", args[1]);
+    if (!job)
+        return 1;
+    if (job_signal(job, SIGCONT) == -1) {
+        perror("bg");
+        return 1;
+    }
+    job->status = RUNNING;
+    printf("[%d]+ %s &\n", job->id, job->cmd);
+    return 0;
+}
+
+// pid phải là số nguyên trọn vẹn: "abc" không được thành 0 (nhóm của shell)
+static int parse_pid(const char *s, pid_t *out) {
+    char *end;
+    long v;
+    errno = 0;
+    v = strtol(s, &end, 10);
+    if (end == s || *end || errno || v != (pid_t)v)
+        return -1;
+    *out = v;
+    return 0;
+}
+
+/*
+** kill [-s SIG | -SIG] %N|pid ...   kill -l
+** %N gửi cho cả nhóm tiến trình của job bằng một killpg.
+*/
+int cell_kill(char **args) {
+    int sig = SIGTERM, i = 1, rc = 0;
+
+    if (args[1] && !strcmp(args[1], "-l")) {
+        for (int k = 0; sig_names[k].name; k++)
+            printf("%2d) SIG%s\n", sig_names[k].sig, sig_names[k].name);
+        return 0;
+    }
+    if (args[i] && !strcmp(args[i], "-s") && args[i + 1]) {
+        sig = job_parse_signal(args[i + 1]);
+        i += 2;
+    } else if (args[i] && args[i][0] == '-' && args[i][1]) {
+        sig = job_parse_signal(args[i] + 1);
+        i++;
+    }
+    if (sig < 0 || !args[i]) {
+        fprintf(stderr, "kill: usage: kill [-s SIG | -SIG] %%job|pid ...\n");
+        return 2;
+    }
+    for (; args[i]; i++) {
+        bg_proc *job = args[i][0] == '%' ? find_bg_job(args[i]) : NULL;
+        pid_t pid = 0;
+        int r;
+        if (args[i][0] == '%' && !job) {
+            fprintf(stderr, "kill: %s: no such job\n", args[i]);
+            rc = 1;
+            continue;
+        }
+        if (!job && parse_pid(args[i], &pid)) {
+            fprintf(stderr, "kill: %s: arguments must be process or job IDs\n", args[i]);
+            rc = 1;
+            continue;
+        }
+        r = job ? job_signal(job, sig) : kill(pid, sig);
+        if (r == -1) {
+            fprintf(stderr, "kill: %s: %s\n", args[i], strerror(errno));
+            rc = 1;
+            continue;
+        }
+        if (!job)
+            job = find_bg_proc(pid);
+        if (job && job->status != DONE && (sig == SIGSTOP || sig == SIGTSTP))
+            job->status = STOPPED;
+        else if (job && job->status != DONE && sig == SIGCONT)
+            job->status = RUNNING;
+    }
+    return rc;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <sys/types.h>
+#include "processlist.h"
+
+/*
+** Job control: mỗi lệnh/pipeline chạy trong nhóm tiến trình riêng. Job
+** foreground được giao terminal (tcsetpgrp) nên Ctrl-C/Ctrl-Z đi thẳng tới
+** cả nhóm; shell lấy lại terminal khi job xong hoặc bị dừng.
+*/
+
+void    jobctl_init(void);
+int     job_parse_signal(const char *s);
+int     job_nested(void);
+void    job_child(pid_t pgid, int foreground);
+void    job_setpgid(pid_t pid, pid_t pgid);
+void    job_tty_give(pid_t pgid);
+void    job_tty_take(void);
+pid_t   job_fg_pgid(void);
+int     job_signal(bg_proc *job, int sig);
+int     job_wait_fg(bg_proc *job, int cont);
+void    job_label(char *buf, size_t n, char **args);
+int     cell_bg(char **args);
@@ -0,0 +1,361 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include "launchopts.h"
+#include "processlist.h"
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+extern int status;
+
+/*
+** limit [-a cpus] [-n nice] [-i class[:level]] [-t secs] [-v bytes]
+**       [-f nofile] [-g cgroup [-C cpu%] [-M bytes]] cmd args... [&]
+**
+** Các thuộc tính được áp trong tiến trình con (sau fork, trước exec) nên
+** không ảnh hưởng tới shell. Với -g, shell tạo cgroup v2 con dưới cgroup
+** của chính nó, ghi cpu.max/memory.max, và tiến trình con tự chuyển vào đó;
+** nếu host không cho phép thì chỉ cảnh báo và chạy tiếp không có cgroup.
+*/
+
+#define IOPRIO_WHO_PROCESS 1
+#define IOPRIO_CLASS_SHIFT 13
+
+typedef struct s_launch_opts {
+    int has_affinity;
+    cpu_set_t cpus;
+    int has_nice;
+    int nice;
+    int io_class;       /* 0 = giữ nguyên; 1 realtime, 2 best-effort, 3 idle */
+    int io_level;
+    rlim_t cpu_secs;    /* RLIM_INFINITY = không đặt */
+    rlim_t as_bytes;
+    rlim_t nofile;
+    char cgroup[PATH_MAX];  /* thư mục cgroup, "" nếu không dùng */
+    char summary[128];  /* hiển thị trong `jobs` */
+    int owned;          /* cgroup đã giao cho job nền, job xóa khi kết thúc */
+} t_launch_opts;
+
+static t_launch_opts *current = NULL;
+
+static const char *io_class_names[] = { "none", "rt", "be", "idle" };
+
+// "0,2-3" -> cpu_set_t
+static int parse_cpus(const char *s, cpu_set_t *set) {
+    CPU_ZERO(set);
+    while (*s) {
+        char *end;
+        long a = strtol(s, &end, 10), b;
+        if (end == s || a < 0) return -1;
+        b = a;
+        if (*end == '-') {
+            s = end + 1;
+            b = strtol(s, &end, 10);
+            if (end == s || b < a) return -1;
+        }
+        for (long c = a; c <= b && c < CPU_SETSIZE; c++)
+            CPU_SET(c, set);
+        if (*end == ',') end++;
+        else if (*end) return -1;
+        s = end;
+    }
+    return 0;
+}
+
+// "512M", "2G", "unlimited" -> số byte
+static int parse_size(const char *s, rlim_t *out) {
+    char *end;
+    if (!strcmp(s, "unlimited")) {
+        *out = RLIM_INFINITY;
+        return 0;
+    }
+    unsigned long long v = strtoull(s, &end, 10);
+    if (end == s) return -1;
+    switch (*end) {
+    case 'k': case 'K': v <<= 10; end++; break;
+    case 'm': case 'M': v <<= 20; end++; break;
+    case 'g': case 'G': v <<= 30; end++; break;
+    }
+    if (*end) return -1;
+    *out = v;
+    return 0;
+}
+
+// "30", "unlimited" -> số giây (không nhận hậu tố như parse_size)
+static int parse_secs(const char *s, rlim_t *out) {
+    char *end;
+    if (!strcmp(s, "unlimited")) {
+        *out = RLIM_INFINITY;
+        return 0;
+    }
+    errno = 0;
+    long v = strtol(s, &end, 10);
+    if (end == s || *end || v < 0 || errno) return -1;
+    *out = v;
+    return 0;
+}
+
+// Tên cgroup là một thành phần đường dẫn dưới cgroup của shell
+static int valid_cgroup_name(const char *s) {
+    return *s && !strchr(s, '/') && strcmp(s, ".") && strcmp(s, "..");
+}
+
+static int write_file(const char *path, const char *val) {
+    int fd = open(path, O_WRONLY);
+    if (fd == -1) return -1;
+    ssize_t n = write(fd, val, strlen(val));
+    close(fd);
+    return n == (ssize_t)strlen(val) ? 0 : -1;
+}
+
+/*
+** Tạo cgroup con cho job. Return: 0 nếu dùng được, -1 nếu host không cho phép.
+*/
+static int setup_cgroup(t_launch_opts *o, const char *name, const char *cpu_max,
+                        const char *mem_max) {
+    char line[PATH_MAX], path[PATH_MAX], file[PATH_MAX + 32];
+    const char *self = "";
+    FILE *f = fopen("/proc/self/cgroup", "r");
+    if (f) {
+        while (fgets(line, sizeof(line), f))
+            if (!strncmp(line, "0::", 3)) {
+                line[strcspn(line, "\n")] = '\0';
+                self = strcmp(line + 3, "/") ? line + 3 : "";
+                break;
+            }
+        fclose(f);
+    }
+    if ((size_t)snprintf(path, sizeof(path), "/sys/fs/cgroup%s", self) >= sizeof(path)
+        || (size_t)snprintf(o->cgroup, sizeof(o->cgroup), "%s/cell-%s", path, name)
+           >= sizeof(o->cgroup)) {
+        fprintf(stderr, "limit: cgroup %s: path too long (continuing without it)\n", name);
+        o->cgroup[0] = '\0';
+        return -1;
+    }
+    snprintf(file, sizeof(file), "%s/cgroup.subtree_control", path);
+    write_file(file, "+cpu +memory"); // có thể thất bại nếu đã bật hoặc không được ủy quyền
+    if (mkdir(o->cgroup, 0755) == -1 && errno != EEXIST) {
+        fprintf(stderr, "limit: cgroup %s: %s (continuing without it)\n",
+                o->cgroup, strerror(errno));
+        o->cgroup[0] = '\0';
+        return -1;
+    }
+    if (cpu_max) {
+        char val[64];
+        double pct = atof(cpu_max);
+        snprintf(val, sizeof(val), "%ld 100000", (long)(pct * 1000));
+        snprintf(file, sizeof(file), "%s/cpu.max", o->cgroup);
+        if (pct <= 0 || write_file(file, val) == -1)
+            fprintf(stderr, "limit: cannot set cpu.max in %s\n", o->cgroup);
+    }
+    if (mem_max) {
+        snprintf(file, sizeof(file), "%s/memory.max", o->cgroup);
+        if (write_file(file, mem_max) == -1)
+            fprintf(stderr, "limit: cannot set memory.max in %s\n", o->cgroup);
+    }
+    return 0;
+}
+
+static void set_rlimit(int res, rlim_t v) {
+    struct rlimit rl;
+    if (v == RLIM_INFINITY) return;
+    getrlimit(res, &rl);
+    rl.rlim_cur = v;
+    if (rl.rlim_max != RLIM_INFINITY && rl.rlim_max < v)
+        rl.rlim_cur = rl.rlim_max;
+    setrlimit(res, &rl);
+}
+
+/**
+ * launch_opts_apply - Applies the active `limit` options to this process
+ * Called in the child between fork and exec; no-op outside `limit`.
+ */
+void launch_opts_apply(void) {
+    t_launch_opts *o = current;
+    if (!o) return;
+    if (o->cgroup[0]) {
+        char file[PATH_MAX + 32];
+        snprintf(file, sizeof(file), "%s/cgroup.procs", o->cgroup);
+        if (write_file(file, "0") == -1)
+            fprintf(stderr, "limit: cannot join %s\n", o->cgroup);
+    }
+    if (o->has_affinity && sched_setaffinity(0, sizeof(o->cpus), &o->cpus) == -1)
+        perror("limit: affinity");
+    if (o->has_nice && setpriority(PRIO_PROCESS, 0, o->nice) == -1)
+        perror("limit: nice");
+    if (o->io_class && syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0,
+                               (o->io_class << IOPRIO_CLASS_SHIFT) | o->io_level) == -1)
+        perror("limit: ionice");
+    set_rlimit(RLIMIT_CPU, o->cpu_secs);
+    set_rlimit(RLIMIT_AS, o->as_bytes);
+    set_rlimit(RLIMIT_NOFILE, o->nofile);
+}
+
+/*
+** launch_opts_attach - Ghi thuộc tính `limit` đang áp vào job nền vừa tạo.
+** Job giữ đường dẫn cgroup và xóa thư mục khi được thu hồi (bg_reap).
+*/
+void launch_opts_attach(bg_proc *job) {
+    t_launch_opts *o = current;
+    if (!o) return;
+    snprintf(job->limits, sizeof(job->limits), "%s", o->summary);
+    if (o->cgroup[0] && !job->cgroup) {
+        job->cgroup = strdup(o->cgroup);
+        o->owned = 1;
+    }
+}
+
+static void build_summary(t_launch_opts *o, const char *cpus, const char *cg) {
+    char *s = o->summary;
+    size_t n = sizeof(o->summary), len = 0;
+    s[0] = '\0';
+    if (o->has_affinity) len += snprintf(s + len, n - len, " cpus=%s", cpus);
+    if (o->has_nice && len < n) len += snprintf(s + len, n - len, " nice=%d", o->nice);
+    if (o->io_class && len < n)
+        len += snprintf(s + len, n - len, " io=%s:%d", io_class_names[o->io_class], o->io_level);
+    if (o->cpu_secs != RLIM_INFINITY && len < n)
+        len += snprintf(s + len, n - len, " cpu=%llus", (unsigned long long)o->cpu_secs);
+    if (o->as_bytes != RLIM_INFINITY && len < n)
+        len += snprintf(s + len, n - len, " as=%lluM", (unsigned long long)(o->as_bytes >> 20));
+    if (o->nofile != RLIM_INFINITY && len < n)
+        len += snprintf(s + len, n - len, " nofile=%llu", (unsigned long long)o->nofile);
+    if (o->cgroup[0] && len < n)
+        snprintf(s + len, n - len, " cgroup=%s", cg);
+}
+
+/**
+ * cell_limit - Runs a command with affinity/priority/resource limits
+ * @args: limit [options] cmd args...
+ * @background: Run the command as a background job
+ * Return: exit status of the command, 1 on bad usage
+ */
+int cell_limit(char **args, int background) {
+    t_launch_opts o;
+    const char *cpus = NULL, *cg = NULL, *cpu_max = NULL, *mem_max = NULL;
+    int i = 1;
+
+    memset(&o, 0, sizeof(o));
+    o.cpu_secs = o.as_bytes = o.nofile = RLIM_INFINITY;
+    for (; args[i] && args[i][0] == '-' && args[i + 1]; i += 2) {
+        const char *v = args[i + 1];
+        int bad = 0;
+        switch (args[i][1]) {
+        case 'a': cpus = v; o.has_affinity = 1; bad = parse_cpus(v, &o.cpus); break;
+        case 'n': o.has_nice = 1; o.nice = atoi(v); break;
+        case 'i':
+            o.io_class = atoi(v);
+            o.io_level = strchr(v, ':') ? atoi(strchr(v, ':') + 1) : 4;
+            bad = o.io_class < 1 || o.io_class > 3 || o.io_level < 0 || o.io_level > 7;
+            break;
+        case 't': bad = parse_secs(v, &o.cpu_secs); break;
+        case 'v': bad = parse_size(v, &o.as_bytes); break;
+        case 'f': bad = parse_size(v, &o.nofile); break;
+        case 'g': cg = v; bad = !valid_cgroup_name(v); break;
+        case 'C': cpu_max = v; break;
+        case 'M': mem_max = v; break;
+        default: bad = 1;
+        }
+        if (bad || args[i][2]) {
+            fprintf(stderr, "limit: invalid option %s %s\n", args[i], v);
+            return 1;
+        }
+    }
+    if (!args[i]) {
+        fprintf(stderr, "limit: usage: limit [-a cpus] [-n nice] [-i class[:level]] "
+                        "[-t secs] [-v bytes] [-f nofile] [-g name [-C cpu%%] [-M bytes]] cmd...\n");
+        return 1;
+    }
+    if (cg)
+        setup_cgroup(&o, cg, cpu_max, mem_max);
+    build_summary(&o, cpus, cg);
+
+    current = &o;
+    cell_execute(&args[i], background);
+    current = NULL;
+    if (o.cgroup[0] && !o.owned)
+        rmdir(o.cgroup); // chỉ thành công khi cgroup đã rỗng
+    return status;
+}
+
+static const struct {
+    char flag;
+    int res;
+    const char *name;
+    int shift;          /* hiển thị theo đơn vị 2^shift byte */
+} ulimits[] = {
+    {'c', RLIMIT_CORE, "core file size (blocks)", 10},  /* block 1024 byte như bash */
+    {'f', RLIMIT_FSIZE, "file size (blocks)", 10},
+    {'n', RLIMIT_NOFILE, "open files", 0},
+    {'s', RLIMIT_STACK, "stack size (kbytes)", 10},
+    {'t', RLIMIT_CPU, "cpu time (seconds)", 0},
+    {'u', RLIMIT_NPROC, "max user processes", 0},
+    {'v', RLIMIT_AS, "virtual memory (kbytes)", 10},
+};
+
+static void print_ulimit(int k, int with_name) {
+    struct rlimit rl;
+    getrlimit(ulimits[k].res, &rl);
+    if (with_name)
+        printf("%-28s (-%c) ", ulimits[k].name, ulimits[k].flag);
+    if (rl.rlim_cur == RLIM_INFINITY)
+        printf("unlimited\n");
+    else
+        printf("%llu\n", (unsigned long long)(rl.rlim_cur >> ulimits[k].shift));
+}
+
+/**
+ * cell_ulimit - Shows or sets resource limits of the shell itself
+ * @args: ulimit [-a] | ulimit [-H] [-cfnstuv] [value|unlimited]
+ * Return: 0 on success, 1 on failure
+ */
+int cell_ulimit(char **args) {
+    int nlim = sizeof(ulimits) / sizeof(ulimits[0]);
+    int k = 1, hard = 0, i = 1; // mặc định -f như các shell khác
+
+    for (; args[i] && args[i][0] == '-'; i++) {
+        if (!strcmp(args[i], "-a")) {
+            for (int j = 0; j < nlim; j++)
+                print_ulimit(j, 1);
+            return 0;
+        }
+        if (!strcmp(args[i], "-H")) {
+            hard = 1;
+            continue;
+        }
+        int found = 0;
+        for (int j = 0; j < nlim; j++)
+            if (args[i][1] == ulimits[j].flag && !args[i][2]) {
+                k = j;
+                found = 1;
+            }
+        if (!found) {
+            fprintf(stderr, "ulimit: invalid option %s\n", args[i]);
+            return 1;
+        }
+    }
+    if (!args[i]) {
+        print_ulimit(k, 0);
+        return 0;
+    }
+    struct rlimit rl;
+    rlim_t v;
+    if (parse_size(args[i], &v) == -1) {
+        fprintf(stderr, "ulimit: invalid value %s\n", args[i]);
+        return 1;
+    }
+    if (v != RLIM_INFINITY && isdigit((unsigned char)args[i][strlen(args[i]) - 1]))
+        v <<= ulimits[k].shift; // số trần tính theo đơn vị của limit, có hậu tố thì là byte
+    getrlimit(ulimits[k].res, &rl);
+    rl.rlim_cur = v;
+    if (hard)
+        rl.rlim_max = v;
+    if (setrlimit(ulimits[k].res, &rl) == -1) {
+        perror("ulimit");
+        return 1;
+    }
+    return 0;
+}
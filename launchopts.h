@@ -0,0 +1,14 @@
+#pragma once
+
+/*
+** Thuộc tính job do lệnh `limit` đặt (affinity, nice, ionice, rlimit, cgroup).
+** Chỉ có hiệu lực trong lúc `limit` chạy lệnh của nó; tiến trình con gọi
+** launch_opts_apply() ngay trước exec, job nền nhận thuộc tính (và cgroup)
+** qua launch_opts_attach().
+*/
+typedef struct bg_proc bg_proc;
+
+void        launch_opts_apply(void);
+void        launch_opts_attach(bg_proc *job);
+int         cell_limit(char **args, int background);
+int         cell_ulimit(char **args);
@@ -0,0 +1,447 @@
+#include "cell.h"
+#include "lineedit.h"
+
+#ifdef CELL_LINEEDIT
+#include "vars.h"
+#include <ctype.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+
+/*
+** Bộ soạn dòng raw mode thay cho readline (build với LINEEDIT=1).
+**
+** Mỗi phím được xử lý rồi mới vẽ lại, và chỉ vẽ khi không còn input chờ:
+** dán một khối lớn không có bracketed paste cũng chỉ vẽ lại vài lần. Với
+** bracketed paste (ESC[200~ ... ESC[201~) cả khối được đọc bằng read() lớn
+** và chèn một lần. Dòng dài cuộn ngang quanh con trỏ; ký tự UTF-8 tính là
+** một cột.
+*/
+
+rl_completion_func_t *rl_attempted_completion_function = NULL;
+rl_getc_func_t *rl_getc_function = rl_getc;
+int rl_attempted_completion_over = 0;
+
+typedef struct s_line {
+    char *buf;
+    size_t len;
+    size_t cap;
+    size_t pos;         /* vị trí con trỏ (byte) */
+    const char *prompt;
+    int pw;             /* số cột của prompt */
+    int hist_idx;       /* dòng lịch sử đang xem; history_count = dòng mới */
+    char *saved;        /* dòng đang gõ dở khi lướt lịch sử */
+} t_line;
+
+// phần input đọc quá sau dấu kết thúc paste, được trả lại trước khi đọc fd
+static char *pend;
+static size_t pend_len, pend_pos;
+
+int rl_getc(FILE *in) {
+    unsigned char c;
+    for (;;) {
+        ssize_t n = read(fileno(in), &c, 1);
+        if (n == 1)
+            return c;
+        if (n == -1 && errno == EINTR)
+            continue;
+        return EOF;
+    }
+}
+
+static int le_getc(void) {
+    if (pend_pos < pend_len)
+        return (unsigned char)pend[pend_pos++];
+    return rl_getc_function(stdin);
+}
+
+static int input_pending(void) {
+    struct pollfd pfd = { .fd = STDIN_FILENO, .events = POLLIN };
+    return pend_pos < pend_len || poll(&pfd, 1, 0) > 0;
+}
+
+static void write_all(const char *s, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(STDOUT_FILENO, s, n);
+        if (w == -1 && errno == EINTR)
+            continue;
+        if (w <= 0)
+            return;
+        s += w;
+        n -= w;
+    }
+}
+
+// Số cột hiển thị: một cột mỗi ký tự UTF-8, bỏ qua mã màu ESC[...m của prompt
+static int str_width(const char *s, size_t n) {
+    int w = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == '\x1b' && i + 1 < n && s[i + 1] == '[') {
+            for (i += 2; i < n && !isalpha((unsigned char)s[i]); i++)
+                ;
+            continue;
+        }
+        if (((unsigned char)s[i] & 0xC0) != 0x80)
+            w++;
+    }
+    return w;
+}
+
+static size_t prev_char(t_line *l, size_t i) {
+    if (i == 0)
+        return 0;
+    do i--; while (i > 0 && ((unsigned char)l->buf[i] & 0xC0) == 0x80);
+    return i;
+}
+
+static size_t next_char(t_line *l, size_t i) {
+    if (i >= l->len)
+        return l->len;
+    do i++; while (i < l->len && ((unsigned char)l->buf[i] & 0xC0) == 0x80);
+    return i;
+}
+
+static void refresh(t_line *l) {
+    struct winsize ws;
+    int cols = !ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) && ws.ws_col ? ws.ws_col : 80;
+    int avail = cols - l->pw - 1;
+    if (avail < 8)
+        avail = 8;
+    int ccol = str_width(l->buf, l->pos);
+    int off = ccol >= avail ? ccol - avail + 1 : 0;
+    t_str out = {0};
+    char mv[32];
+
+    str_puts(&out, "\r");
+    str_puts(&out, l->prompt);
+    for (size_t i = 0, col = 0; i < l->len; col++) {
+        size_t j = next_char(l, i);
+        if ((int)col >= off && (int)col < off + avail) {
+            if (l->buf[i] == '\n')
+                str_puts(&out, "↵");     /* dòng dán nhiều dòng */
+            else if ((unsigned char)l->buf[i] < 0x20)
+                str_putc(&out, ' ');
+            else
+                str_putn(&out, l->buf + i, j - i);
+        }
+        i = j;
+    }
+    str_puts(&out, "\x1b[K\r");
+    if (l->pw + ccol - off > 0) {
+        snprintf(mv, sizeof(mv), "\x1b[%dC", l->pw + ccol - off);
+        str_puts(&out, mv);
+    }
+    write_all(out.s, out.len);
+    free(out.s);
+}
+
+static void insert(t_line *l, const char *s, size_t n) {
+    if (l->len + n + 1 > l->cap) {
+        l->cap = (l->len + n + 1) * 2;
+        l->buf = Realloc(l->buf, l->cap);
+    }
+    memmove(l->buf + l->pos + n, l->buf + l->pos, l->len - l->pos);
+    memcpy(l->buf + l->pos, s, n);
+    l->len += n;
+    l->pos += n;
+    l->buf[l->len] = '\0';
+}
+
+static void delete_range(t_line *l, size_t a, size_t b) {
+    memmove(l->buf + a, l->buf + b, l->len - b);
+    l->len -= b - a;
+    l->buf[l->len] = '\0';
+    if (l->pos >= b)
+        l->pos -= b - a;
+    else if (l->pos > a)
+        l->pos = a;
+}
+
+static void set_line(t_line *l, const char *s) {
+    l->len = l->pos = 0;
+    l->buf[0] = '\0';
+    insert(l, s, strlen(s));
+}
+
+static void history_move(t_line *l, int dir) {
+    int idx = l->hist_idx + dir;
+    if (idx < 0 || idx > history_count)
+        return;
+    if (l->hist_idx == history_count) {
+        free(l->saved);
+        l->saved = strdup(l->buf);
+    }
+    set_line(l, idx == history_count ? l->saved : cell_history_at(idx));
+    l->hist_idx = idx;
+}
+
+static size_t word_left(t_line *l) {
+    size_t i = l->pos;
+    while (i > 0 && l->buf[i - 1] == ' ') i--;
+    while (i > 0 && l->buf[i - 1] != ' ') i--;
+    return i;
+}
+
+static size_t word_right(t_line *l) {
+    size_t i = l->pos;
+    while (i < l->len && l->buf[i] == ' ') i++;
+    while (i < l->len && l->buf[i] != ' ') i++;
+    return i;
+}
+
+/*
+** Bracketed paste: đọc cả khối tới ESC[201~ bằng read() lớn rồi chèn một
+** lần. '\r' của terminal thành '\n' để dòng dán nhiều dòng chạy như script.
+*/
+static void paste(t_line *l) {
+    static const char end[] = "\x1b[201~";
+    char *chunk = Malloc(LE_PASTE_CHUNK);
+    t_str acc = {0};
+    size_t m = 0;       /* số byte của end đã khớp */
+
+    for (;;) {
+        ssize_t n;
+        if (pend_pos < pend_len) {
+            n = pend_len - pend_pos;
+            memcpy(chunk, pend + pend_pos, n);
+            pend_pos = pend_len = 0;
+        } else {
+            n = read(STDIN_FILENO, chunk, LE_PASTE_CHUNK);
+        }
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        for (ssize_t i = 0; i < n; i++) {
+            if (chunk[i] == end[m]) {
+                if (++m < sizeof(end) - 1)
+                    continue;
+                // phần còn lại của khối là phím gõ sau khi dán
+                if (!pend)
+                    pend = Malloc(LE_PASTE_CHUNK);
+                pend_len = n - i - 1;
+                pend_pos = 0;
+                memcpy(pend, chunk + i + 1, pend_len);
+                goto done;
+            }
+            if (m) {
+                str_putn(&acc, end, m);
+                m = 0;
+                if (chunk[i] == end[0]) {
+                    m = 1;
+                    continue;
+                }
+            }
+            str_putc(&acc, chunk[i] == '\r' ? '\n' : chunk[i]);
+        }
+    }
+done:
+    if (acc.len)
+        insert(l, acc.s, acc.len);
+    free(acc.s);
+    free(chunk);
+}
+
+static void complete(t_line *l) {
+    size_t start = l->pos;
+    if (!rl_attempted_completion_function)
+        return;
+    while (start > 0 && l->buf[start - 1] != ' ')
+        start--;
+    char *text = strndup(l->buf + start, l->pos - start);
+    char **m = rl_attempted_completion_function(text, start, l->pos);
+    size_t n = 0;
+
+    if (!m) {
+        write_all("\a", 1);
+        free(text);
+        return;
+    }
+    while (m[n]) n++;
+    // m[0] là kết quả duy nhất hoặc phần chung của các kết quả
+    if (strlen(m[0]) > strlen(text)) {
+        delete_range(l, start, l->pos);
+        insert(l, m[0], strlen(m[0]));
+        if (n == 1)
+            insert(l, " ", 1);
+    } else if (n == 1) {
+        insert(l, " ", 1);
+    } else {
+        t_str out = {0};
+        str_puts(&out, "\r\n");
+        for (size_t i = 1; i < n; i++) {
+            str_puts(&out, m[i]);
+            str_puts(&out, "  ");
+        }
+        str_puts(&out, "\r\n");
+        write_all(out.s, out.len);
+        free(out.s);
+    }
+    for (size_t i = 0; i < n; i++)
+        free(m[i]);
+    free(m);
+    free(text);
+}
+
+char **rl_completion_matches(const char *text, rl_compentry_func_t *gen) {
+    char **m = Malloc(2 * sizeof(char *));
+    size_t n = 0, lcd;
+    char *s;
+
+    for (int state = 0; (s = gen(text, state)); state++) {
+        m = Realloc(m, (n + 3) * sizeof(char *));
+        m[++n] = s;
+    }
+    if (n == 0) {
+        free(m);
+        return NULL;
+    }
+    if (n == 1) {
+        m[0] = m[1];
+        m[1] = NULL;
+        return m;
+    }
+    lcd = strlen(m[1]);
+    for (size_t i = 2; i <= n; i++) {
+        size_t k = 0;
+        while (k < lcd && m[i][k] == m[1][k]) k++;
+        lcd = k;
+    }
+    m[0] = strndup(m[1], lcd);
+    m[n + 1] = NULL;
+    return m;
+}
+
+static void escape(t_line *l) {
+    char seq[16];
+    int n = 0, c = le_getc();
+
+    if (c == 'b') { l->pos = word_left(l); return; }     /* Alt-b */
+    if (c == 'f') { l->pos = word_right(l); return; }    /* Alt-f */
+    if (c != '[' && c != 'O')
+        return;
+    while ((c = le_getc()) != EOF && n < 15 && (isdigit(c) || c == ';'))
+        seq[n++] = c;
+    seq[n] = '\0';
+    switch (c) {
+    case 'A': history_move(l, -1); break;
+    case 'B': history_move(l, 1); break;
+    case 'C': l->pos = next_char(l, l->pos); break;
+    case 'D': l->pos = prev_char(l, l->pos); break;
+    case 'H': l->pos = 0; break;
+    case 'F': l->pos = l->len; break;
+    case '~':
+        if (!strcmp(seq, "3") && l->pos < l->len)
+            delete_range(l, l->pos, next_char(l, l->pos));
+        else if (!strcmp(seq, "1") || !strcmp(seq, "7"))
+            l->pos = 0;
+        else if (!strcmp(seq, "4") || !strcmp(seq, "8"))
+            l->pos = l->len;
+        else if (!strcmp(seq, "200"))
+            paste(l);
+        break;
+    }
+}
+
+// stdin không phải terminal (script): đọc tới '\n' từng byte qua hook getc
+static char *read_plain(void) {
+    t_str s = {0};
+    int c;
+    while ((c = le_getc()) != EOF && c != '\n')
+        str_putc(&s, c);
+    if (c == EOF && !s.s)
+        return NULL;
+    return s.s ? s.s : strdup("");
+}
+
+/**
+ * readline - Reads one line with editing on a terminal
+ * @prompt: Prompt, may contain ANSI colour codes
+ * Return: malloc'd line without the newline, "" after Ctrl-C, NULL on EOF
+ */
+char *readline(const char *prompt) {
+    struct termios orig, raw;
+    t_line l = { .prompt = prompt, .hist_idx = history_count, .cap = 128 };
+    char *result = NULL;
+    int done = 0;
+
+    if (!isatty(STDIN_FILENO) || tcgetattr(STDIN_FILENO, &orig) == -1)
+        return read_plain();
+    raw = orig;
+    raw.c_iflag &= ~(BRKINT | ICRNL | INPCK | ISTRIP | IXON);
+    raw.c_cflag |= CS8;
+    raw.c_lflag &= ~(ECHO | ICANON | IEXTEN | ISIG);
+    raw.c_cc[VMIN] = 1;
+    raw.c_cc[VTIME] = 0;
+    // TCSADRAIN, không TCSAFLUSH: giữ phần người dùng đã gõ/dán trước prompt
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &raw);
+    write_all("\x1b[?2004h", 8);
+
+    l.buf = Malloc(l.cap);
+    l.buf[0] = '\0';
+    l.pw = str_width(prompt, strlen(prompt));
+    refresh(&l);
+    while (!done) {
+        int c = le_getc();
+        switch (c) {
+        case EOF:
+            done = 1;
+            break;
+        case '\r':
+        case '\n':
+            result = l.buf;
+            done = 1;
+            break;
+        case 4:         /* Ctrl-D: EOF trên dòng rỗng, không thì xóa ký tự */
+            if (!l.len)
+                done = 1;
+            else if (l.pos < l.len)
+                delete_range(&l, l.pos, next_char(&l, l.pos));
+            break;
+        case 3:         /* Ctrl-C: bỏ dòng đang gõ */
+            write_all("^C", 2);
+            l.len = l.pos = 0;
+            l.buf[0] = '\0';
+            result = l.buf;
+            done = 1;
+            break;
+        case 127:
+        case 8:
+            if (l.pos > 0)
+                delete_range(&l, prev_char(&l, l.pos), l.pos);
+            break;
+        case 1: l.pos = 0; break;                               /* Ctrl-A */
+        case 5: l.pos = l.len; break;                           /* Ctrl-E */
+        case 2: l.pos = prev_char(&l, l.pos); break;            /* Ctrl-B */
+        case 6: l.pos = next_char(&l, l.pos); break;            /* Ctrl-F */
+        case 11: delete_range(&l, l.pos, l.len); break;         /* Ctrl-K */
+        case 21: delete_range(&l, 0, l.pos); break;             /* Ctrl-U */
+        case 23: delete_range(&l, word_left(&l), l.pos); break; /* Ctrl-W */
+        case 16: history_move(&l, -1); break;                   /* Ctrl-P */
+        case 14: history_move(&l, 1); break;                    /* Ctrl-N */
+        case 12: write_all("\x1b[H\x1b[2J", 7); break;          /* Ctrl-L */
+        case 9: complete(&l); break;
+        case 27: escape(&l); break;
+        default:
+            if (c >= 32) {
+                char ch = c;
+                insert(&l, &ch, 1);
+            }
+        }
+        if (!done && !input_pending())
+            refresh(&l);
+    }
+    l.pos = l.len;
+    refresh(&l);
+    write_all("\r\n", 2);
+    write_all("\x1b[?2004l", 8);
+    tcsetattr(STDIN_FILENO, TCSADRAIN, &orig);
+    free(l.saved);
+    if (!result) {
+        free(l.buf);
+        return NULL;
+    }
+    return result;
+}
+
+#endif
@@ -0,0 +1,34 @@
+#pragma once
+#include <stdio.h>
+
+/*
+** Nguồn đọc dòng lệnh. Mặc định là GNU readline; `make LINEEDIT=1` dùng
+** bộ soạn dòng nhỏ trong lineedit.c (raw mode, lịch sử, di chuyển con trỏ,
+** hoàn thành lệnh, bracketed paste nạp cả khối) và không cần libreadline.
+** Bộ soạn dòng cung cấp đúng phần API readline mà shell dùng, nên cell.c và
+** capture.c không phải phân nhánh.
+*/
+
+#ifdef CELL_LINEEDIT
+
+#define LE_PASTE_CHUNK (64 * 1024)
+
+typedef char *rl_compentry_func_t(const char *text, int state);
+typedef char **rl_completion_func_t(const char *text, int start, int end);
+typedef int rl_getc_func_t(FILE *in);
+
+extern rl_completion_func_t *rl_attempted_completion_function;
+extern rl_getc_func_t *rl_getc_function;
+extern int rl_attempted_completion_over;
+
+char   *readline(const char *prompt);
+int     rl_getc(FILE *in);
+char  **rl_completion_matches(const char *text, rl_compentry_func_t *gen);
+void    add_history(const char *cmd);   /* lịch sử dùng chung với lệnh history, builtin.c */
+
+#else
+
+# include <readline/readline.h>
+# include <readline/history.h>
+
+#endif
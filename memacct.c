@@ -0,0 +1,216 @@
+#include "cell.h"
+#include "memacct.h"
+#include "processlist.h"
+#include "redir.h"
+#include "lineedit.h"
+#include <fcntl.h>
+
+extern volatile sig_atomic_t cell_interrupted;
+
+static unsigned long long n_malloc, n_realloc, bytes_requested;
+
+static const struct {
+    const char *name;
+    void (*walk)(t_memuse *u);
+} subsystems[] = {
+    { "history", history_mem },
+    { "jobs", jobs_mem },
+    { "capture", capture_mem },
+    { "vars", vars_mem },
+    { "functions", func_mem },
+    { "aliases", alias_mem },
+};
+
+#define NSUBSYS ((int)(sizeof(subsystems) / sizeof(subsystems[0])))
+
+// Malloc/Realloc gọi mỗi lần cấp phát thành công
+void mem_note_alloc(size_t size, int re) {
+    if (re)
+        n_realloc++;
+    else
+        n_malloc++;
+    bytes_requested += size;
+}
+
+static size_t rss_bytes(void) {
+    long pages = 0;
+    FILE *f = fopen("/proc/self/statm", "r");
+    if (f) {
+        if (fscanf(f, "%*d %ld", &pages) != 1)
+            pages = 0;
+        fclose(f);
+    }
+    return (size_t)pages * sysconf(_SC_PAGESIZE);
+}
+
+// Byte đang được cấp phát trên heap (kể cả các khối mmap lớn)
+static size_t heap_bytes(void) {
+    struct mallinfo2 mi = mallinfo2();
+    return mi.uordblks + mi.hblkhd;
+}
+
+static void print_human(void) {
+    t_memuse total = {0};
+    printf("%-12s %10s %12s\n", "subsystem", "objects", "bytes");
+    for (int i = 0; i < NSUBSYS; i++) {
+        t_memuse u = {0};
+        subsystems[i].walk(&u);
+        printf("%-12s %10zu %12zu\n", subsystems[i].name, u.objects, u.bytes);
+        total.objects += u.objects;
+        total.bytes += u.bytes;
+    }
+    printf("%-12s %10zu %12zu\n", "tracked", total.objects, total.bytes);
+    printf("%-12s %10s %12zu\n", "heap in use", "", heap_bytes());
+    printf("%-12s %10s %12zu\n", "rss", "", rss_bytes());
+    printf("Malloc %llu calls, Realloc %llu calls, %llu bytes requested\n",
+           n_malloc, n_realloc, bytes_requested);
+}
+
+static void print_json(void) {
+    printf("{");
+    for (int i = 0; i < NSUBSYS; i++) {
+        t_memuse u = {0};
+        subsystems[i].walk(&u);
+        printf("\"%s\":{\"objects\":%zu,\"bytes\":%zu},", subsystems[i].name, u.objects, u.bytes);
+    }
+    printf("\"heap\":%zu,\"rss\":%zu,\"malloc_calls\":%llu,\"realloc_calls\":%llu,"
+           "\"bytes_requested\":%llu}\n",
+           heap_bytes(), rss_bytes(), n_malloc, n_realloc, bytes_requested);
+}
+
+/*
+** Vòng mặc định của soak: các dòng để lại trạng thái sống lâu (biến, hàm,
+** alias, lịch sử) mà lần chạy sau ghi đè, nên bộ nhớ phải đứng yên.
+*/
+static const char *soak_lines[] = {
+    "soak_x=$((soak_x + 1)); soak_y=\"v$soak_x\"",
+    "echo \"$soak_y\" > /dev/null",
+    "soak_f() { local a=$1; return 0; }; soak_f $soak_x",
+    "[ $soak_x -gt 0 ] && soak_t=1 || soak_t=0",
+    "for soak_i in 1 2 3; do soak_a[$soak_i]=$soak_x; done",
+    "alias soak_ll='echo ll'",
+    "echo soak | cat > /dev/null",
+    "true | true &",
+};
+
+typedef struct s_soak_sample {
+    long runs;
+    size_t rss;
+    size_t heap;
+    t_memuse hist;
+    t_memuse jobs;
+} t_soak_sample;
+
+static void soak_sample(t_soak_sample *s, long runs) {
+    s->runs = runs;
+    s->rss = rss_bytes();
+    s->heap = heap_bytes();
+    s->hist = (t_memuse){0};
+    s->jobs = (t_memuse){0};
+    history_mem(&s->hist);
+    jobs_mem(&s->jobs);
+}
+
+static char *join_words(char **w) {
+    size_t len = 1;
+    for (int i = 0; w[i]; i++)
+        len += strlen(w[i]) + 1;
+    char *s = Malloc(len);
+    s[0] = '\0';
+    for (int i = 0; w[i]; i++) {
+        if (i) strcat(s, " ");
+        strcat(s, w[i]);
+    }
+    return s;
+}
+
+/*
+** Chạy runs lần, mỗi lần như một dòng đọc ở prompt: vào lịch sử, chạy,
+** rồi dọn job như trước prompt kế. Output của lệnh bỏ vào /dev/null.
+*/
+static int soak(char **cmd, long runs) {
+    t_soak_sample s[MEM_SOAK_SAMPLES + 1];
+    char *user = cmd[0] ? join_words(cmd) : NULL;
+    int ns = 0, nlines = sizeof(soak_lines) / sizeof(soak_lines[0]);
+    long r = 0;
+
+    fflush(stdout);
+    int saved = fcntl(STDOUT_FILENO, F_DUPFD_CLOEXEC, REDIR_SAVE_FD);
+    int null = open("/dev/null", O_WRONLY);
+    if (saved == -1 || null == -1) {
+        perror("memstat");
+        free(user);
+        return 1;
+    }
+    dup2(null, STDOUT_FILENO);
+    close(null);
+    cell_interrupted = 0;
+    for (; r < runs && !cell_interrupted; r++) {
+        const char *src = user ? user
+                        : r % MEM_SOAK_JOB_EVERY == MEM_SOAK_JOB_EVERY - 1 ? "true &"
+                        : soak_lines[r % nlines];
+        char *line = strdup(src);
+        add_history(line);
+        cell_run_line(line);
+        free(line);
+        jobs_housekeep();
+        if ((r + 1) % (runs / MEM_SOAK_SAMPLES ? runs / MEM_SOAK_SAMPLES : 1) == 0
+            && ns <= MEM_SOAK_SAMPLES)
+            soak_sample(&s[ns++], r + 1);
+    }
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+    free(user);
+
+    printf("%10s %12s %12s %8s %6s\n", "runs", "rss KiB", "heap KiB", "history", "jobs");
+    for (int i = 0; i < ns; i++)
+        printf("%10ld %12zu %12zu %8zu %6zu\n", s[i].runs, s[i].rss / 1024, s[i].heap / 1024,
+               s[i].hist.objects, s[i].jobs.objects);
+    if (cell_interrupted)
+        return 128 + SIGINT;
+    // hết khởi động khi lịch sử đã đầy và danh sách job đã giữ đủ job DONE;
+    // số job còn chạy lúc lấy mẫu thì dao động
+    int b = 0, e = ns - 1;
+    size_t jobs_full = s[e].jobs.objects < JOBS_DONE_MAX ? s[e].jobs.objects : JOBS_DONE_MAX;
+    while (b < e && (s[b].hist.objects < s[e].hist.objects || s[b].jobs.objects < jobs_full))
+        b++;
+    if (b >= e) {
+        printf("memstat: too few runs for a steady-state check\n");
+        return 0;
+    }
+    long growth = (long)s[e].rss - (long)s[b].rss;
+    long heap = (long)s[e].heap - (long)s[b].heap;
+    int flat = growth <= MEM_SOAK_SLACK && heap <= MEM_SOAK_HEAP_SLACK;
+    printf("steady state after %ld runs: rss %+ld KiB, heap %+ld KiB: %s\n",
+           s[b].runs, growth / 1024, heap / 1024, flat ? "flat" : "GROWING");
+    return !flat;
+}
+
+/**
+ * cell_memstat - Reports memory use by subsystem, or runs a soak test
+ * @args: memstat [-j] | memstat --soak [-n runs] [command...]
+ * Return: 0, 1 if the soak test saw RSS or heap grow or on bad usage
+ */
+int cell_memstat(char **args) {
+    if (!args[1]) {
+        print_human();
+        return 0;
+    }
+    if (!strcmp(args[1], "-j") || !strcmp(args[1], "--json")) {
+        print_json();
+        return 0;
+    }
+    if (!strcmp(args[1], "--soak")) {
+        long runs = MEM_SOAK_RUNS;
+        int i = 2;
+        if (args[i] && !strcmp(args[i], "-n") && args[i + 1]) {
+            runs = atol(args[i + 1]);
+            i += 2;
+        }
+        if (runs >= 1)
+            return soak(&args[i], runs);
+    }
+    fprintf(stderr, "memstat: usage: memstat [-j] | memstat --soak [-n runs] [command...]\n");
+    return 1;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include <stddef.h>
+#include <malloc.h>
+
+/*
+** memstat [-j]: bộ nhớ của shell theo phân hệ. Các cấu trúc sống lâu (lịch
+** sử, job, bộ đệm capture, biến, hàm, alias) được đếm bằng cách duyệt chúng
+** lúc hỏi, theo malloc_usable_size nên gồm cả phần làm tròn của allocator;
+** đường chạy lệnh không tốn thêm gì. Malloc/Realloc đếm số lần gọi và số
+** byte xin; tổng heap (mallinfo2) và RSS cho biết phần còn lại.
+**
+** memstat --soak [-n N] [lệnh] chạy lệnh N lần như các dòng nhập (mặc định
+** MEM_SOAK_RUNS lần một vòng trộn biến, hàm, alias, lịch sử và cứ
+** MEM_SOAK_JOB_EVERY lần một job nền), lấy MEM_SOAK_SAMPLES mẫu RSS/heap.
+** Tính từ mẫu đầu tiên mà lịch sử và danh sách job đã đầy tới mẫu cuối, RSS
+** tăng quá MEM_SOAK_SLACK hoặc heap tăng quá MEM_SOAK_HEAP_SLACK thì trả về 1.
+*/
+#define MEM_SOAK_RUNS 1000000
+#define MEM_SOAK_SAMPLES 10
+#define MEM_SOAK_JOB_EVERY 1000
+#define MEM_SOAK_SLACK (256 * 1024)
+#define MEM_SOAK_HEAP_SLACK (16 * 1024)
+
+typedef struct s_memuse {
+    size_t objects;
+    size_t bytes;
+} t_memuse;
+
+static inline size_t mem_size(const void *p) {
+    return malloc_usable_size((void *)p);
+}
+
+/* Mỗi phân hệ tự cộng phần của nó vào u (định nghĩa ở file của phân hệ) */
+void history_mem(t_memuse *u);     /* builtin.c */
+void alias_mem(t_memuse *u);       /* builtin.c */
+void jobs_mem(t_memuse *u);        /* processlist.c */
+void capture_mem(t_memuse *u);     /* capture.c */
+void vars_mem(t_memuse *u);        /* vars.c */
+void func_mem(t_memuse *u);        /* func.c */
+
+void mem_note_alloc(size_t size, int re);
+int  cell_memstat(char **args);
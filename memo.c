@@ -0,0 +1,437 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include <dirent.h>
+#include <fcntl.h>
+#include <time.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/sendfile.h>
+
+/*
+** memo - cache output của các lệnh tất định
+**
+** Khóa cache = hash(argv, cwd, các biến --env, mtime/size của các file --dep).
+** Thư mục cache ($CELL_MEMO_DIR, mặc định ~/.cache/cell/memo) gồm:
+**   objects/<hash nội dung>  stdout đã lưu, chia sẻ giữa các khóa trùng nội dung
+**   keys/<hash khóa>         "status created object size"; mtime dùng cho LRU
+** Khi tổng dung lượng objects vượt $CELL_MEMO_MAX byte (mặc định 64 MiB),
+** các khóa ít dùng gần đây nhất bị xóa trước.
+*/
+
+#define MEMO_DEFAULT_MAX (64LL << 20)
+#define MEMO_MAX_OPTS 32
+
+extern int status;
+
+static unsigned long long memo_hits, memo_misses, memo_evictions;
+
+/*
+** SHA-256 (FIPS 180-4) cho cả khóa lẫn hash nội dung: objects được định địa
+** chỉ theo nội dung nên hash phải kháng va chạm, không chỉ phân tán tốt.
+*/
+typedef struct s_hash {
+    uint32_t h[8];
+    uint64_t len;
+    unsigned char block[64];
+    size_t used;
+} t_hash;
+
+#define HASH_HEX 65
+
+static const uint32_t sha_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void sha_block(t_hash *h, const unsigned char *p) {
+    uint32_t w[64], v[8];
+    for (int i = 0; i < 16; i++)
+        w[i] = (uint32_t)p[4 * i] << 24 | (uint32_t)p[4 * i + 1] << 16
+             | (uint32_t)p[4 * i + 2] << 8 | p[4 * i + 3];
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = ROR(w[i - 15], 7) ^ ROR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = ROR(w[i - 2], 17) ^ ROR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+    memcpy(v, h->h, sizeof(v));
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = v[7] + (ROR(v[4], 6) ^ ROR(v[4], 11) ^ ROR(v[4], 25))
+                    + ((v[4] & v[5]) ^ (~v[4] & v[6])) + sha_k[i] + w[i];
+        uint32_t t2 = (ROR(v[0], 2) ^ ROR(v[0], 13) ^ ROR(v[0], 22))
+                    + ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+        memmove(v + 1, v, 7 * sizeof(*v));
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+    for (int i = 0; i < 8; i++)
+        h->h[i] += v[i];
+}
+
+static void hash_update(t_hash *h, const void *data, size_t len) {
+    const unsigned char *p = data;
+    h->len += len;
+    while (len > 0) {
+        size_t n = 64 - h->used < len ? 64 - h->used : len;
+        memcpy(h->block + h->used, p, n);
+        h->used += n;
+        p += n;
+        len -= n;
+        if (h->used == 64) {
+            sha_block(h, h->block);
+            h->used = 0;
+        }
+    }
+}
+
+static void hash_init(t_hash *h) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(h->h, iv, sizeof(iv));
+    h->len = 0;
+    h->used = 0;
+}
+
+// Kết thúc hash (thêm padding) và in ra dạng hex
+static void hash_hex(t_hash *h, char out[HASH_HEX]) {
+    uint64_t bits = h->len * 8;
+    unsigned char pad[72] = {0x80};
+    size_t npad = (h->used < 56 ? 56 : 120) - h->used;
+    for (int i = 0; i < 8; i++)
+        pad[npad + i] = (unsigned char)(bits >> (56 - 8 * i));
+    hash_update(h, pad, npad + 8);
+    for (int i = 0; i < 8; i++)
+        snprintf(out + 8 * i, HASH_HEX - 8 * i, "%08x", (unsigned)h->h[i]);
+}
+
+static void mkdir_p(const char *path) {
+    char tmp[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s", path);
+    for (char *s = tmp + 1; *s; s++) {
+        if (*s == '/') {
+            *s = '\0';
+            mkdir(tmp, 0700);
+            *s = '/';
+        }
+    }
+    mkdir(tmp, 0700);
+}
+
+static void memo_dir(char *buf, size_t size) {
+    const char *d = getenv("CELL_MEMO_DIR");
+    const char *home = getenv("HOME");
+    if (d && *d)
+        snprintf(buf, size, "%s", d);
+    else
+        snprintf(buf, size, "%s/.cache/cell/memo", home ? home : "/tmp");
+}
+
+static long long memo_max(void) {
+    const char *m = getenv("CELL_MEMO_MAX");
+    long long v = m ? atoll(m) : 0;
+    return v > 0 ? v : MEMO_DEFAULT_MAX;
+}
+
+// Gửi file đã cache ra stdout bằng sendfile (không copy qua user space)
+static int replay(const char *path) {
+    int fd = open(path, O_RDONLY);
+    struct stat sb;
+    if (fd == -1 || fstat(fd, &sb) == -1) {
+        if (fd != -1) close(fd);
+        return -1;
+    }
+    fflush(stdout);
+    off_t off = 0;
+    while (off < sb.st_size) {
+        ssize_t n = sendfile(STDOUT_FILENO, fd, &off, sb.st_size - off);
+        if (n > 0) continue;
+        if (n == -1 && errno == EINTR) continue;
+        // sendfile không hỗ trợ fd đích này: quay về read/write
+        char buf[65536];
+        ssize_t r;
+        lseek(fd, off, SEEK_SET);
+        while ((r = read(fd, buf, sizeof(buf))) > 0)
+            if (write(STDOUT_FILENO, buf, r) != r) break;
+        break;
+    }
+    close(fd);
+    return 0;
+}
+
+typedef struct s_memo_key {
+    char name[HASH_HEX];
+    char object[HASH_HEX];
+    time_t mtime;
+} t_memo_key;
+
+static int cmp_key_mtime(const void *a, const void *b) {
+    const t_memo_key *x = a, *y = b;
+    return (x->mtime > y->mtime) - (x->mtime < y->mtime);
+}
+
+static int read_entry(const char *path, int *st, time_t *created, char object[HASH_HEX]) {
+    FILE *f = fopen(path, "r");
+    if (!f) return -1;
+    long long c;
+    int ok = fscanf(f, "%d %lld %64s", st, &c, object) == 3;
+    fclose(f);
+    *created = (time_t)c;
+    return ok ? 0 : -1;
+}
+
+static long long objects_size(const char *dir) {
+    char path[PATH_MAX];
+    long long total = 0;
+    struct dirent *de;
+    struct stat sb;
+    snprintf(path, sizeof(path), "%s/objects", dir);
+    DIR *d = opendir(path);
+    if (!d) return 0;
+    while ((de = readdir(d))) {
+        if (de->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/objects/%s", dir, de->d_name);
+        if (stat(path, &sb) == 0) total += sb.st_size;
+    }
+    closedir(d);
+    return total;
+}
+
+/*
+** Xóa các khóa LRU cho tới khi tổng dung lượng objects <= giới hạn. Khóa keep
+** (vừa ghi) bị xóa sau cùng, chỉ khi riêng nó đã vượt giới hạn.
+*/
+static void evict(const char *dir, const char *keep) {
+    long long total = objects_size(dir), max = memo_max();
+    char path[PATH_MAX];
+    t_memo_key *keys = NULL;
+    int n = 0, cap = 0;
+    struct dirent *de;
+
+    if (total <= max)
+        return;
+    snprintf(path, sizeof(path), "%s/keys", dir);
+    DIR *d = opendir(path);
+    if (!d) return;
+    while ((de = readdir(d))) {
+        struct stat sb;
+        int st;
+        time_t created;
+        // bỏ qua file tạm "<khóa>.tmp"; khóa cũ (ngắn hơn) vẫn được dọn theo LRU
+        if (de->d_name[0] == '.' || strchr(de->d_name, '.')
+            || strlen(de->d_name) >= HASH_HEX) continue;
+        if (n == cap) {
+            cap = cap ? cap * 2 : 64;
+            keys = Realloc(keys, cap * sizeof(*keys));
+        }
+        snprintf(path, sizeof(path), "%s/keys/%s", dir, de->d_name);
+        if (stat(path, &sb) == -1 || read_entry(path, &st, &created, keys[n].object) == -1)
+            continue;
+        strcpy(keys[n].name, de->d_name);
+        // mtime chỉ tính theo giây: khóa vừa ghi luôn đứng cuối hàng đợi
+        keys[n].mtime = strcmp(de->d_name, keep) ? sb.st_mtime : (time_t)LLONG_MAX;
+        n++;
+    }
+    closedir(d);
+    qsort(keys, n, sizeof(*keys), cmp_key_mtime);
+    for (int i = 0; i < n && total > max; i++) {
+        snprintf(path, sizeof(path), "%s/keys/%s", dir, keys[i].name);
+        unlink(path);
+        memo_evictions++;
+        int shared = 0;
+        for (int j = i + 1; j < n; j++)
+            if (!strcmp(keys[j].object, keys[i].object)) shared = 1;
+        if (shared) continue;
+        struct stat sb;
+        snprintf(path, sizeof(path), "%s/objects/%s", dir, keys[i].object);
+        if (stat(path, &sb) == 0 && unlink(path) == 0)
+            total -= sb.st_size;
+    }
+    free(keys);
+}
+
+static int print_stats(const char *dir) {
+    int entries = 0;
+    char path[PATH_MAX];
+    struct dirent *de;
+    snprintf(path, sizeof(path), "%s/keys", dir);
+    DIR *d = opendir(path);
+    if (d) {
+        while ((de = readdir(d)))
+            if (de->d_name[0] != '.') entries++;
+        closedir(d);
+    }
+    printf("memo: %llu hits, %llu misses, %llu evictions\n",
+           memo_hits, memo_misses, memo_evictions);
+    printf("memo: %d entries, %lld/%lld bytes in %s\n",
+           entries, objects_size(dir), memo_max(), dir);
+    return 0;
+}
+
+/*
+** Chạy lệnh với stdout vào file tạm, rồi lưu file đó dưới hash nội dung.
+** Lệnh bị tín hiệu giết hoặc bị Ctrl-C ngắt chỉ có output dở dang: phát ra
+** nhưng không lưu. Tiến trình con chạy lệnh qua cell_execute nên tín hiệu
+** giết lệnh thật chỉ thấy được qua mã 128+sig, như $? của shell.
+** Return: exit status của lệnh, -1 nếu không tạo được file tạm
+*/
+static int run_and_store(const char *dir, char **cmd, const char *key_path) {
+    char tmp[PATH_MAX], object[HASH_HEX], obj_path[PATH_MAX];
+    snprintf(tmp, sizeof(tmp), "%s/objects/.tmp.XXXXXX", dir);
+    int fd = mkstemp(tmp);
+    if (fd == -1) {
+        perror("memo");
+        return -1;
+    }
+    fflush(stdout);
+    cell_interrupted = 0;
+    pid_t pid = Fork();
+    if (pid == 0) {
+        dup2(fd, STDOUT_FILENO);
+        close(fd);
+        cell_execute(cmd, 0);
+        fflush(stdout);
+        exit(status);
+    }
+    int wstatus;
+    while (waitpid(pid, &wstatus, 0) == -1 && errno == EINTR)
+        ;
+    int rc = WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus);
+    if (WIFSIGNALED(wstatus) || rc > 128 || cell_interrupted) {
+        replay(tmp);
+        unlink(tmp);
+        close(fd);
+        return rc;
+    }
+
+    t_hash h;
+    char buf[65536];
+    ssize_t r;
+    long long size = 0;
+    hash_init(&h);
+    lseek(fd, 0, SEEK_SET);
+    while ((r = read(fd, buf, sizeof(buf))) > 0) {
+        hash_update(&h, buf, r);
+        size += r;
+    }
+    close(fd);
+    hash_hex(&h, object);
+    snprintf(obj_path, sizeof(obj_path), "%s/objects/%s", dir, object);
+    if (access(obj_path, F_OK) == 0) {
+        unlink(tmp);            // nội dung đã có sẵn
+    } else if (rename(tmp, obj_path) == -1) {
+        perror("memo");         // không lưu được: vẫn trả output, bỏ cache
+        replay(tmp);
+        unlink(tmp);
+        return rc;
+    }
+
+    char key_tmp[PATH_MAX + 8];
+    snprintf(key_tmp, sizeof(key_tmp), "%s.tmp", key_path);
+    FILE *f = fopen(key_tmp, "w");
+    if (f) {
+        fprintf(f, "%d %lld %s %lld\n", rc, (long long)time(NULL), object, size);
+        if (fclose(f) == EOF || rename(key_tmp, key_path) == -1) {
+            perror("memo");
+            unlink(key_tmp);
+        }
+    }
+    // phát output trước khi dọn: evict có thể xóa chính object này
+    replay(obj_path);
+    evict(dir, strrchr(key_path, '/') + 1);
+    return rc;
+}
+
+/**
+ * cell_memo - Runs a command through an on-disk output cache
+ * @args: memo [--ttl N] [--dep FILE]... [--env VAR]... cmd args...
+ *        memo --stats
+ * Return: exit status of the (possibly cached) command
+ */
+int cell_memo(char **args) {
+    const char *deps[MEMO_MAX_OPTS], *envs[MEMO_MAX_OPTS];
+    int ndeps = 0, nenvs = 0, i = 1;
+    long ttl = 0;
+    char dir[PATH_MAX - 128], path[PATH_MAX], cwd[PATH_MAX];
+
+    memo_dir(dir, sizeof(dir));
+    for (; args[i] && !strncmp(args[i], "--", 2); i++) {
+        if (!strcmp(args[i], "--stats"))
+            return print_stats(dir);
+        if (!strcmp(args[i], "--")) {
+            i++;
+            break;
+        }
+        if (!args[i + 1])
+            break;
+        if (!strcmp(args[i], "--ttl"))
+            ttl = atol(args[++i]);
+        else if (!strcmp(args[i], "--dep") && ndeps < MEMO_MAX_OPTS)
+            deps[ndeps++] = args[++i];
+        else if (!strcmp(args[i], "--env") && nenvs < MEMO_MAX_OPTS)
+            envs[nenvs++] = args[++i];
+        else
+            break;
+    }
+    if (!args[i]) {
+        fprintf(stderr, "memo: usage: memo [--ttl N] [--dep FILE]... [--env VAR]... cmd args...\n"
+                        "       memo --stats\n");
+        return 1;
+    }
+
+    t_hash h;
+    hash_init(&h);
+    for (int k = i; args[k]; k++)
+        hash_update(&h, args[k], strlen(args[k]) + 1);
+    if (getcwd(cwd, sizeof(cwd)))
+        hash_update(&h, cwd, strlen(cwd) + 1);
+    for (int k = 0; k < nenvs; k++) {
+        const char *v = getenv(envs[k]);
+        hash_update(&h, envs[k], strlen(envs[k]) + 1);
+        hash_update(&h, v ? v : "", v ? strlen(v) + 1 : 1);
+    }
+    for (int k = 0; k < ndeps; k++) {
+        struct stat sb;
+        long long meta[3] = {-1, -1, -1};
+        if (stat(deps[k], &sb) == 0) {
+            meta[0] = sb.st_mtim.tv_sec;
+            meta[1] = sb.st_mtim.tv_nsec;
+            meta[2] = sb.st_size;
+        }
+        hash_update(&h, deps[k], strlen(deps[k]) + 1);
+        hash_update(&h, meta, sizeof(meta));
+    }
+    char key[HASH_HEX];
+    hash_hex(&h, key);
+
+    snprintf(path, sizeof(path), "%s/objects", dir);
+    mkdir_p(path);
+    snprintf(path, sizeof(path), "%s/keys", dir);
+    mkdir(path, 0700);
+    snprintf(path, sizeof(path), "%s/keys/%s", dir, key);
+
+    int st;
+    time_t created;
+    char object[HASH_HEX], obj_path[PATH_MAX];
+    if (read_entry(path, &st, &created, object) == 0
+        && (ttl <= 0 || time(NULL) - created <= ttl)) {
+        snprintf(obj_path, sizeof(obj_path), "%s/objects/%s", dir, object);
+        if (replay(obj_path) == 0) {
+            memo_hits++;
+            utimensat(AT_FDCWD, path, NULL, 0); // cập nhật thời điểm dùng cho LRU
+            return st;
+        }
+    }
+    memo_misses++;
+    int rc = run_and_store(dir, &args[i], path);
+    return rc < 0 ? 1 : rc;
+}
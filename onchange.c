@@ -0,0 +1,307 @@
+#include "cell.h"
+#include "onchange.h"
+#include "jobctl.h"
+#include "processlist.h"
+#include <dirent.h>
+#include <fnmatch.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+
+extern int status;
+extern volatile sig_atomic_t cell_interrupted;
+
+#define DIR_EVENTS  (IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB \
+                     | IN_MOVED_FROM | IN_MOVED_TO)
+#define FILE_EVENTS (IN_MODIFY | IN_CLOSE_WRITE | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF)
+
+typedef struct s_watch {
+    int wd;
+    char *path;
+} t_watch;
+
+typedef struct s_onchange {
+    int ifd;            /* inotify */
+    int tfd;            /* timerfd gộp sự kiện */
+    int recursive;
+    int debounce_ms;
+    char **excludes;    /* mẫu tên bỏ qua (-x), .git luôn bị bỏ qua */
+    int nexcl;
+    char **paths;       /* đường dẫn người dùng đưa: theo dõi lại khi file bị thay thế */
+    int npaths;
+    char **cmd;
+    t_watch *w;
+    int nw;
+    int cap;
+} t_onchange;
+
+static int excluded(t_onchange *oc, const char *name) {
+    if (!strcmp(name, ".git"))
+        return 1;
+    for (int i = 0; i < oc->nexcl; i++)
+        if (!fnmatch(oc->excludes[i], name, 0))
+            return 1;
+    return 0;
+}
+
+static int watch_find(t_onchange *oc, int wd) {
+    for (int k = 0; k < oc->nw; k++)
+        if (oc->w[k].wd == wd)
+            return k;
+    return -1;
+}
+
+static void watch_drop(t_onchange *oc, int k) {
+    free(oc->w[k].path);
+    oc->w[k] = oc->w[--oc->nw];
+}
+
+/*
+** Theo dõi path; thư mục với -r thì cả cây con (không theo symlink).
+** Return: 0, hoặc -1 (errno) nếu không theo dõi được chính path
+*/
+static int watch_add(t_onchange *oc, const char *path) {
+    struct stat st;
+    if (stat(path, &st) == -1)
+        return -1;
+    int dir = S_ISDIR(st.st_mode);
+    int wd = inotify_add_watch(oc->ifd, path, dir ? DIR_EVENTS : FILE_EVENTS);
+    if (wd == -1)
+        return -1;
+    if (watch_find(oc, wd) >= 0)
+        return 0;   /* đã theo dõi (cùng inode qua đường khác) */
+    if (oc->nw == oc->cap) {
+        oc->cap = oc->cap ? oc->cap * 2 : 16;
+        oc->w = Realloc(oc->w, oc->cap * sizeof(t_watch));
+    }
+    oc->w[oc->nw].wd = wd;
+    oc->w[oc->nw].path = strdup(path);
+    oc->nw++;
+    if (!dir || !oc->recursive)
+        return 0;
+
+    DIR *d = opendir(path);
+    struct dirent *de;
+    char sub[4096];
+    if (!d)
+        return 0;
+    while ((de = readdir(d))) {
+        if (!strcmp(de->d_name, ".") || !strcmp(de->d_name, "..") || excluded(oc, de->d_name))
+            continue;
+        snprintf(sub, sizeof(sub), "%s/%s", path, de->d_name);
+        if (de->d_type == DT_DIR || (de->d_type == DT_UNKNOWN
+                                     && !lstat(sub, &st) && S_ISDIR(st.st_mode)))
+            watch_add(oc, sub);
+    }
+    closedir(d);
+    return 0;
+}
+
+// Editor ghi file bằng cách rename file mới đè lên: watch cũ mất theo inode cũ
+static void watch_paths(t_onchange *oc) {
+    for (int i = 0; i < oc->npaths; i++) {
+        int have = 0;
+        for (int k = 0; k < oc->nw && !have; k++)
+            have = !strcmp(oc->w[k].path, oc->paths[i]);
+        if (!have)
+            watch_add(oc, oc->paths[i]);
+    }
+}
+
+// Đọc hết sự kiện đang chờ; return 1 nếu có thay đổi cần chạy lại lệnh
+static int read_events(t_onchange *oc) {
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    char sub[4096];
+    int changed = 0;
+    ssize_t n;
+
+    while ((n = read(oc->ifd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n; ) {
+            struct inotify_event *ev = (struct inotify_event *)p;
+            p += sizeof(*ev) + ev->len;
+            if (ev->mask & IN_Q_OVERFLOW) {
+                changed = 1;    /* mất sự kiện: coi như có thay đổi */
+                continue;
+            }
+            int k = watch_find(oc, ev->wd);
+            if (k < 0)
+                continue;
+            if (ev->mask & IN_IGNORED) {
+                watch_drop(oc, k);
+                changed = 1;
+                continue;
+            }
+            if (ev->len && excluded(oc, ev->name))
+                continue;
+            if (oc->recursive && (ev->mask & IN_ISDIR) && (ev->mask & (IN_CREATE | IN_MOVED_TO))) {
+                snprintf(sub, sizeof(sub), "%s/%s", oc->w[k].path, ev->name);
+                watch_add(oc, sub);
+            }
+            changed = 1;
+        }
+    }
+    return changed;
+}
+
+static void arm_ms(int tfd, int ms) {
+    struct itimerspec its = {0};
+    its.it_value.tv_sec = ms / 1000;
+    its.it_value.tv_nsec = (ms % 1000) * 1000000L;
+    if (!ms)
+        its.it_value.tv_nsec = 1;
+    timerfd_settime(tfd, 0, &its, NULL);
+}
+
+// Chạy lệnh như một job riêng (nhóm tiến trình riêng), shell giữ terminal
+static bg_proc *run_start(t_onchange *oc) {
+    char label[256];
+    job_label(label, sizeof(label), oc->cmd);
+    fflush(stdout);
+    pid_t pid = Fork();
+    if (pid == 0) {
+        job_child(0, 0);
+        close(oc->ifd);
+        close(oc->tfd);
+        // một từ là cả dòng lệnh shell: onchange src -- 'make && ./test'
+        if (!oc->cmd[1])
+            cell_run_line(strdup(oc->cmd[0]));
+        else
+            cell_execute(oc->cmd, 0);
+        fflush(stdout);
+        exit(status);
+    }
+    job_setpgid(pid, 0);
+    return job_new(pid, &pid, 1, label);
+}
+
+// Hủy lần chạy đang dở: TERM cho cả nhóm, quá hạn thì KILL
+static int run_kill(bg_proc *run) {
+    struct pollfd pfd = { .fd = run->pidfds[0], .events = POLLIN };
+    job_signal(run, SIGTERM);
+    job_signal(run, SIGCONT);
+    if (pfd.fd != -1)
+        poll(&pfd, 1, ONCHANGE_KILL_GRACE_MS);
+    if (!bg_reap(run, 0))
+        job_signal(run, SIGKILL);
+    while (!bg_reap(run, 1))
+        ;
+    int code = run->exit_code;
+    job_free(run);
+    return code;
+}
+
+static int usage(void) {
+    fprintf(stderr, "onchange: usage: onchange [-r] [-k] [-i] [-d ms] [-n runs] [-x glob]... "
+            "paths... -- cmd...\n");
+    return 2;
+}
+
+/**
+ * cell_onchange - Re-runs a command whenever watched paths change
+ * @args: onchange [-r] [-k] [-i] [-d ms] [-n runs] [-x glob]... paths... -- cmd...
+ *        -r watch directories recursively, -k cancel a still-running run
+ *        instead of queueing, -i run once at start, -d quiet time before a
+ *        run, -n stop after that many runs, -x ignore names matching glob
+ * Return: Exit status of the last run, 130 when stopped by Ctrl-C
+ */
+int cell_onchange(char **args) {
+    t_onchange oc = { .ifd = -1, .tfd = -1, .debounce_ms = ONCHANGE_DEBOUNCE_MS };
+    int cancel = 0, pending = 0, max_runs = 0, runs = 0, rc = 0, i = 1;
+    bg_proc *run = NULL;
+
+    for (; args[i] && args[i][0] == '-' && strcmp(args[i], "--"); i++) {
+        const char *opt = args[i];
+        if (!strcmp(opt, "-r")) oc.recursive = 1;
+        else if (!strcmp(opt, "-k")) cancel = 1;
+        else if (!strcmp(opt, "-i")) pending = 1;
+        else if (!strcmp(opt, "-d") && args[i + 1]) oc.debounce_ms = atoi(args[++i]);
+        else if (!strcmp(opt, "-n") && args[i + 1]) max_runs = atoi(args[++i]);
+        else if (!strcmp(opt, "-x") && args[i + 1]) {
+            oc.excludes = Realloc(oc.excludes, (oc.nexcl + 1) * sizeof(char *));
+            oc.excludes[oc.nexcl++] = args[++i];
+        } else {
+            free(oc.excludes);
+            return usage();
+        }
+    }
+    oc.paths = &args[i];
+    while (args[i] && strcmp(args[i], "--"))
+        i++;
+    oc.npaths = &args[i] - oc.paths;
+    if (!args[i] || !args[i + 1] || oc.npaths == 0 || oc.debounce_ms < 0) {
+        free(oc.excludes);
+        return usage();
+    }
+    oc.cmd = &args[i + 1];
+
+    oc.ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    oc.tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (oc.ifd == -1 || oc.tfd == -1) {
+        perror("onchange");
+        rc = 1;
+        goto out;
+    }
+    for (int k = 0; k < oc.npaths; k++) {
+        if (watch_add(&oc, oc.paths[k]) == -1) {
+            fprintf(stderr, "onchange: %s: %s\n", oc.paths[k], strerror(errno));
+            rc = 1;
+            goto out;
+        }
+    }
+
+    while (!cell_interrupted) {
+        if (!run && pending && (!max_runs || runs < max_runs)) {
+            run = run_start(&oc);
+            runs++;
+            pending = 0;
+        }
+        if (!run && max_runs && runs >= max_runs)
+            break;
+        struct pollfd pfd[3] = {
+            { .fd = oc.ifd, .events = POLLIN },
+            { .fd = oc.tfd, .events = POLLIN },
+            { .fd = run ? run->pidfds[0] : -1, .events = POLLIN },
+        };
+        // không có pidfd thì hỏi lại trạng thái lần chạy định kỳ
+        if (poll(pfd, 3, run && pfd[2].fd == -1 ? 100 : -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            perror("onchange: poll");
+            rc = 1;
+            break;
+        }
+        if (run && bg_reap(run, 0)) {
+            rc = run->exit_code;
+            job_free(run);
+            run = NULL;
+        }
+        if ((pfd[0].revents & POLLIN) && read_events(&oc))
+            arm_ms(oc.tfd, oc.debounce_ms);     /* mỗi sự kiện dời mốc chạy ra sau */
+        if (pfd[1].revents & POLLIN) {
+            uint64_t ticks;
+            read(oc.tfd, &ticks, sizeof(ticks));
+            watch_paths(&oc);
+            pending = 1;
+            if (run && cancel) {
+                rc = run_kill(run);
+                run = NULL;
+            }
+        }
+    }
+    if (run) {
+        run_kill(run);
+        rc = 128 + SIGINT;
+    } else if (cell_interrupted) {
+        rc = 128 + SIGINT;
+    }
+out:
+    if (oc.ifd != -1) close(oc.ifd);
+    if (oc.tfd != -1) close(oc.tfd);
+    for (int k = 0; k < oc.nw; k++)
+        free(oc.w[k].path);
+    free(oc.w);
+    free(oc.excludes);
+    return rc;
+}
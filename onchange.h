@@ -0,0 +1,15 @@
+#pragma once
+
+/*
+** onchange [-r] [-k] [-i] [-d ms] [-n runs] [-x glob]... paths... -- cmd...
+**
+** Theo dõi file/thư mục bằng inotify và chạy lại lệnh mỗi khi có thay đổi,
+** không polling. Một loạt sự kiện liền nhau (editor ghi file, git checkout)
+** được gộp lại: lệnh chỉ chạy khi đã yên ONCHANGE_DEBOUNCE_MS. Lần chạy
+** trước chưa xong thì mặc định xếp hàng một lần chạy nữa; -k thì hủy nó
+** (SIGTERM cho cả nhóm, sau ONCHANGE_KILL_GRACE_MS thì SIGKILL).
+*/
+#define ONCHANGE_DEBOUNCE_MS 50
+#define ONCHANGE_KILL_GRACE_MS 1000
+
+int cell_onchange(char **args);
@@ -0,0 +1,887 @@
+#include "cell.h"
+#include "parse.h"
+#include "vars.h"
+#include "processlist.h"
+#include "pipeprof.h"
+#include "timeout.h"
+#include "jobctl.h"
+#include "func.h"
+#include "redir.h"
+#include "memacct.h"
+#include <fnmatch.h>
+#include <ctype.h>
+
+/*
+** Parser đệ quy xuống cho if/while/until/for/case và danh sách ; & && ||,
+** cùng bộ thực thi chạy trên cây đó ngay trong tiến trình shell. Builtin
+** trong thân vòng lặp không fork; chỉ lệnh ngoài mới sinh tiến trình.
+**
+**   list     := andor ((";" | "\n" | "&") andor)*
+**   andor    := pipeline (("&&" | "||") pipeline)*
+**   pipeline := ["!"] command ("|" command)*
+**   command  := (if | while | until | for | case | ((expr)) | { list; }) redir*
+**             | name() command | function name command | simple
+*/
+
+extern int status;
+
+typedef struct s_parser {
+    char **tok;
+    int pos;
+    int state;
+} t_parser;
+
+static int loop_depth = 0;
+static int loop_break = 0;     /* số vòng lặp còn phải thoát do break N */
+static int loop_cont = 0;      /* continue N */
+
+static const char *reserved[] = { "then", "elif", "else", "fi", "do", "done",
+                                  "esac", "in", "}", NULL };
+
+static t_node *parse_list(t_parser *p, const char **stops);
+static t_node *parse_command(t_parser *p);
+
+/* ---------------------------------------------------------------------- */
+/* Parser                                                                  */
+/* ---------------------------------------------------------------------- */
+
+static const char *cur(t_parser *p) {
+    return p->tok[p->pos];
+}
+
+static int at(t_parser *p, const char *s) {
+    return cur(p) && !strcmp(cur(p), s);
+}
+
+static int in_set(const char *t, const char **set) {
+    for (int i = 0; set && set[i]; i++)
+        if (!strcmp(t, set[i]))
+            return 1;
+    return 0;
+}
+
+static int is_separator(const char *t) {
+    static const char *ops[] = { ";", "\n", "&", "&&", "||", ";;", NULL };
+    return in_set(t, ops);
+}
+
+static int is_arith_word(const char *t) {
+    size_t n = strlen(t);
+    return n >= 4 && !strncmp(t, "((", 2) && !strcmp(t + n - 2, "))");
+}
+
+static int starts_compound(const char *t) {
+    static const char *kw[] = { "if", "while", "until", "for", "case", "{", NULL };
+    return in_set(t, kw) || is_arith_word(t);
+}
+
+static void skip_newlines(t_parser *p) {
+    while (at(p, "\n")) p->pos++;
+}
+
+// Hết token giữa chừng = dòng chưa xong (đọc tiếp dòng sau), còn lại là lỗi
+static void syntax_error(t_parser *p) {
+    if (p->state != PARSE_OK)
+        return;
+    if (!cur(p)) {
+        p->state = PARSE_INCOMPLETE;
+        return;
+    }
+    const char *t = cur(p) + (redir_is_op(cur(p)) || cur(p)[0] == PIPE_MARK);
+    fprintf(stderr, "cell: syntax error near unexpected token `%s'\n",
+            strcmp(t, "\n") ? t : "newline");
+    p->state = PARSE_ERROR;
+}
+
+static int expect(t_parser *p, const char *kw) {
+    if (at(p, kw)) {
+        p->pos++;
+        return 1;
+    }
+    syntax_error(p);
+    return 0;
+}
+
+static t_node *node_new(t_node_type type) {
+    t_node *n = Malloc(sizeof(*n));
+    memset(n, 0, sizeof(*n));
+    n->type = type;
+    return n;
+}
+
+static void add_kid(t_node *n, t_node *kid, int op) {
+    n->kids = Realloc(n->kids, (n->nkids + 1) * sizeof(t_node *));
+    n->ops = Realloc(n->ops, (n->nkids + 1) * sizeof(int));
+    n->kids[n->nkids] = kid;
+    n->ops[n->nkids++] = op;
+}
+
+static void push_word(char ***words, int *n, const char *w) {
+    *words = Realloc(*words, (*n + 2) * sizeof(char *));
+    (*words)[(*n)++] = strdup(w);
+    (*words)[*n] = NULL;
+}
+
+static t_node *parse_simple(t_parser *p) {
+    t_node *n = node_new(N_CMD);
+    int nw = 0, dbl = 0;
+
+    while (cur(p)) {
+        if (dbl) {
+            // && || < > bên trong [[ ]] là toán tử của test
+            if (at(p, "]]")) dbl = 0;
+        } else if (is_separator(cur(p))) {
+            break;
+        } else if (at(p, PIPE_OP)) {
+            // pipeline toàn lệnh đơn đi đường cell_pipe cũ; gặp lệnh phức
+            // thì dừng để parse_pipeline dựng N_PIPE
+            int k = p->pos + 1;
+            while (p->tok[k] && !strcmp(p->tok[k], "\n")) k++;
+            if (!p->tok[k] || starts_compound(p->tok[k]))
+                break;
+            push_word(&n->words, &nw, PIPE_OP);
+            p->pos = k;
+            continue;
+        } else if (nw == 0 && at(p, "[[")) {
+            dbl = 1;
+        }
+        push_word(&n->words, &nw, cur(p));
+        p->pos++;
+    }
+    return n;
+}
+
+static t_node *parse_if(t_parser *p) {
+    static const char *then_stop[] = { "then", NULL };
+    static const char *body_stop[] = { "elif", "else", "fi", NULL };
+    static const char *fi_stop[] = { "fi", NULL };
+    t_node *n = node_new(N_IF);
+
+    p->pos++;   /* if / elif */
+    n->cond = parse_list(p, then_stop);
+    if (p->state || !expect(p, "then")) return n;
+    n->body = parse_list(p, body_stop);
+    if (p->state) return n;
+    if (at(p, "elif")) {
+        n->els = parse_if(p);   /* elif lồng nhau tự tiêu thụ "fi" */
+    } else if (at(p, "else")) {
+        p->pos++;
+        n->els = parse_list(p, fi_stop);
+        if (!p->state) expect(p, "fi");
+    } else {
+        expect(p, "fi");
+    }
+    return n;
+}
+
+static t_node *parse_loop(t_parser *p, t_node_type type) {
+    static const char *do_stop[] = { "do", NULL };
+    static const char *done_stop[] = { "done", NULL };
+    t_node *n = node_new(type);
+
+    p->pos++;
+    if (type == N_WHILE || type == N_UNTIL) {
+        n->cond = parse_list(p, do_stop);
+        if (p->state) return n;
+    }
+    if (!expect(p, "do")) return n;
+    n->body = parse_list(p, done_stop);
+    if (!p->state) expect(p, "done");
+    return n;
+}
+
+// for ((init; test; step)): tách tại ';' ở mức ngoặc 0
+static int split_arith_for(t_node *n, const char *w) {
+    char *body = strndup(w + 2, strlen(w) - 4);
+    char *part[3] = { body, NULL, NULL };
+    int k = 0, depth = 0;
+    for (char *c = body; *c; c++) {
+        if (*c == '(') depth++;
+        else if (*c == ')') depth--;
+        else if (*c == ';' && depth == 0) {
+            if (k == 2) break;
+            *c = '\0';
+            part[++k] = c + 1;
+        }
+    }
+    if (k != 2) {
+        free(body);
+        return 0;
+    }
+    n->init = strdup(part[0]);
+    n->test = strdup(part[1]);
+    n->step = strdup(part[2]);
+    free(body);
+    return 1;
+}
+
+static t_node *parse_for(t_parser *p) {
+    t_node *n = node_new(N_FOR);
+    int nw = 0;
+
+    p->pos++;
+    if (!cur(p)) {
+        syntax_error(p);
+        return n;
+    }
+    if (is_arith_word(cur(p))) {
+        n->type = N_ARITH_FOR;
+        if (!split_arith_for(n, cur(p))) {
+            fprintf(stderr, "cell: for ((...)): expected init; test; step\n");
+            p->state = PARSE_ERROR;
+            return n;
+        }
+        p->pos++;
+    } else {
+        if (!var_valid_name(cur(p), strlen(cur(p)))) {
+            syntax_error(p);
+            return n;
+        }
+        n->name = strdup(cur(p));
+        p->pos++;
+        skip_newlines(p);
+        if (at(p, "in")) {
+            p->pos++;
+            n->words = Malloc(sizeof(char *));
+            n->words[0] = NULL;
+            while (cur(p) && !at(p, ";") && !at(p, "\n")) {
+                if (is_separator(cur(p)) || at(p, PIPE_OP)) {
+                    syntax_error(p);
+                    return n;
+                }
+                push_word(&n->words, &nw, cur(p));
+                p->pos++;
+            }
+        }
+    }
+    while (at(p, ";") || at(p, "\n")) p->pos++;
+    static const char *done_stop[] = { "done", NULL };
+    if (!expect(p, "do")) return n;
+    n->body = parse_list(p, done_stop);
+    if (!p->state) expect(p, "done");
+    return n;
+}
+
+/*
+** case WORD in [(]pat[|pat]...) list ;; ... esac
+** Tokenizer tách "|" nên "a|b)" tới đây là "a" PIPE_OP "b)".
+*/
+static t_node *parse_case(t_parser *p) {
+    static const char *item_stop[] = { ";;", "esac", NULL };
+    t_node *n = node_new(N_CASE);
+
+    p->pos++;
+    if (!cur(p) || is_separator(cur(p))) {
+        syntax_error(p);
+        return n;
+    }
+    n->name = strdup(cur(p));
+    p->pos++;
+    skip_newlines(p);
+    if (!expect(p, "in")) return n;
+    while (!p->state) {
+        while (at(p, "\n") || at(p, ";")) p->pos++;
+        if (at(p, "esac")) {
+            p->pos++;
+            return n;
+        }
+        if (!cur(p)) {
+            syntax_error(p);
+            return n;
+        }
+        t_case_item item = {0};
+        int np = 0, closed = 0;
+        if (at(p, "(")) p->pos++;
+        while (cur(p) && !closed) {
+            const char *t = cur(p);
+            size_t len = strlen(t);
+            p->pos++;
+            if (!strcmp(t, ")")) {
+                closed = 1;
+            } else if (t[len - 1] == ')') {
+                char *pat = strndup(t, len - 1);
+                push_word(&item.patterns, &np, pat);
+                free(pat);
+                closed = 1;
+            } else if (strcmp(t, PIPE_OP)) {
+                push_word(&item.patterns, &np, t);
+            }
+        }
+        if (!closed || np == 0) {
+            free_args(item.patterns);
+            syntax_error(p);
+            return n;
+        }
+        item.body = parse_list(p, item_stop);
+        n->items = Realloc(n->items, (n->nitems + 1) * sizeof(t_case_item));
+        n->items[n->nitems++] = item;
+        if (p->state) return n;
+        if (at(p, ";;")) p->pos++;
+    }
+    return n;
+}
+
+static t_node *parse_group(t_parser *p) {
+    static const char *group_stop[] = { "}", NULL };
+    t_node *n = node_new(N_GROUP);
+
+    p->pos++;
+    n->body = parse_list(p, group_stop);
+    if (!p->state) expect(p, "}");
+    return n;
+}
+
+// Tên hàm: như tên biến, cho phép thêm '-', '.', ':' (git-log, ns.fn)
+static int valid_func_name(const char *s, size_t len) {
+    if (len == 0 || isdigit((unsigned char)s[0]))
+        return 0;
+    for (size_t i = 0; i < len; i++)
+        if (!isalnum((unsigned char)s[i]) && !strchr("_-.:", s[i]))
+            return 0;
+    return 1;
+}
+
+// "name()" hoặc "name" "()" ở đầu lệnh
+static int is_funcdef(t_parser *p) {
+    const char *t = cur(p);
+    size_t n = strlen(t);
+    if (n > 2 && !strcmp(t + n - 2, "()"))
+        return valid_func_name(t, n - 2);
+    return p->tok[p->pos + 1] && !strcmp(p->tok[p->pos + 1], "()") && valid_func_name(t, n);
+}
+
+/*
+** name() compound  |  function name [()] compound
+** Thân hàm là một lệnh phức, thường là { ...; }.
+*/
+static t_node *parse_funcdef(t_parser *p) {
+    t_node *n = node_new(N_FUNCDEF);
+
+    if (at(p, "function")) {
+        p->pos++;
+        if (!cur(p)) {
+            syntax_error(p);
+            return n;
+        }
+    }
+    const char *t = cur(p);
+    size_t len = strlen(t);
+    if (len > 2 && !strcmp(t + len - 2, "()"))
+        len -= 2;
+    if (!valid_func_name(t, len)) {
+        syntax_error(p);
+        return n;
+    }
+    n->name = strndup(t, len);
+    p->pos++;
+    if (at(p, "()")) p->pos++;
+    skip_newlines(p);
+    if (!cur(p) || !starts_compound(cur(p))) {
+        syntax_error(p);
+        return n;
+    }
+    n->body = parse_command(p);
+    return n;
+}
+
+// Chuyển hướng sau lệnh phức: done < file, } > out 2>&1
+static void parse_redirs(t_parser *p, t_node *n) {
+    int nr = 0;
+    while (!p->state && cur(p) && redir_is_op(cur(p))) {
+        const char *target = p->tok[p->pos + 1];
+        p->pos++;
+        if (!target || is_separator(target) || !strcmp(target, PIPE_OP) || redir_is_op(target)) {
+            if (!target) {
+                fprintf(stderr, "cell: syntax error near unexpected token `newline'\n");
+                p->state = PARSE_ERROR;
+            }
+            syntax_error(p);
+            return;
+        }
+        push_word(&n->redirs, &nr, p->tok[p->pos - 1]);
+        push_word(&n->redirs, &nr, target);
+        p->pos++;
+    }
+}
+
+static t_node *parse_command(t_parser *p) {
+    const char *t = cur(p);
+    t_node *n;
+
+    if (!t || in_set(t, reserved) || is_separator(t) || !strcmp(t, PIPE_OP)) {
+        syntax_error(p);
+        return NULL;
+    }
+    if (!strcmp(t, "if")) n = parse_if(p);
+    else if (!strcmp(t, "while")) n = parse_loop(p, N_WHILE);
+    else if (!strcmp(t, "until")) n = parse_loop(p, N_UNTIL);
+    else if (!strcmp(t, "for")) n = parse_for(p);
+    else if (!strcmp(t, "case")) n = parse_case(p);
+    else if (!strcmp(t, "{")) n = parse_group(p);
+    else if (!strcmp(t, "function") || is_funcdef(p)) return parse_funcdef(p);
+    else if (is_arith_word(t)) {
+        n = node_new(N_ARITH);
+        n->name = strndup(t + 2, strlen(t) - 4);
+        p->pos++;
+    } else {
+        return parse_simple(p);
+    }
+    parse_redirs(p, n);
+    return n;
+}
+
+static t_node *parse_pipeline(t_parser *p) {
+    int neg = 0;
+    if (at(p, "!")) {
+        neg = 1;
+        p->pos++;
+    }
+    t_node *n = parse_command(p);
+    if (n && !p->state && at(p, PIPE_OP)) {
+        t_node *pipe = node_new(N_PIPE);
+        add_kid(pipe, n, 0);
+        while (!p->state && at(p, PIPE_OP)) {
+            p->pos++;
+            skip_newlines(p);
+            t_node *st = parse_command(p);
+            if (!st) break;
+            add_kid(pipe, st, 0);
+        }
+        n = pipe;
+    }
+    if (neg && n) {
+        t_node *not = node_new(N_NOT);
+        not->body = n;
+        n = not;
+    }
+    return n;
+}
+
+static t_node *parse_andor(t_parser *p) {
+    t_node *first = parse_pipeline(p);
+    if (!first || p->state || !(at(p, "&&") || at(p, "||")))
+        return first;
+    t_node *n = node_new(N_ANDOR);
+    add_kid(n, first, 0);
+    while (!p->state && (at(p, "&&") || at(p, "||"))) {
+        int op = cur(p)[0];
+        p->pos++;
+        skip_newlines(p);
+        t_node *k = parse_pipeline(p);
+        if (!k) break;
+        add_kid(n, k, op);
+    }
+    return n;
+}
+
+static t_node *parse_list(t_parser *p, const char **stops) {
+    t_node *n = node_new(N_LIST);
+
+    for (;;) {
+        while (at(p, ";") || at(p, "\n")) p->pos++;
+        if (!cur(p) || in_set(cur(p), stops))
+            break;
+        t_node *a = parse_andor(p);
+        if (a) add_kid(n, a, 0);
+        if (p->state) break;
+        if (at(p, "&")) {
+            n->ops[n->nkids - 1] = 1;
+            p->pos++;
+        } else if (at(p, ";") || at(p, "\n")) {
+            p->pos++;
+        } else if (cur(p) && !in_set(cur(p), stops)) {
+            syntax_error(p);
+            break;
+        }
+    }
+    return n;
+}
+
+/**
+ * parse_line - Parses a (possibly multi-line) command line into a tree
+ * @line: Source text
+ * @out: Receives the tree (free with free_node, even on error)
+ * Return: PARSE_OK, PARSE_INCOMPLETE if more input is needed, PARSE_ERROR
+ */
+int parse_line(char *line, t_node **out) {
+    t_parser p = { .tok = cell_split_line(line) };
+    *out = parse_list(&p, NULL);
+    if (p.state == PARSE_OK && cur(&p))
+        syntax_error(&p);
+    free_args(p.tok);
+    return p.state;
+}
+
+void free_node(t_node *n) {
+    if (!n) return;
+    if (n->refs > 0) {
+        n->refs--;      /* thân hàm vẫn còn trong bảng hàm */
+        return;
+    }
+    free_args(n->words);
+    free_args(n->redirs);
+    free(n->name);
+    free(n->init);
+    free(n->test);
+    free(n->step);
+    free_node(n->cond);
+    free_node(n->body);
+    free_node(n->els);
+    for (int i = 0; i < n->nkids; i++)
+        free_node(n->kids[i]);
+    free(n->kids);
+    free(n->ops);
+    for (int i = 0; i < n->nitems; i++) {
+        free_args(n->items[i].patterns);
+        free_node(n->items[i].body);
+    }
+    free(n->items);
+    free(n);
+}
+
+static size_t args_bytes(char **v) {
+    size_t b = 0;
+    if (!v) return 0;
+    for (int i = 0; v[i]; i++)
+        b += mem_size(v[i]);
+    return b + mem_size(v);
+}
+
+// Byte heap của một cây (memstat: thân hàm), cùng các trường free_node giải phóng
+size_t node_bytes(const t_node *n) {
+    if (!n) return 0;
+    size_t b = mem_size(n) + args_bytes(n->words) + args_bytes(n->redirs)
+             + mem_size(n->name) + mem_size(n->init) + mem_size(n->test) + mem_size(n->step)
+             + node_bytes(n->cond) + node_bytes(n->body) + node_bytes(n->els)
+             + mem_size(n->kids) + mem_size(n->ops) + mem_size(n->items);
+    for (int i = 0; i < n->nkids; i++)
+        b += node_bytes(n->kids[i]);
+    for (int i = 0; i < n->nitems; i++)
+        b += args_bytes(n->items[i].patterns) + node_bytes(n->items[i].body);
+    return b;
+}
+
+/* ---------------------------------------------------------------------- */
+/* Thực thi                                                                */
+/* ---------------------------------------------------------------------- */
+
+bool flow_interrupted(void) {
+    return loop_break || loop_cont || cell_interrupted || func_returning();
+}
+
+static const char *node_label(t_node *n) {
+    static const char *names[] = { [N_PIPE] = "pipeline", [N_LIST] = "list",
+        [N_ANDOR] = "list", [N_NOT] = "!", [N_IF] = "if", [N_WHILE] = "while",
+        [N_UNTIL] = "until", [N_FOR] = "for", [N_ARITH_FOR] = "for",
+        [N_CASE] = "case", [N_ARITH] = "((", [N_GROUP] = "{", [N_FUNCDEF] = "function" };
+    if (n->type == N_CMD)
+        return n->words && n->words[0] ? n->words[0] : "";
+    return names[n->type];
+}
+
+// Lệnh phức chạy nền: một tiến trình con thực thi cây rồi thoát
+static void run_background(t_node *n) {
+    if (n->type == N_CMD) {
+        cell_run_words(n->words, 1);
+        return;
+    }
+    pid_t pid = Fork();
+    if (pid == 0) {
+        job_child(0, 0);
+        exit(exec_node(n));
+    }
+    job_setpgid(pid, 0);
+    bg_proc *job = add_bg_proc(pid, node_label(n));
+    printf("[%d] Background pid %d\n", job->id, pid);
+    status = 0;
+}
+
+// Pipeline có stage là lệnh phức: mỗi stage là một tiến trình con của shell
+static int exec_pipe(t_node *n) {
+    pid_t pids[MAX_PIPE_STAGES], pgid = 0;
+    int prev_in = -1, np = n->nkids < MAX_PIPE_STAGES ? n->nkids : MAX_PIPE_STAGES;
+
+    for (int k = 0; k < np; k++) {
+        int fd[2] = {-1, -1};
+        if (k < np - 1)
+            pipe(fd);
+        pids[k] = Fork();
+        if (pids[k] == 0) {
+            job_child(pgid, 1);
+            if (prev_in != -1) {
+                dup2(prev_in, STDIN_FILENO);
+                close(prev_in);
+                readbuf_own(STDIN_FILENO);  /* chỉ stage này đọc pipe */
+            }
+            if (fd[1] != -1) {
+                dup2(fd[1], STDOUT_FILENO);
+                close(fd[0]);
+                close(fd[1]);
+            }
+            exit(exec_node(n->kids[k]));
+        }
+        job_setpgid(pids[k], pgid);
+        if (!pgid)
+            pgid = pids[k];
+        if (prev_in != -1) close(prev_in);
+        if (fd[1] != -1) close(fd[1]);
+        prev_in = fd[0];
+    }
+    if (timeout_active()) {
+        job_tty_give(pgid);
+        status = timeout_wait(pids, np, "pipeline");
+        job_tty_take();
+        return status;
+    }
+    return status = job_wait_fg(job_new(pgid, pids, np, "pipeline"), 0);
+}
+
+/*
+** Sau thân vòng lặp: trả 1 nếu phải thoát vòng này. break/continue N > 1
+** được giảm dần và truyền ra vòng ngoài.
+*/
+static int loop_should_exit(void) {
+    if (cell_interrupted || func_returning())
+        return 1;
+    if (loop_break) {
+        loop_break--;
+        return 1;
+    }
+    if (loop_cont) {
+        if (--loop_cont > 0) return 1;
+    }
+    return 0;
+}
+
+static int exec_loop(t_node *n) {
+    int last = 0;
+    loop_depth++;
+    for (;;) {
+        exec_node(n->cond);
+        if (flow_interrupted()) {
+            loop_should_exit();
+            break;
+        }
+        if ((status == 0) != (n->type == N_WHILE))
+            break;
+        last = exec_node(n->body);
+        if (loop_should_exit())
+            break;
+    }
+    loop_depth--;
+    return status = last;
+}
+
+static int exec_for(t_node *n) {
+    int last = 0;
+    char **vals;
+
+    if (n->words) {
+        vals = cell_expand(n->words);
+        if (expand_failed) {
+            free_args(vals);
+            return status = 1;
+        }
+    } else {
+        // for x; do ... : lặp trên các tham số vị trí "$@"
+        vals = Malloc((var_argc() + 1) * sizeof(char *));
+        for (int i = 0; i < var_argc(); i++)
+            vals[i] = strdup(var_arg(i + 1));
+        vals[var_argc()] = NULL;
+    }
+
+    loop_depth++;
+    for (int i = 0; vals[i]; i++) {
+        var_set(n->name, vals[i]);
+        last = exec_node(n->body);
+        if (loop_should_exit())
+            break;
+    }
+    loop_depth--;
+    free_args(vals);
+    return status = last;
+}
+
+static int exec_arith_for(t_node *n) {
+    long long v;
+    int last = 0;
+
+    if (arith_expand_eval(n->init, &v))
+        return status = 1;
+    loop_depth++;
+    for (;;) {
+        // biểu thức test rỗng = luôn đúng
+        if (arith_expand_eval(n->test, &v)) { last = 1; break; }
+        if (n->test[strspn(n->test, " \t")] && v == 0)
+            break;
+        last = exec_node(n->body);
+        if (loop_should_exit())
+            break;
+        if (arith_expand_eval(n->step, &v)) { last = 1; break; }
+    }
+    loop_depth--;
+    return status = last;
+}
+
+// Mở rộng một từ đơn (chữ của case / mẫu), các trường nối lại bằng dấu cách
+static char *expand_one(const char *w) {
+    char *in[] = { (char *)w, NULL };
+    char **f = cell_expand(in);
+    t_str s = {0};
+    str_puts(&s, "");
+    for (int i = 0; f[i]; i++) {
+        if (i) str_putc(&s, ' ');
+        str_puts(&s, f[i]);
+    }
+    free_args(f);
+    return s.s;
+}
+
+static int exec_case(t_node *n) {
+    char *word = expand_one(n->name);
+    status = 0;
+    for (int i = 0; i < n->nitems; i++) {
+        for (int k = 0; n->items[i].patterns[k]; k++) {
+            char *pat = expand_one(n->items[i].patterns[k]);
+            int m = !fnmatch(pat, word, 0);
+            free(pat);
+            if (m) {
+                exec_node(n->items[i].body);
+                free(word);
+                return status;
+            }
+        }
+    }
+    free(word);
+    return status;
+}
+
+static int exec_plain(t_node *n) {
+    switch (n->type) {
+    case N_CMD:
+        cell_run_words(n->words, 0);
+        break;
+    case N_PIPE:
+        exec_pipe(n);
+        break;
+    case N_LIST:
+        for (int i = 0; i < n->nkids && !flow_interrupted(); i++) {
+            if (n->ops[i]) run_background(n->kids[i]);
+            else exec_node(n->kids[i]);
+        }
+        break;
+    case N_ANDOR:
+        exec_node(n->kids[0]);
+        for (int i = 1; i < n->nkids && !flow_interrupted(); i++) {
+            // && chạy khi lệnh trước thành công, || khi thất bại
+            if ((n->ops[i] == '&') == (status == 0))
+                exec_node(n->kids[i]);
+        }
+        break;
+    case N_NOT:
+        exec_node(n->body);
+        status = !status;
+        break;
+    case N_IF:
+        exec_node(n->cond);
+        if (flow_interrupted())
+            break;
+        if (status == 0)
+            exec_node(n->body);
+        else if (n->els)
+            exec_node(n->els);
+        else
+            status = 0;
+        break;
+    case N_WHILE:
+    case N_UNTIL:
+        exec_loop(n);
+        break;
+    case N_FOR:
+        exec_for(n);
+        break;
+    case N_ARITH_FOR:
+        exec_arith_for(n);
+        break;
+    case N_CASE:
+        exec_case(n);
+        break;
+    case N_ARITH: {
+        long long v;
+        status = arith_expand_eval(n->name, &v) ? 1 : v == 0;
+        break;
+    }
+    case N_GROUP:
+        exec_node(n->body);
+        break;
+    case N_FUNCDEF:
+        func_define(n->name, n->body);
+        status = 0;
+        break;
+    }
+    return status;
+}
+
+/**
+ * exec_node - Executes a parsed tree in the shell process
+ * @n: Tree from parse_line
+ * Return: Exit status of the last command run (also stored in status)
+ */
+int exec_node(t_node *n) {
+    if (!n)
+        return status;
+    if (!n->redirs)
+        return exec_plain(n);
+    // lệnh phức có chuyển hướng: fd được đổi quanh cả thân rồi trả lại
+    char **r = cell_expand(n->redirs);
+    if (expand_failed) {
+        free_args(r);
+        return status = 1;
+    }
+    int subs = procsub_expand(r), mark = redir_mark();
+    if (redir_apply(r, 1) == -1)
+        status = 1;
+    else
+        exec_plain(n);
+    redir_undo(mark);
+    procsub_finish(subs);
+    free_args(r);
+    return status;
+}
+
+/*
+** Thân hàm chạy với bộ đếm vòng lặp riêng: break/continue trong hàm không
+** thoát vòng lặp của nơi gọi.
+*/
+int exec_func_body(t_node *body) {
+    int depth = loop_depth, saved_break = loop_break, saved_cont = loop_cont;
+    loop_depth = loop_break = loop_cont = 0;
+    exec_node(body);
+    loop_depth = depth;
+    loop_break = saved_break;
+    loop_cont = saved_cont;
+    return status;
+}
+
+static int loop_count(char **args, const char *name) {
+    int k = args[1] ? atoi(args[1]) : 1;
+    if (k < 1) {
+        fprintf(stderr, "%s: %s: loop count out of range\n", name, args[1]);
+        return 0;
+    }
+    if (loop_depth == 0)
+        return 0;   /* ngoài vòng lặp: không làm gì, như bash */
+    return k < loop_depth ? k : loop_depth;
+}
+
+// Lệnh break [n]: thoát n vòng lặp bao quanh
+int cell_break(char **args) {
+    loop_break = loop_count(args, "break");
+    return 0;
+}
+
+// Lệnh continue [n]: sang lần lặp kế của vòng thứ n
+int cell_continue(char **args) {
+    loop_cont = loop_count(args, "continue");
+    return 0;
+}
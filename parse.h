@@ -0,0 +1,61 @@
+#pragma once
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+** Cây cú pháp của một dòng lệnh. Dòng được phân tích một lần; thân vòng
+** lặp chạy lại từ cây ở mỗi lần lặp. Lệnh đơn giữ nguyên token thô (chưa
+** mở rộng) để mỗi lần chạy mở rộng lại biến theo giá trị hiện tại.
+*/
+
+typedef enum {
+    N_CMD,          /* lệnh đơn hoặc pipeline toàn lệnh đơn: words gồm cả "|" */
+    N_PIPE,         /* pipeline có stage là lệnh phức */
+    N_LIST,         /* a ; b & c */
+    N_ANDOR,        /* a && b || c */
+    N_NOT,          /* ! pipeline */
+    N_IF,
+    N_WHILE,
+    N_UNTIL,
+    N_FOR,
+    N_ARITH_FOR,    /* for ((init; test; step)) */
+    N_CASE,
+    N_ARITH,        /* (( expr )) */
+    N_GROUP,        /* { list; } */
+    N_FUNCDEF,      /* name() compound */
+} t_node_type;
+
+typedef struct s_node t_node;
+
+typedef struct s_case_item {
+    char **patterns;
+    t_node *body;
+} t_case_item;
+
+struct s_node {
+    t_node_type type;
+    char **words;       /* N_CMD: token thô; N_FOR: danh sách sau "in" */
+    char *name;         /* N_FOR: biến; N_CASE: từ cần so khớp; N_ARITH: biểu thức; N_FUNCDEF: tên hàm */
+    char *init, *test, *step;   /* N_ARITH_FOR */
+    t_node *cond;       /* if/while/until */
+    t_node *body;
+    t_node *els;        /* else, hoặc elif dưới dạng N_IF lồng */
+    t_node **kids;      /* N_LIST, N_ANDOR, N_PIPE */
+    int *ops;           /* N_LIST: 1 nếu chạy nền; N_ANDOR: '&' (&&) / '|' (||) trước kid */
+    int nkids;
+    t_case_item *items;
+    int nitems;
+    char **redirs;      /* lệnh phức: chuyển hướng sau lệnh (done < f), cặp toán tử + đích */
+    int refs;           /* tham chiếu thêm ngoài cây (thân hàm trong bảng hàm) */
+};
+
+enum { PARSE_OK, PARSE_INCOMPLETE, PARSE_ERROR };
+
+int     parse_line(char *line, t_node **out);
+int     exec_node(t_node *n);
+int     exec_func_body(t_node *body);
+void    free_node(t_node *n);
+size_t  node_bytes(const t_node *n);
+bool    flow_interrupted(void);
+int     cell_break(char **args);
+int     cell_continue(char **args);
@@ -0,0 +1,149 @@
+#include "pipeprof.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/syscall.h>
+
+int pipeprof_enabled = 0;
+
+static long long ts_diff_us(const struct timespec *a, const struct timespec *b) {
+    return (b->tv_sec - a->tv_sec) * 1000000LL + (b->tv_nsec - a->tv_nsec) / 1000;
+}
+
+static long long tv_us(const struct timeval *tv) {
+    return tv->tv_sec * 1000000LL + tv->tv_usec;
+}
+
+// Đọc rchar/wchar từ /proc/<pid>/io (vẫn đọc được khi tiến trình là zombie)
+static void read_proc_io(t_stage_prof *s) {
+    char path[64], key[32];
+    unsigned long long val;
+    snprintf(path, sizeof(path), "/proc/%d/io", (int)s->pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    while (fscanf(f, "%31[^:]: %llu\n", key, &val) == 2) {
+        if (!strcmp(key, "rchar")) s->rchar = val;
+        else if (!strcmp(key, "wchar")) s->wchar = val;
+    }
+    fclose(f);
+}
+
+/*
+** Lấy mẫu một stage đang chạy: nếu nó đang ngủ trong read(0) hoặc write(1)
+** thì cộng một chu kỳ lấy mẫu vào thời gian chờ tương ứng.
+*/
+static void sample_stage(t_stage_prof *s, long long elapsed_us) {
+    char path[64], buf[128];
+    snprintf(path, sizeof(path), "/proc/%d/syscall", (int)s->pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return;
+    if (!fgets(buf, sizeof(buf), f)) { fclose(f); return; }
+    fclose(f);
+    long nr;
+    unsigned long fd;
+    if (sscanf(buf, "%ld %lx", &nr, &fd) != 2)
+        return; // "running" hoặc đang ở user space
+    if (nr == SYS_read && fd == STDIN_FILENO)
+        s->rd_wait_us += elapsed_us;
+    else if (nr == SYS_write && fd == STDOUT_FILENO)
+        s->wr_wait_us += elapsed_us;
+}
+
+static void fmt_bytes(char *buf, size_t size, unsigned long long n) {
+    if (n >= 1ULL << 30) snprintf(buf, size, "%.1fG", n / (double)(1ULL << 30));
+    else if (n >= 1ULL << 20) snprintf(buf, size, "%.1fM", n / (double)(1ULL << 20));
+    else if (n >= 1ULL << 10) snprintf(buf, size, "%.1fK", n / (double)(1ULL << 10));
+    else snprintf(buf, size, "%lluB", n);
+}
+
+static void print_summary(t_stage_prof *st, int n) {
+    long long total_us = 0, best_busy = -1;
+    int limit = 0;
+    for (int i = 0; i < n; i++) {
+        long long w = ts_diff_us(&st[0].start, &st[i].end);
+        if (w > total_us) total_us = w;
+    }
+    fprintf(stderr, "\npipeline profile: %d stages, wall %.3fs\n", n, total_us / 1e6);
+    fprintf(stderr, " #  %-16s %8s %8s %8s %9s %9s %8s %8s\n",
+        "cmd", "wall", "user", "sys", "read", "written", "rd-wait", "wr-wait");
+    for (int i = 0; i < n; i++) {
+        t_stage_prof *s = &st[i];
+        long long wall = ts_diff_us(&s->start, &s->end);
+        long long busy = wall - s->rd_wait_us - s->wr_wait_us;
+        char rb[16], wb[16];
+        fmt_bytes(rb, sizeof(rb), s->rchar);
+        fmt_bytes(wb, sizeof(wb), s->wchar);
+        fprintf(stderr, " %-2d %-16.16s %7.3fs %7.3fs %7.3fs %9s %9s %7.3fs %7.3fs\n",
+            i + 1, s->cmd, wall / 1e6, tv_us(&s->ru.ru_utime) / 1e6,
+            tv_us(&s->ru.ru_stime) / 1e6, rb, wb,
+            s->rd_wait_us / 1e6, s->wr_wait_us / 1e6);
+        if (busy > best_busy) { best_busy = busy; limit = i; }
+    }
+    long long lwall = ts_diff_us(&st[limit].start, &st[limit].end);
+    fprintf(stderr, "limiting stage: #%d (%s), busy %.3fs of %.3fs\n",
+        limit + 1, st[limit].cmd, best_busy / 1e6, lwall / 1e6);
+}
+
+/**
+ * pipeprof_wait - Waits for all pipeline stages while sampling them
+ * @st: Stage records, pid/cmd/start already filled in by cell_pipe
+ * @n: Number of stages
+ * Return: exit status of the last stage
+ *
+ * Each exited stage is first observed with WNOWAIT so /proc/<pid>/io can
+ * still be read from the zombie, then reaped with wait4 for its rusage.
+ */
+int pipeprof_wait(t_stage_prof *st, int n) {
+    int alive = n;
+    struct timespec last, now;
+    clock_gettime(CLOCK_MONOTONIC, &last);
+
+    while (alive > 0) {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        long long elapsed = ts_diff_us(&last, &now);
+        last = now;
+        for (int i = 0; i < n; i++) {
+            t_stage_prof *s = &st[i];
+            if (s->done) continue;
+            siginfo_t si;
+            si.si_pid = 0;
+            if (waitid(P_PID, s->pid, &si, WEXITED | WNOHANG | WNOWAIT) == -1) {
+                s->done = 1; s->end = now; alive--;
+                continue;
+            }
+            if (si.si_pid == 0) {
+                sample_stage(s, elapsed);
+                continue;
+            }
+            read_proc_io(s);
+            wait4(s->pid, &s->status, 0, &s->ru);
+            clock_gettime(CLOCK_MONOTONIC, &s->end);
+            s->done = 1;
+            alive--;
+        }
+        if (alive > 0)
+            usleep(PIPEPROF_SAMPLE_US);
+    }
+    print_summary(st, n);
+    int last_status = st[n - 1].status;
+    return WIFEXITED(last_status) ? WEXITSTATUS(last_status) : 128 + WTERMSIG(last_status);
+}
+
+// Lệnh pipeprof: bật/tắt chế độ đo từng stage của pipeline
+int cell_pipeprof(char **args) {
+    if (!args[1]) {
+        printf("pipeprof: %s\n", pipeprof_enabled ? "on" : "off");
+        return 0;
+    }
+    if (!strcmp(args[1], "on"))
+        pipeprof_enabled = 1;
+    else if (!strcmp(args[1], "off"))
+        pipeprof_enabled = 0;
+    else {
+        fprintf(stderr, "pipeprof: usage: pipeprof [on|off]\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <sys/types.h>
+#include <sys/resource.h>
+#include <time.h>
+
+#define MAX_PIPE_STAGES 32
+#define PIPEPROF_SAMPLE_US 2000 /* chu kỳ lấy mẫu trạng thái các stage */
+
+/*
+** Per-stage measurements collected while a pipeline runs.
+** Blocked times are estimated by sampling /proc/<pid>/syscall: a stage
+** sleeping in read(0) is waiting on its input pipe, one sleeping in
+** write(1) is waiting on its output pipe.
+*/
+typedef struct s_stage_prof {
+    pid_t pid;
+    const char *cmd;
+    int done;
+    int status;
+    struct timespec start;
+    struct timespec end;
+    struct rusage ru;
+    unsigned long long rchar;
+    unsigned long long wchar;
+    long long rd_wait_us;
+    long long wr_wait_us;
+} t_stage_prof;
+
+extern int pipeprof_enabled;
+
+int  cell_pipeprof(char **args);
+int  pipeprof_wait(t_stage_prof *st, int n);
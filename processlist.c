@@ -1,31 +1,233 @@
 #include "processlist.h"
+#include "stats.h"
+#include "timeout.h"
+#include "jobctl.h"
+#include "memacct.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/syscall.h>
+
+#ifndef P_PIDFD
+# define P_PIDFD 3
+#endif
+
+extern volatile sig_atomic_t cell_interrupted;
 
 static bg_proc *head = NULL;
+static int next_job_id = 1;
 
-void add_bg_proc(pid_t pid, const char *cmd) {
-    bg_proc *p = malloc(sizeof(bg_proc));
-    p->pid = pid;
-    strncpy(p->cmd, cmd, sizeof(p->cmd));
-    p->cmd[sizeof(p->cmd)-1] = 0;
+/*
+** job_new - Tạo bản ghi job cho nhóm tiến trình vừa fork, chưa đưa vào
+** danh sách (job foreground chỉ vào danh sách khi bị dừng bằng Ctrl-Z).
+*/
+bg_proc *job_new(pid_t pgid, pid_t *pids, int n, const char *cmd) {
+    bg_proc *p = calloc(1, sizeof(bg_proc));
+    if (n > JOB_MAX_PROCS)
+        n = JOB_MAX_PROCS;
+    p->pid = pgid;
+    p->pgid = pgid;
+    p->nprocs = n;
+    for (int k = 0; k < n; k++) {
+        p->procs[k] = pids[k];
+        p->alive |= 1u << k;
+#ifdef SYS_pidfd_open
+        p->pidfds[k] = syscall(SYS_pidfd_open, pids[k], 0);
+        if (p->pidfds[k] != -1)
+            fcntl(p->pidfds[k], F_SETFD, FD_CLOEXEC);
+#else
+        p->pidfds[k] = -1;
+#endif
+    }
+    p->cap_fd = -1;
+    p->timer_fd = -1;
+    snprintf(p->cmd, sizeof(p->cmd), "%s", cmd);
     p->status = RUNNING;
+    STAT_INC(jobs_created);
+    return p;
+}
+
+void job_link(bg_proc *p) {
+    p->id = next_job_id++;
     p->next = head;
     head = p;
 }
 
+void job_free(bg_proc *p) {
+    for (int k = 0; k < p->nprocs; k++)
+        if (p->pidfds[k] != -1) close(p->pidfds[k]);
+    if (p->cap_fd != -1) close(p->cap_fd);
+    if (p->timer_fd != -1) close(p->timer_fd);
+    free(p->cgroup);
+    ring_free(p->ring);
+    free(p);
+    STAT_INC(jobs_reaped);
+}
+
+bg_proc *add_bg_job(pid_t pgid, pid_t *pids, int n, const char *cmd) {
+    bg_proc *p = job_new(pgid, pids, n, cmd);
+    job_link(p);
+    return p;
+}
+
+bg_proc *add_bg_proc(pid_t pid, const char *cmd) {
+    return add_bg_job(pid, &pid, 1, cmd);
+}
+
+bg_proc *bg_list(void) {
+    return head;
+}
+
+// Job hiện tại cho fg/bg không tham số: job mới nhất chưa xong
+bg_proc *bg_current(void) {
+    for (bg_proc *p = head; p; p = p->next)
+        if (p->status != DONE) return p;
+    return NULL;
+}
+
+static void proc_done(bg_proc *p, int k, int code) {
+    p->alive &= ~(1u << k);
+    if (p->pidfds[k] != -1) {
+        close(p->pidfds[k]);
+        p->pidfds[k] = -1;
+    }
+    if (k == p->nprocs - 1)
+        p->exit_code = code;
+}
+
+/*
+** bg_reap - Thu hồi các tiến trình đã kết thúc của job, ghi nhận dừng /
+** tiếp tục. Qua pidfd thì không thể nhầm sang tiến trình khác dùng lại pid.
+** @block: chặn tới khi job kết thúc hoặc bị dừng
+** Return: 1 nếu job đã DONE, 0 nếu còn chạy hoặc đang dừng
+*/
+int bg_reap(bg_proc *p, int block) {
+    // tiến trình con của một job (pipeline lồng) không tự quản lý dừng
+    int jc = job_nested() ? 0 : WSTOPPED;
+
+    if (p->status == DONE)
+        return 1;
+    for (int k = 0; k < p->nprocs; k++) {
+        if (!(p->alive & (1u << k)))
+            continue;
+        siginfo_t si;
+        int r;
+        memset(&si, 0, sizeof(si));
+        int flags = WEXITED | jc | (block ? 0 : WNOHANG | (jc ? WCONTINUED : 0));
+        if (p->pidfds[k] != -1)
+            r = waitid(P_PIDFD, p->pidfds[k], &si, flags);
+        else
+            r = waitid(P_PID, p->procs[k], &si, flags);
+        if (r == -1 && errno == ECHILD) {
+            proc_done(p, k, 127);   /* đã bị thu hồi ở chỗ khác; không còn biết mã thoát */
+            continue;
+        }
+        if (r == -1)
+            return 0;               /* EINTR */
+        if (si.si_pid == 0)
+            continue;
+        if (si.si_code == CLD_STOPPED) {
+            p->status = STOPPED;
+            if (block) return 0;
+        } else if (si.si_code == CLD_CONTINUED) {
+            p->status = RUNNING;
+        } else {
+            proc_done(p, k, si.si_code == CLD_EXITED ? si.si_status : 128 + si.si_status);
+        }
+    }
+    if (p->alive)
+        return 0;
+    if (p->timed_out && p->exit_code != 128 + SIGKILL)
+        p->exit_code = TIMEOUT_STATUS;
+    p->status = DONE;
+    if (p->timer_fd != -1) {
+        close(p->timer_fd);
+        p->timer_fd = -1;
+    }
+    if (p->cgroup)
+        rmdir(p->cgroup);   // chỉ thành công khi không còn job nào khác trong đó
+    return 1;
+}
+
+// Xử lý các timerfd `timeout` đã hết hạn (không chặn)
+void bg_check_timers(void) {
+    for (bg_proc *p = head; p; p = p->next)
+        if (p->timer_fd != -1)
+            timeout_fire(p);
+}
+
 void update_bg_status() {
-    bg_proc *p = head;
-    int status;
-    while (p) {
-        if (p->status == RUNNING) {
-            pid_t ret = waitpid(p->pid, &status, WNOHANG);
-            if (ret == p->pid) p->status = DONE;
+    capture_drain_all();
+    for (bg_proc *p = head; p; p = p->next)
+        bg_reap(p, 0);
+}
+
+/**
+ * bg_wait - Waits on a set of jobs with poll over their pidfds
+ * @set: Jobs to wait for
+ * @n: Number of jobs in set
+ * @any: Return at the first completion instead of waiting for all
+ * @done: Receives the job that completed (any) or the last one (all)
+ * Return: Shell exit code of that job, 127 if set is empty, 130 on SIGINT
+ */
+int bg_wait(bg_proc **set, int n, int any, bg_proc **done) {
+    if (done) *done = NULL;
+    if (n == 0)
+        return 127;
+    cell_interrupted = 0;
+    for (;;) {
+        struct pollfd pfds[128];
+        int np = 0, pending = 0, slow = 0;
+        bg_proc *last = NULL;
+
+        capture_drain_all();
+        for (int i = 0; i < n; i++) {
+            bg_proc *p = set[i];
+            if (bg_reap(p, 0)) {
+                // job xong trước đó nhưng chưa báo thì trả về ngay với -n
+                if (any && !p->waited) {
+                    p->waited = 1;
+                    if (done) *done = p;
+                    return p->exit_code;
+                }
+                last = p;
+                continue;
+            }
+            pending++;
+            for (int k = 0; k < p->nprocs; k++) {
+                if (!(p->alive & (1u << k)))
+                    continue;
+                if (p->pidfds[k] != -1 && np < 64)
+                    pfds[np++] = (struct pollfd){ .fd = p->pidfds[k], .events = POLLIN };
+                else
+                    slow = 1;   /* không có pidfd (kernel cũ) hoặc quá nhiều: thăm dò */
+            }
         }
-        p = p->next;
+        if (!pending) {
+            if (any) return 127;    /* mọi job đã được báo trước đó */
+            for (int i = 0; i < n; i++) set[i]->waited = 1;
+            if (done) *done = last;
+            return last ? last->exit_code : 0;
+        }
+        // output capture của job phải được rút, nếu không job bị chặn khi ghi;
+        // timerfd của `timeout` phải được xử lý để job hết giờ bị kill
+        for (bg_proc *p = head; p && np < 127; p = p->next) {
+            if (p->cap_fd != -1)
+                pfds[np++] = (struct pollfd){ .fd = p->cap_fd, .events = POLLIN };
+            if (p->timer_fd != -1)
+                pfds[np++] = (struct pollfd){ .fd = p->timer_fd, .events = POLLIN };
+        }
+        if (poll(pfds, np, slow ? 50 : -1) == -1 && errno != EINTR)
+            return 1;
+        bg_check_timers();
+        if (cell_interrupted)
+            return 130;
     }
 }
 
@@ -33,9 +235,14 @@ void print_bg_list() {
     update_bg_status();
     bg_proc *p = head;
     while (p) {
-        printf("[%d] %s - %s\n", (int)p->pid, p->cmd,
+        printf("[%d] %d %s - %s", p->id, (int)p->pid, p->cmd,
             p->status == RUNNING ? "Running" :
             p->status == STOPPED ? "Stopped" : "Done");
+        if (p->limits[0])
+            printf(" {%s }", p->limits);
+        if (p->ring)
+            printf(" (output %llu bytes)", p->ring->total);
+        printf("\n");
         p = p->next;
     }
 }
@@ -45,12 +252,22 @@ void set_bg_status(pid_t pid, proc_status status) {
     if (p) p->status = status;
 }
 
+// Tìm job theo "%N" (số job) hoặc theo pid
+bg_proc *find_bg_job(const char *spec) {
+    if (!spec) return NULL;
+    if (spec[0] != '%')
+        return find_bg_proc(atoi(spec));
+    int id = atoi(spec + 1);
+    for (bg_proc *p = head; p; p = p->next)
+        if (p->id == id) return p;
+    return NULL;
+}
+
+// pid của bất kỳ tiến trình nào trong job (stage của pipeline) đều tìm ra job
 bg_proc *find_bg_proc(pid_t pid) {
-    bg_proc *p = head;
-    while (p) {
-        if (p->pid == pid) return p;
-        p = p->next;
-    }
+    for (bg_proc *p = head; p; p = p->next)
+        for (int k = 0; k < p->nprocs; k++)
+            if (p->procs[k] == pid) return p;
     return NULL;
 }
 
@@ -60,9 +277,42 @@ void remove_done_procs() {
         if ((*pp)->status == DONE) {
             bg_proc *tmp = *pp;
             *pp = (*pp)->next;
-            free(tmp);
+            job_free(tmp);
         } else {
             pp = &(*pp)->next;
         }
     }
+}
+
+/*
+** jobs_trim - Giữ lại JOBS_DONE_MAX job DONE mới nhất (để jobs, wait, jobs -o
+** còn xem được), giải phóng các job DONE cũ hơn cùng ring capture của chúng.
+*/
+void jobs_trim(void) {
+    int kept = 0;
+    bg_proc **pp = &head;
+    while (*pp) {
+        if ((*pp)->status == DONE && ++kept > JOBS_DONE_MAX) {
+            bg_proc *tmp = *pp;
+            *pp = tmp->next;
+            job_free(tmp);
+        } else {
+            pp = &(*pp)->next;
+        }
+    }
+}
+
+// Trước mỗi prompt: thu hồi job nền đã xong rồi cắt bớt danh sách
+void jobs_housekeep(void) {
+    if (!head)
+        return;
+    update_bg_status();
+    jobs_trim();
+}
+
+void jobs_mem(t_memuse *u) {
+    for (bg_proc *p = head; p; p = p->next) {
+        u->objects++;
+        u->bytes += mem_size(p);
+    }
 }
\ No newline at end of file
@@ -1,18 +1,55 @@
 #pragma once
 #include <sys/types.h>
+#include "capture.h"
 
 typedef enum { RUNNING, STOPPED, DONE } proc_status;
 
+#define JOB_MAX_PROCS 32    /* bằng MAX_PIPE_STAGES: mỗi stage một tiến trình */
+#define JOBS_DONE_MAX 64    /* số job DONE giữ lại trong danh sách, cũ hơn bị giải phóng */
+
+/*
+** Một job là một nhóm tiến trình (pgid = pid của tiến trình đầu): một lệnh
+** hoặc cả pipeline. Tín hiệu dừng/tiếp tục/kill gửi cho cả nhóm bằng một
+** killpg; mã thoát của job là của tiến trình cuối.
+*/
 typedef struct bg_proc {
-    pid_t pid;
+    int id;             /* số job, dùng với %N; 0 = job foreground chưa vào danh sách */
+    pid_t pid;          /* tiến trình đầu, cũng là pgid */
+    pid_t pgid;
+    pid_t procs[JOB_MAX_PROCS];
+    int pidfds[JOB_MAX_PROCS];  /* pidfd_open của từng tiến trình, -1 nếu không có */
+    int nprocs;
+    unsigned alive;     /* bit k = procs[k] chưa được thu hồi */
     char cmd[256];
     proc_status status;
+    int cap_fd;         /* pipe output khi capture bật, -1 nếu không */
+    t_ring *ring;
+    char limits[128];   /* thuộc tính do `limit` áp, "" nếu không có */
+    char *cgroup;       /* cgroup của `limit -g`, xóa khi job DONE; NULL nếu không có */
+    int exit_code;      /* mã thoát kiểu shell (128+sig nếu bị signal) khi DONE */
+    int waited;         /* đã báo kết quả qua wait/fg */
+    int timer_fd;       /* timerfd của `timeout`, -1 nếu không có */
+    int timeout_sig;
+    double timeout_grace;
+    int timed_out;      /* đã gửi tín hiệu hết giờ */
     struct bg_proc *next;
 } bg_proc;
 
-void add_bg_proc(pid_t pid, const char *cmd);
+bg_proc *job_new(pid_t pgid, pid_t *pids, int n, const char *cmd);
+void job_link(bg_proc *p);
+void job_free(bg_proc *p);
+bg_proc *add_bg_proc(pid_t pid, const char *cmd);
+bg_proc *add_bg_job(pid_t pgid, pid_t *pids, int n, const char *cmd);
+bg_proc *bg_current(void);
 void update_bg_status();
 void print_bg_list();
 void remove_done_procs();
+void jobs_trim(void);
+void jobs_housekeep(void);
 bg_proc *find_bg_proc(pid_t pid);
-void set_bg_status(pid_t pid, proc_status status);
\ No newline at end of file
+bg_proc *find_bg_job(const char *spec);
+bg_proc *bg_list(void);
+void set_bg_status(pid_t pid, proc_status status);
+int bg_reap(bg_proc *p, int block);
+void bg_check_timers(void);
+int bg_wait(bg_proc **set, int n, int any, bg_proc **done);
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include "cell.h"
+#include <signal.h>
+
+/*
+** Process substitution: `<(cmd)` và `>(cmd)`
+**
+** Lệnh bên trong chạy trong tiến trình con nối với một pipe; token được thay
+** bằng "/dev/fd/N" với N là đầu pipe còn lại mà shell giữ mở (không CLOEXEC)
+** để lệnh ngoài thừa kế khi exec. Sau khi lệnh ngoài xong, shell đóng fd và
+** thu hồi tiến trình con. Dữ liệu chỉ đi qua pipe, không ghi ra đĩa.
+*/
+
+#define MAX_PROCSUB 64
+
+extern int status;
+
+typedef struct s_procsub {
+    int fd;     /* đầu pipe shell giữ, được truyền dưới dạng /dev/fd/N */
+    pid_t pid;
+} t_procsub;
+
+static t_procsub subs[MAX_PROCSUB];
+static int nsubs = 0;
+
+static int is_procsub(const char *tok) {
+    size_t len = strlen(tok);
+    return len >= 3 && (tok[0] == '<' || tok[0] == '>') && tok[1] == '('
+        && tok[len - 1] == ')';
+}
+
+/**
+ * procsub_expand - Starts the inner command of every <(...) / >(...) token
+ * @args: Token vector, substituted tokens are replaced in place
+ * Return: mark to pass to procsub_finish once the outer command is done
+ */
+int procsub_expand(char **args) {
+    int mark = nsubs;
+
+    for (int i = 0; args[i]; i++) {
+        if (!is_procsub(args[i]))
+            continue;
+        if (nsubs == MAX_PROCSUB) {
+            fprintf(stderr, "cell: too many process substitutions\n");
+            break;
+        }
+        int reading = args[i][0] == '<';    // <(cmd): lệnh ngoài đọc output
+        size_t len = strlen(args[i]);
+        char *inner = strndup(args[i] + 2, len - 3);
+        int fd[2];
+        if (pipe(fd) == -1) {
+            perror("pipe");
+            free(inner);
+            break;
+        }
+        fflush(stdout);
+        pid_t pid = Fork();
+        if (pid == 0) {
+            signal(SIGINT, SIG_DFL);
+            for (int k = 0; k < nsubs; k++)
+                close(subs[k].fd);
+            nsubs = 0;
+            if (reading)
+                dup2(fd[1], STDOUT_FILENO);
+            else
+                dup2(fd[0], STDIN_FILENO);
+            close(fd[0]);
+            close(fd[1]);
+            cell_run_line(inner);
+            fflush(stdout);
+            exit(status);
+        }
+        free(inner);
+        subs[nsubs].pid = pid;
+        subs[nsubs].fd = reading ? fd[0] : fd[1];
+        close(reading ? fd[1] : fd[0]);
+        nsubs++;
+
+        char path[32];
+        snprintf(path, sizeof(path), "/dev/fd/%d", subs[nsubs - 1].fd);
+        free(args[i]);
+        args[i] = strdup(path);
+    }
+    return mark;
+}
+
+/**
+ * procsub_finish - Closes substitution fds and reaps their processes
+ * @mark: Value returned by the matching procsub_expand
+ */
+void procsub_finish(int mark) {
+    // Đóng hết trước rồi mới đợi: >(cmd) chỉ kết thúc khi thấy EOF
+    for (int k = mark; k < nsubs; k++)
+        close(subs[k].fd);
+    for (int k = mark; k < nsubs; k++)
+        waitpid(subs[k].pid, NULL, 0);
+    nsubs = mark;
+}
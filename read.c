@@ -0,0 +1,325 @@
+#include "cell.h"
+#include "vars.h"
+#include <sys/stat.h>
+
+/*
+** read / mapfile với bộ đệm lớn theo từng fd.
+**
+** Mỗi syscall read() lấy cả khối READ_CHUNK thay vì từng byte. Phần đọc dư
+** của file thường được lseek trả lại trước khi fork và trước khi readline
+** đọc dòng lệnh tiếp theo (readbuf_release), nên người khác đọc tiếp đúng
+** vị trí. Pipe thì không trả lại được: chỉ đệm pipe do shell sở hữu (fd do
+** shell mở như procsub/coproc/exec N<, hoặc stdin của stage con trong
+** pipeline đã được readbuf_own). stdin là pipe dùng chung với readline thì
+** vẫn phải đọc từng byte, nếu không sẽ nuốt mất các dòng lệnh phía sau.
+*/
+
+#define READ_CHUNK (64 * 1024)
+#define RBUF_MAX_FD 256
+
+typedef struct s_rbuf {
+    char *buf;
+    size_t pos;
+    size_t len;
+    size_t cap;
+    int seekable;
+    int unbuffered;
+    int eof;
+} t_rbuf;
+
+static t_rbuf *rbufs[RBUF_MAX_FD];
+static int stdin_owned;
+
+// Tiến trình này là người đọc duy nhất của fd (stage con trong pipeline)
+void readbuf_own(int fd) {
+    if (fd == STDIN_FILENO)
+        stdin_owned = 1;
+    // bộ đệm thừa kế từ cha thuộc về fd cũ trước dup2
+    if (rbufs[fd]) {
+        free(rbufs[fd]->buf);
+        free(rbufs[fd]);
+        rbufs[fd] = NULL;
+    }
+}
+
+// Đóng fd do shell sở hữu (coproc, ...) cùng phần đệm còn lại của nó
+void readbuf_close(int fd) {
+    if (fd >= 0 && fd < RBUF_MAX_FD && rbufs[fd]) {
+        free(rbufs[fd]->buf);
+        free(rbufs[fd]);
+        rbufs[fd] = NULL;
+    }
+    close(fd);
+}
+
+// Trả phần đọc dư của một fd file thường về offset rồi bỏ bộ đệm
+static void rbuf_drop(int fd) {
+    t_rbuf *rb = rbufs[fd];
+    if (!rb)
+        return;
+    if (rb->seekable && rb->len > rb->pos)
+        lseek(fd, -(off_t)(rb->len - rb->pos), SEEK_CUR);
+    free(rb->buf);
+    free(rb);
+    rbufs[fd] = NULL;
+}
+
+/*
+** Chuyển hướng trong shell: fd sắp trỏ sang file khác. Bộ đệm của file cũ
+** được cất lại (pipe không trả dữ liệu về được) và gắn lại khi fd được trả.
+*/
+struct s_rbuf *readbuf_detach(int fd) {
+    if (fd < 0 || fd >= RBUF_MAX_FD || !rbufs[fd])
+        return NULL;
+    if (rbufs[fd]->seekable) {
+        rbuf_drop(fd);
+        return NULL;
+    }
+    t_rbuf *rb = rbufs[fd];
+    rbufs[fd] = NULL;
+    return rb;
+}
+
+void readbuf_attach(int fd, struct s_rbuf *rb) {
+    if (fd < 0 || fd >= RBUF_MAX_FD)
+        return;
+    rbuf_drop(fd);
+    rbufs[fd] = rb;
+}
+
+void readbuf_release(void) {
+    for (int fd = 0; fd < RBUF_MAX_FD; fd++) {
+        t_rbuf *rb = rbufs[fd];
+        if (!rb || !rb->seekable)
+            continue;
+        if (rb->len > rb->pos)
+            lseek(fd, -(off_t)(rb->len - rb->pos), SEEK_CUR);
+        free(rb->buf);
+        free(rb);
+        rbufs[fd] = NULL;
+    }
+}
+
+static t_rbuf *rbuf_get(int fd) {
+    if (!rbufs[fd]) {
+        struct stat st;
+        t_rbuf *rb = Malloc(sizeof(*rb));
+        memset(rb, 0, sizeof(*rb));
+        rb->seekable = !fstat(fd, &st) && S_ISREG(st.st_mode);
+        rb->unbuffered = fd == STDIN_FILENO && !rb->seekable && !stdin_owned;
+        rb->cap = READ_CHUNK;
+        rb->buf = Malloc(rb->cap);
+        rbufs[fd] = rb;
+    }
+    return rbufs[fd];
+}
+
+/*
+** Đọc một bản ghi kết thúc bằng delim vào out (không gồm delim).
+** Return: 1 nếu có bản ghi đủ, 0 nếu EOF sau phần dở dang (out có dữ liệu),
+**         -1 nếu EOF không còn gì / lỗi
+*/
+static int read_record(int fd, int delim, t_str *out) {
+    out->len = 0;
+    if (out->s) out->s[0] = '\0';
+
+    if (fd < 0 || fd >= RBUF_MAX_FD) {
+        errno = EBADF;
+        return -1;
+    }
+    t_rbuf *rb = rbuf_get(fd);
+    for (;;) {
+        char *hit = memchr(rb->buf + rb->pos, delim, rb->len - rb->pos);
+        if (hit) {
+            str_putn(out, rb->buf + rb->pos, hit - (rb->buf + rb->pos));
+            rb->pos = hit - rb->buf + 1;
+            return 1;
+        }
+        str_putn(out, rb->buf + rb->pos, rb->len - rb->pos);
+        rb->pos = rb->len = 0;
+        if (rb->eof)
+            break;
+        ssize_t n;
+        do {
+            n = read(fd, rb->buf, rb->unbuffered ? 1 : rb->cap);
+        } while (n < 0 && errno == EINTR && !cell_interrupted);
+        if (n <= 0) {
+            rb->eof = 1;
+            if (n < 0) perror("read");
+            break;
+        }
+        rb->len = n;
+    }
+    rb->eof = 0;    /* tty/pipe có thể có thêm dữ liệu ở lần gọi sau */
+    return out->len ? 0 : -1;
+}
+
+static int parse_fd(const char *s, int *fd) {
+    char *end;
+    long v = strtol(s, &end, 10);
+    if (*s == '\0' || *end || v < 0 || v >= RBUF_MAX_FD) {
+        fprintf(stderr, "cell: %s: invalid file descriptor\n", s);
+        return 0;
+    }
+    *fd = (int)v;
+    return 1;
+}
+
+// Bỏ ký tự thoát '\' (read không có -r)
+static void unescape(t_str *line) {
+    size_t j = 0;
+    for (size_t i = 0; i < line->len; i++) {
+        if (line->s[i] == '\\' && i + 1 < line->len)
+            i++;
+        line->s[j++] = line->s[i];
+    }
+    line->len = j;
+    if (line->s) line->s[j] = '\0';
+}
+
+/*
+** Tách trường theo IFS: ký tự khoảng trắng trong IFS gộp lại, ký tự khác
+** phân tách chính xác. Biến cuối cùng nhận phần còn lại của dòng.
+*/
+static size_t split_fields(char *s, const char *ifs, char **out, size_t max) {
+    size_t n = 0;
+    #define IS_IFS(c) ((c) && strchr(ifs, (c)))
+    #define IS_WS(c) (IS_IFS(c) && strchr(" \t\n", (c)))
+
+    while (IS_WS(*s)) s++;
+    while (*s && n < max) {
+        if (n == max - 1) {
+            // bỏ khoảng trắng IFS ở cuối phần còn lại
+            char *end = s + strlen(s);
+            while (end > s && IS_WS(end[-1])) end--;
+            *end = '\0';
+            out[n++] = s;
+            break;
+        }
+        out[n++] = s;
+        while (*s && !IS_IFS(*s)) s++;
+        if (!*s) break;
+        int hard = !IS_WS(*s);
+        *s++ = '\0';
+        while (IS_WS(*s)) s++;
+        if (!hard && IS_IFS(*s) && !IS_WS(*s)) {
+            s++;
+            while (IS_WS(*s)) s++;
+        }
+    }
+    #undef IS_IFS
+    #undef IS_WS
+    return n;
+}
+
+/**
+ * cell_read - read [-r] [-d delim] [-p prompt] [-u fd] [-a array] [name...]
+ * @args: Command arguments
+ * Return: 0 on a full record, 1 on EOF, 2 on bad usage
+ */
+int cell_read(char **args) {
+    int raw = 0, delim = '\n', fd = STDIN_FILENO, i = 1;
+    const char *array = NULL;
+    t_str line = {0};
+
+    for (; args[i] && args[i][0] == '-' && args[i][1]; i++) {
+        if (!strcmp(args[i], "-r")) raw = 1;
+        else if (!strcmp(args[i], "-d") && args[i + 1]) delim = (unsigned char)args[++i][0];
+        else if (!strcmp(args[i], "-p") && args[i + 1]) {
+            fputs(args[++i], stderr);
+        } else if (!strcmp(args[i], "-u") && args[i + 1]) {
+            if (!parse_fd(args[++i], &fd)) return 2;
+        } else if (!strcmp(args[i], "-a") && args[i + 1]) array = args[++i];
+        else if (!strcmp(args[i], "--")) { i++; break; }
+        else {
+            fprintf(stderr, "read: usage: read [-r] [-d delim] [-p prompt] [-u fd] "
+                            "[-a array] [name...]\n");
+            return 2;
+        }
+    }
+
+    fflush(stdout);
+    int r = read_record(fd, delim, &line);
+    if (r < 0) {
+        free(line.s);
+        return 1;
+    }
+    if (!raw) unescape(&line);
+    if (!line.s) str_puts(&line, "");
+
+    const char *ifs = var_get("IFS");
+    if (!ifs) ifs = " \t\n";
+
+    if (array) {
+        // mỗi trường ít nhất 1 ký tự nên len + 1 chỗ là đủ
+        char **f = Malloc((line.len + 1) * sizeof(char *));
+        size_t n = split_fields(line.s, ifs, f, line.len + 1);
+        char **vals = Malloc((n ? n : 1) * sizeof(char *));
+        for (size_t k = 0; k < n; k++)
+            vals[k] = strdup(f[k]);
+        var_set_array(array, vals, n);
+        free(f);
+    } else if (!args[i]) {
+        var_set("REPLY", line.s);
+    } else {
+        int nvars = 0;
+        while (args[i + nvars]) nvars++;
+        char **f = Malloc(nvars * sizeof(char *));
+        size_t n = split_fields(line.s, ifs, f, nvars);
+        for (int k = 0; k < nvars; k++)
+            var_set(args[i + k], (size_t)k < n ? f[k] : "");
+        free(f);
+    }
+    free(line.s);
+    return r == 1 ? 0 : 1;
+}
+
+/**
+ * cell_mapfile - mapfile [-t] [-n count] [-s skip] [-d delim] [-u fd] [array]
+ * @args: Command arguments
+ * Return: 0 on success, 2 on bad usage
+ */
+int cell_mapfile(char **args) {
+    int strip = 0, delim = '\n', fd = STDIN_FILENO, i = 1;
+    long count = 0, skip = 0;
+    const char *array = "MAPFILE";
+
+    for (; args[i] && args[i][0] == '-' && args[i][1]; i++) {
+        if (!strcmp(args[i], "-t")) strip = 1;
+        else if (!strcmp(args[i], "-n") && args[i + 1]) count = atol(args[++i]);
+        else if (!strcmp(args[i], "-s") && args[i + 1]) skip = atol(args[++i]);
+        else if (!strcmp(args[i], "-d") && args[i + 1]) delim = (unsigned char)args[++i][0];
+        else if (!strcmp(args[i], "-u") && args[i + 1]) {
+            if (!parse_fd(args[++i], &fd)) return 2;
+        } else {
+            fprintf(stderr, "mapfile: usage: mapfile [-t] [-n count] [-s skip] [-d delim] "
+                            "[-u fd] [array]\n");
+            return 2;
+        }
+    }
+    if (args[i]) array = args[i];
+
+    cell_interrupted = 0;
+    size_t n = 0, cap = 1024;
+    char **vals = Malloc(cap * sizeof(char *));
+    t_str line = {0};
+    int r;
+    while ((count == 0 || (long)n < count) && !cell_interrupted
+           && (r = read_record(fd, delim, &line)) >= 0) {
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        if (n == cap) {
+            cap *= 2;
+            vals = Realloc(vals, cap * sizeof(char *));
+        }
+        // giữ delim trừ khi -t (như bash)
+        if (!strip && r == 1)
+            str_putc(&line, (char)delim);
+        vals[n++] = line.s ? strndup(line.s, line.len) : strdup("");
+    }
+    free(line.s);
+    var_set_array(array, vals, n);
+    return 0;
+}
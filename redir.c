@@ -0,0 +1,235 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include "redir.h"
+#include "vars.h"
+#include <ctype.h>
+#include <fcntl.h>
+
+enum { R_IN, R_OUT, R_APPEND, R_RDWR, R_DUP, R_BOTH, R_BOTH_APPEND };
+
+typedef struct s_fdsave {
+    int fd;
+    int saved;              /* bản sao CLOEXEC của fd cũ, -1 nếu fd đang đóng */
+    struct s_rbuf *rb;      /* bộ đệm read của fd cũ */
+} t_fdsave;
+
+static t_fdsave *saves;
+static int nsaves = 0, cap_saves = 0;
+
+int redir_is_op(const char *tok) {
+    return tok[0] == REDIR_MARK;
+}
+
+int redir_has(char **args) {
+    for (int i = 0; args[i]; i++)
+        if (redir_is_op(args[i]))
+            return 1;
+    return 0;
+}
+
+// Các từ còn lại sau khi bỏ toán tử và đích (mảng nông, chỉ free mảng)
+char **redir_words(char **args) {
+    int n = 0, k = 0;
+    while (args[n]) n++;
+    char **w = Malloc((n + 1) * sizeof(char *));
+    for (int i = 0; i < n; i++) {
+        if (redir_is_op(args[i])) {
+            if (args[i + 1]) i++;
+            continue;
+        }
+        w[k++] = args[i];
+    }
+    w[k] = NULL;
+    return w;
+}
+
+// Từ của lệnh trước, các cặp chuyển hướng dồn về cuối (giữ thứ tự của chúng)
+char **redir_sorted(char **args) {
+    int n = 0, k = 0;
+    while (args[n]) n++;
+    char **w = Malloc((n + 1) * sizeof(char *));
+    for (int i = 0; i < n; i++)
+        if (!redir_is_op(args[i]) && !(i > 0 && redir_is_op(args[i - 1])))
+            w[k++] = args[i];
+    for (int i = 0; i < n; i++)
+        if (redir_is_op(args[i]) || (i > 0 && redir_is_op(args[i - 1])))
+            w[k++] = args[i];
+    w[k] = NULL;
+    return w;
+}
+
+// "\0012>&" -> fd 2, R_DUP; fd mặc định là 0 cho < <> <&, 1 cho phần còn lại
+static int parse_op(const char *tok, int *fd, int *op) {
+    const char *s = tok + 1;
+    long n = -1;
+
+    if (isdigit((unsigned char)*s)) {
+        n = strtol(s, (char **)&s, 10);
+        if (n > 1023)
+            return -1;
+    }
+    if (!strcmp(s, "<")) *op = R_IN;
+    else if (!strcmp(s, ">") || !strcmp(s, ">|")) *op = R_OUT;
+    else if (!strcmp(s, ">>")) *op = R_APPEND;
+    else if (!strcmp(s, "<>")) *op = R_RDWR;
+    else if (!strcmp(s, ">&") || !strcmp(s, "<&")) *op = R_DUP;
+    else if (!strcmp(s, "&>") && n < 0) *op = R_BOTH;
+    else if (!strcmp(s, "&>>") && n < 0) *op = R_BOTH_APPEND;
+    else return -1;
+    *fd = n >= 0 ? (int)n : s[0] == '<' ? 0 : 1;
+    return 0;
+}
+
+/*
+** Cất fd trước khi ghi đè. Một bản lưu đang nằm đúng số fd sắp bị ghi đè
+** (lệnh dùng fd >= REDIR_SAVE_FD) thì được dời sang chỗ khác trước.
+*/
+static void save_fd(int fd) {
+    for (int k = 0; k < nsaves; k++)
+        if (saves[k].saved == fd)
+            saves[k].saved = fcntl(fd, F_DUPFD_CLOEXEC, REDIR_SAVE_FD);
+    if (nsaves == cap_saves) {
+        cap_saves = cap_saves ? cap_saves * 2 : 16;
+        saves = Realloc(saves, cap_saves * sizeof(*saves));
+    }
+    saves[nsaves].fd = fd;
+    saves[nsaves].saved = fcntl(fd, F_DUPFD_CLOEXEC, REDIR_SAVE_FD);
+    saves[nsaves].rb = readbuf_detach(fd);
+    nsaves++;
+}
+
+// Chuẩn bị ghi đè fd: cất lại (lệnh thường) hoặc bỏ hẳn bộ đệm cũ (exec)
+static void prepare_fd(int fd, int save) {
+    if (save)
+        save_fd(fd);
+    else
+        readbuf_attach(fd, NULL);
+}
+
+static void move_fd(int from, int to) {
+    if (from != to) {
+        dup2(from, to);
+        close(from);
+    }
+}
+
+static int redir_one(int fd, int op, const char *target, int save) {
+    static const int flags[] = {
+        [R_IN] = O_RDONLY,
+        [R_OUT] = O_WRONLY | O_CREAT | O_TRUNC,
+        [R_APPEND] = O_WRONLY | O_CREAT | O_APPEND,
+        [R_RDWR] = O_RDWR | O_CREAT,
+        [R_BOTH] = O_WRONLY | O_CREAT | O_TRUNC,
+        [R_BOTH_APPEND] = O_WRONLY | O_CREAT | O_APPEND,
+    };
+
+    if (op == R_DUP) {
+        char *end;
+        long src = strtol(target, &end, 10);
+        if (!strcmp(target, "-")) {
+            prepare_fd(fd, save);
+            close(fd);
+            return 0;
+        }
+        if (!*target || *end) {
+            // >&file (không có số fd) là &>file như bash
+            if (fd != 1) {
+                fprintf(stderr, "cell: %s: ambiguous redirect\n", target);
+                return -1;
+            }
+            return redir_one(1, R_BOTH, target, save);
+        }
+        if (src < 0 || (int)src != src || fcntl((int)src, F_GETFD) == -1) {
+            fprintf(stderr, "cell: %s: bad file descriptor\n", target);
+            return -1;
+        }
+        if (src != fd) {
+            prepare_fd(fd, save);
+            dup2((int)src, fd);
+        }
+        return 0;
+    }
+    // cất trước khi open: open có thể trả về đúng số fd đang đóng
+    prepare_fd(fd, save);
+    if (op == R_BOTH || op == R_BOTH_APPEND)
+        prepare_fd(STDERR_FILENO, save);
+    int nfd = open(target, flags[op], 0644);
+    if (nfd == -1) {
+        fprintf(stderr, "cell: %s: %s\n", target, strerror(errno));
+        return -1;
+    }
+    if (op == R_BOTH || op == R_BOTH_APPEND) {
+        dup2(nfd, STDERR_FILENO);
+        fd = STDOUT_FILENO;
+    }
+    move_fd(nfd, fd);
+    return 0;
+}
+
+/**
+ * redir_apply - Performs the redirections in args from left to right
+ * @args: Expanded words; marked operators are each followed by a target
+ * @save: Keep the old fds for redir_undo; 0 makes the change permanent
+ *        (exec, or a child about to exec)
+ * Return: 0, or -1 after printing an error (earlier ones stay applied)
+ */
+int redir_apply(char **args, int save) {
+    fflush(stdout);
+    fflush(stderr);
+    for (int i = 0; args[i]; i++) {
+        int fd, op;
+        if (!redir_is_op(args[i]))
+            continue;
+        if (parse_op(args[i], &fd, &op) == -1) {
+            fprintf(stderr, "cell: %s: bad redirection\n", args[i] + 1);
+            return -1;
+        }
+        if (!args[i + 1] || redir_is_op(args[i + 1])) {
+            fprintf(stderr, "cell: syntax error near unexpected token `%s'\n",
+                    args[i + 1] ? args[i + 1] + 1 : "newline");
+            return -1;
+        }
+        if (redir_one(fd, op, args[++i], save) == -1)
+            return -1;
+    }
+    return 0;
+}
+
+int redir_mark(void) {
+    return nsaves;
+}
+
+// Trả các fd đã cất từ redir_apply(..., 1) về như trước mark
+void redir_undo(int mark) {
+    fflush(stdout);
+    fflush(stderr);
+    while (nsaves > mark) {
+        t_fdsave *s = &saves[--nsaves];
+        readbuf_attach(s->fd, s->rb);
+        if (s->saved == -1)
+            close(s->fd);
+        else
+            move_fd(s->saved, s->fd);
+    }
+}
+
+// fd đang bị một lệnh chuyển hướng (capture của job nền không ghi đè nó)
+int redir_active(int fd) {
+    for (int k = 0; k < nsaves; k++)
+        if (saves[k].fd == fd)
+            return 1;
+    return 0;
+}
+
+/*
+** exec cmd...: thay shell bằng lệnh. exec chỉ có chuyển hướng thì
+** cell_execute đã áp dụng chúng vĩnh viễn, ở đây không còn gì để làm.
+*/
+int cell_exec(char **args) {
+    if (!args[1])
+        return 0;
+    fflush(stdout);
+    execvp(args[1], &args[1]);
+    fprintf(stderr, "exec: %s: %s\n", args[1], strerror(errno));
+    return errno == ENOENT ? 127 : 126;
+}
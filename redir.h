@@ -0,0 +1,31 @@
+#pragma once
+
+/*
+** Chuyển hướng: [n]< [n]> [n]>| [n]>> [n]<> [n]>&m [n]<&m [n]>&- &> &>>
+**
+** Tokenizer đánh dấu toán tử chuyển hướng bằng byte REDIR_MARK ở đầu token,
+** nên sau khi mở rộng vẫn phân biệt được với '>' trong nháy hay \> của test;
+** bên trong [[ ]] thì < > là toán tử so sánh và không được đánh dấu.
+**
+** Lệnh đơn (cả builtin và hàm) được chuyển hướng ngay trong shell: fd cũ
+** được cất ở một bản sao CLOEXEC >= REDIR_SAVE_FD và trả lại sau lệnh, lệnh
+** ngoài thì thừa kế qua fork. Job nền và stage của pipeline áp dụng trong
+** tiến trình con sau fork (stage thì sau khi đã nối pipe). Lệnh phức
+** (done < file, } > out) áp dụng quanh cả thân lệnh.
+**
+** `exec` chỉ có chuyển hướng thì giữ fd lại trong shell: `exec 3>>log` mở
+** file một lần, các lệnh sau ghi bằng `>&3` chỉ còn dup thay vì open/close.
+*/
+
+#define REDIR_MARK '\001'
+#define REDIR_SAVE_FD 10
+
+int     redir_is_op(const char *tok);
+int     redir_has(char **args);
+char  **redir_words(char **args);
+char  **redir_sorted(char **args);
+int     redir_apply(char **args, int save);
+int     redir_mark(void);
+void    redir_undo(int mark);
+int     redir_active(int fd);
+int     cell_exec(char **args);
@@ -0,0 +1,569 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <arpa/inet.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include "jobctl.h"
+
+/*
+** Server mode: `cell --server <socket>`
+**
+** Một tiến trình shell "ấm" lắng nghe trên UNIX socket. Mỗi request được chạy
+** trong một tiến trình con fork từ server (không exec lại shell), với cwd và
+** env riêng. Mọi thông điệp là một frame:
+**
+**     [type: 1 byte][length: 4 byte big-endian][payload]
+**
+** Client -> server:
+**   'D' cwd cho request          'V' một biến môi trường "KEY=VALUE"
+**   'L' dòng lệnh cần chạy       'A' một từ argv (giữ nguyên, không tách lại)
+**   'G' kết thúc request, bắt đầu chạy: có 'A' thì chạy argv, không thì 'L'
+** Server -> client:
+**   'O' một đoạn stdout          'E' một đoạn stderr
+**   'X' kết thúc: "status=N signal=N wall_us=N utime_us=N stime_us=N maxrss_kb=N"
+**
+** Một kết nối có thể gửi nhiều request nối tiếp nhau; nhiều kết nối được
+** phục vụ đồng thời bằng một vòng lặp poll duy nhất. Socket client ở chế độ
+** non-blocking: frame gửi đi nằm trong hàng đợi của kết nối và được đẩy khi
+** POLLOUT, nên một client ngừng đọc không làm nghẽn các client khác. Hàng đợi
+** vượt SERVER_OUTQ_MAX thì ngừng đọc output của job đó (job bị chặn ở pipe).
+**
+** Mỗi request là một nhóm tiến trình (pipeline bên trong cũng ở lại nhóm
+** đó); client ngắt kết nối thì cả nhóm bị SIGKILL. Kết thúc của request được
+** theo dõi bằng pidfd trong cùng vòng poll.
+**
+** Socket được tạo với quyền 0600; file cũ ở đường dẫn đó chỉ bị xóa nếu nó
+** là socket.
+*/
+
+#define FRAME_HDR 5
+#define FRAME_MAX (1 << 20)
+#define SERVER_BACKLOG 64
+#define SERVER_OUTQ_MAX (1 << 20)
+
+extern int status;
+
+int cell_serving = 0;   /* 1 trong tiến trình chạy request: exit trả mã về client */
+
+typedef struct s_conn {
+    int fd;
+    unsigned char *in;
+    size_t in_len;
+    size_t in_cap;
+    char *cwd;
+    char **env;
+    int nenv;
+    char *line;
+    char **argv;        /* từ 'A', kết thúc bằng NULL */
+    int nargv;
+    unsigned char *outq;    /* frame chờ gửi cho client, từ outq_off tới outq_len */
+    size_t outq_off;
+    size_t outq_len;
+    size_t outq_cap;
+    pid_t pid;          /* > 0 khi đang chạy một request, cũng là pgid của nó */
+    int pidfd;          /* pidfd của request, -1 nếu không có hoặc đã thu hồi */
+    int exited;         /* đã thu hồi, chờ output hết để gửi 'X' */
+    int wstatus;
+    struct rusage ru;
+    int out_fd;
+    int err_fd;
+    struct timespec start;
+    struct timespec end;
+} t_conn;
+
+static t_conn **conns = NULL;
+static int nconns = 0;
+
+static int write_all(int fd, const void *buf, size_t len) {
+    const char *p = buf;
+    while (len > 0) {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        if (n == -1 && errno == ENOTSOCK)
+            n = write(fd, p, len);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int send_frame(int fd, char type, const void *payload, uint32_t len) {
+    unsigned char hdr[FRAME_HDR];
+    uint32_t be = htonl(len);
+    hdr[0] = (unsigned char)type;
+    memcpy(hdr + 1, &be, 4);
+    if (write_all(fd, hdr, FRAME_HDR) == -1)
+        return -1;
+    return len ? write_all(fd, payload, len) : 0;
+}
+
+// Đẩy hàng đợi ra socket tới khi hết hoặc EAGAIN. Return: -1 nếu client lỗi
+static int flush_out(t_conn *c) {
+    while (c->outq_off < c->outq_len) {
+        ssize_t n = send(c->fd, c->outq + c->outq_off, c->outq_len - c->outq_off, MSG_NOSIGNAL);
+        if (n == -1) {
+            if (errno == EINTR) continue;
+            return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+        }
+        c->outq_off += n;
+    }
+    c->outq_off = c->outq_len = 0;
+    return 0;
+}
+
+static int queue_frame(t_conn *c, char type, const void *payload, uint32_t len) {
+    uint32_t be = htonl(len);
+    if (c->outq_off) {
+        memmove(c->outq, c->outq + c->outq_off, c->outq_len - c->outq_off);
+        c->outq_len -= c->outq_off;
+        c->outq_off = 0;
+    }
+    if (c->outq_len + FRAME_HDR + len > c->outq_cap) {
+        c->outq_cap = (c->outq_len + FRAME_HDR + len) * 2;
+        c->outq = Realloc(c->outq, c->outq_cap);
+    }
+    c->outq[c->outq_len] = (unsigned char)type;
+    memcpy(c->outq + c->outq_len + 1, &be, 4);
+    if (len)
+        memcpy(c->outq + c->outq_len + FRAME_HDR, payload, len);
+    c->outq_len += FRAME_HDR + len;
+    return flush_out(c);
+}
+
+static size_t outq_pending(const t_conn *c) {
+    return c->outq_len - c->outq_off;
+}
+
+static void reset_request(t_conn *c) {
+    free(c->cwd);
+    c->cwd = NULL;
+    for (int i = 0; i < c->nenv; i++) free(c->env[i]);
+    free(c->env);
+    c->env = NULL;
+    c->nenv = 0;
+    free(c->line);
+    c->line = NULL;
+    for (int i = 0; i < c->nargv; i++) free(c->argv[i]);
+    free(c->argv);
+    c->argv = NULL;
+    c->nargv = 0;
+}
+
+static void drop_conn(int idx) {
+    t_conn *c = conns[idx];
+    if (c->pid > 0) {
+        // cả nhóm: pipeline và job nền của request không sống sót sau client
+        killpg(c->pid, SIGKILL);
+        if (!c->exited)
+            waitpid(c->pid, NULL, 0);
+    }
+    if (c->pidfd != -1) close(c->pidfd);
+    if (c->out_fd != -1) close(c->out_fd);
+    if (c->err_fd != -1) close(c->err_fd);
+    close(c->fd);
+    reset_request(c);
+    free(c->in);
+    free(c->outq);
+    free(c);
+    conns[idx] = conns[--nconns];
+}
+
+static char *dup_payload(const unsigned char *p, uint32_t len) {
+    char *s = Malloc(len + 1);
+    memcpy(s, p, len);
+    s[len] = '\0';
+    return s;
+}
+
+/*
+** Chạy request trong tiến trình con: stdout/stderr đi qua hai pipe về server,
+** stdin là /dev/null. Tiến trình con dùng lại bộ thực thi của shell.
+*/
+static void start_request(t_conn *c) {
+    int out[2] = {-1, -1}, err[2];
+
+    if (pipe2(out, O_CLOEXEC) == -1 || pipe2(err, O_CLOEXEC) == -1) {
+        const char *msg = "cell: pipe failed\n";
+        if (out[0] != -1) {
+            close(out[0]);
+            close(out[1]);
+        }
+        queue_frame(c, 'E', msg, strlen(msg));
+        queue_frame(c, 'X', "status=126", 10);
+        reset_request(c);
+        return;
+    }
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &c->start);
+    pid_t pid = Fork();
+    if (pid == 0) {
+        job_child(0, 0);    /* nhóm riêng; job bên trong ở lại nhóm này */
+        signal(SIGPIPE, SIG_DFL);
+        for (int i = 0; i < nconns; i++) {
+            close(conns[i]->fd);
+            if (conns[i]->pidfd != -1) close(conns[i]->pidfd);
+            if (conns[i]->out_fd != -1) close(conns[i]->out_fd);
+            if (conns[i]->err_fd != -1) close(conns[i]->err_fd);
+        }
+        int devnull = open("/dev/null", O_RDONLY);
+        if (devnull != -1) { dup2(devnull, STDIN_FILENO); close(devnull); }
+        dup2(out[1], STDOUT_FILENO);
+        dup2(err[1], STDERR_FILENO);
+        if (c->cwd && chdir(c->cwd) == -1) {
+            perror("cd");
+            exit(126);
+        }
+        for (int i = 0; i < c->nenv; i++)
+            putenv(c->env[i]);
+        status = 0;
+        cell_serving = 1;
+        if (c->argv)
+            cell_execute(c->argv, 0);
+        else if (c->line)
+            cell_run_line(c->line);
+        fflush(stdout);
+        exit(status);
+    }
+    job_setpgid(pid, 0);
+    close(out[1]);
+    close(err[1]);
+    c->pid = pid;
+    c->exited = 0;
+#ifdef SYS_pidfd_open
+    c->pidfd = syscall(SYS_pidfd_open, pid, 0);
+    if (c->pidfd != -1)
+        fcntl(c->pidfd, F_SETFD, FD_CLOEXEC);
+#else
+    c->pidfd = -1;
+#endif
+    c->out_fd = out[0];
+    c->err_fd = err[0];
+}
+
+/*
+** Xử lý các frame đã nhận đủ trong bộ đệm của kết nối.
+** Return: -1 nếu kết nối gửi dữ liệu sai giao thức
+*/
+static int process_input(t_conn *c) {
+    size_t off = 0;
+    while (c->pid <= 0 && c->in_len - off >= FRAME_HDR) {
+        uint32_t be, len;
+        memcpy(&be, c->in + off + 1, 4);
+        len = ntohl(be);
+        if (len > FRAME_MAX)
+            return -1;
+        if (c->in_len - off < FRAME_HDR + len)
+            break;
+        const unsigned char *pl = c->in + off + FRAME_HDR;
+        switch (c->in[off]) {
+        case 'D':
+            free(c->cwd);
+            c->cwd = dup_payload(pl, len);
+            break;
+        case 'V':
+            c->env = Realloc(c->env, (c->nenv + 1) * sizeof(char *));
+            c->env[c->nenv++] = dup_payload(pl, len);
+            break;
+        case 'L':
+            free(c->line);
+            c->line = dup_payload(pl, len);
+            break;
+        case 'A':
+            c->argv = Realloc(c->argv, (c->nargv + 2) * sizeof(char *));
+            c->argv[c->nargv++] = dup_payload(pl, len);
+            c->argv[c->nargv] = NULL;
+            break;
+        case 'G':
+            start_request(c);
+            break;
+        default:
+            return -1;
+        }
+        off += FRAME_HDR + len;
+    }
+    memmove(c->in, c->in + off, c->in_len - off);
+    c->in_len -= off;
+    return 0;
+}
+
+static int read_conn(t_conn *c) {
+    if (c->in_cap - c->in_len < 4096) {
+        c->in_cap = c->in_cap ? c->in_cap * 2 : 8192;
+        if (c->in_cap > 2 * (FRAME_MAX + FRAME_HDR))
+            return -1;
+        c->in = Realloc(c->in, c->in_cap);
+    }
+    ssize_t n = read(c->fd, c->in + c->in_len, c->in_cap - c->in_len);
+    if (n == -1 && (errno == EINTR || errno == EAGAIN))
+        return 0;
+    if (n <= 0)
+        return -1;
+    c->in_len += n;
+    return process_input(c);
+}
+
+// Chuyển một đoạn output của job sang client dưới dạng frame 'O'/'E'
+static int forward_output(t_conn *c, int *fdp, char type) {
+    char buf[65536];
+    ssize_t n = read(*fdp, buf, sizeof(buf));
+    if (n == -1 && errno == EINTR)
+        return 0;
+    if (n <= 0) {
+        close(*fdp);
+        *fdp = -1;
+        return 0;
+    }
+    return queue_frame(c, type, buf, n);
+}
+
+// Thu hồi tiến trình request nếu đã thoát (pidfd báo, hoặc hỏi thẳng khi không có pidfd)
+static void reap_request(t_conn *c) {
+    if (c->exited || wait4(c->pid, &c->wstatus, WNOHANG, &c->ru) <= 0)
+        return;
+    c->exited = 1;
+    clock_gettime(CLOCK_MONOTONIC, &c->end);
+    if (c->pidfd != -1) {
+        close(c->pidfd);
+        c->pidfd = -1;
+    }
+}
+
+static int try_finish(t_conn *c) {
+    struct rusage *ru = &c->ru;
+    int wstatus = c->wstatus;
+    char msg[256];
+
+    if (c->out_fd != -1 || c->err_fd != -1 || !c->exited)
+        return 0;
+    long long wall = (c->end.tv_sec - c->start.tv_sec) * 1000000LL
+        + (c->end.tv_nsec - c->start.tv_nsec) / 1000;
+    int n = snprintf(msg, sizeof(msg),
+        "status=%d signal=%d wall_us=%lld utime_us=%lld stime_us=%lld maxrss_kb=%ld",
+        WIFEXITED(wstatus) ? WEXITSTATUS(wstatus) : 128 + WTERMSIG(wstatus),
+        WIFSIGNALED(wstatus) ? WTERMSIG(wstatus) : 0, wall,
+        ru->ru_utime.tv_sec * 1000000LL + ru->ru_utime.tv_usec,
+        ru->ru_stime.tv_sec * 1000000LL + ru->ru_stime.tv_usec, ru->ru_maxrss);
+    c->pid = 0;
+    c->exited = 0;
+    reset_request(c);
+    if (queue_frame(c, 'X', msg, n) == -1)
+        return -1;
+    return process_input(c); // request kế tiếp có thể đã nằm sẵn trong bộ đệm
+}
+
+static int open_listener(const char *path) {
+    struct sockaddr_un addr;
+    struct stat sb;
+    int fd;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "cell: socket path too long: %s\n", path);
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        perror("socket");
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    // chỉ dọn socket cũ; không xóa file thường trùng đường dẫn
+    if (lstat(path, &sb) == 0) {
+        if (!S_ISSOCK(sb.st_mode)) {
+            fprintf(stderr, "cell: %s exists and is not a socket\n", path);
+            close(fd);
+            return -1;
+        }
+        unlink(path);
+    }
+    mode_t old = umask(0177);
+    int r = bind(fd, (struct sockaddr *)&addr, sizeof(addr));
+    umask(old);
+    if (r == -1 || listen(fd, SERVER_BACKLOG) == -1) {
+        perror("bind");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * cell_server - Runs the shell as a command server on a UNIX socket
+ * @path: Filesystem path of the socket to create
+ * Return: never returns on success, EXIT_FAILURE if the socket can't be set up
+ */
+int cell_server(const char *path) {
+    struct pollfd *pfds = NULL;
+    int lfd = open_listener(path);
+
+    if (lfd == -1)
+        return EXIT_FAILURE;
+    signal(SIGPIPE, SIG_IGN);
+    fprintf(stderr, "cell: serving on %s\n", path);
+    for (;;) {
+        int waiting = 0;
+        pfds = Realloc(pfds, (1 + 4 * nconns) * sizeof(*pfds));
+        int np = 0;
+        pfds[np++] = (struct pollfd){.fd = lfd, .events = POLLIN};
+        for (int i = 0; i < nconns; i++) {
+            t_conn *c = conns[i];
+            // Khi job đang chạy chỉ theo dõi output (POLLHUP vẫn báo client
+            // ngắt); request mới chờ trong socket. Hàng đợi đầy thì ngừng đọc output.
+            int full = outq_pending(c) >= SERVER_OUTQ_MAX;
+            short ev = (c->pid > 0 ? 0 : POLLIN) | (outq_pending(c) ? POLLOUT : 0);
+            pfds[np++] = (struct pollfd){.fd = c->fd, .events = ev};
+            pfds[np++] = (struct pollfd){.fd = full ? -1 : c->out_fd, .events = POLLIN};
+            pfds[np++] = (struct pollfd){.fd = full ? -1 : c->err_fd, .events = POLLIN};
+            pfds[np++] = (struct pollfd){.fd = c->pidfd, .events = POLLIN};
+            if (c->pid > 0 && !c->exited && c->pidfd == -1)
+                waiting = 1;    /* không có pidfd: hỏi waitpid định kỳ */
+        }
+        if (poll(pfds, np, waiting ? 10 : -1) == -1 && errno != EINTR) {
+            perror("poll");
+            return EXIT_FAILURE;
+        }
+        // Duyệt ngược để drop_conn (hoán đổi với phần tử cuối) không bỏ sót
+        for (int i = nconns - 1; i >= 0; i--) {
+            t_conn *c = conns[i];
+            struct pollfd *pc = &pfds[1 + 4 * i];
+            int bad = 0;
+            if (pc[0].revents & POLLOUT)
+                bad = flush_out(c);
+            if (!bad && (pc[0].revents & (POLLIN | POLLHUP | POLLERR)))
+                bad = read_conn(c);
+            if (!bad && c->out_fd != -1 && pc[1].fd != -1 && pc[1].revents)
+                bad = forward_output(c, &c->out_fd, 'O');
+            if (!bad && c->err_fd != -1 && pc[2].fd != -1 && pc[2].revents)
+                bad = forward_output(c, &c->err_fd, 'E');
+            if (!bad && c->pid > 0) {
+                if (c->pidfd == -1 || pc[3].revents)
+                    reap_request(c);
+                bad = try_finish(c);
+            }
+            if (bad)
+                drop_conn(i);
+        }
+        if (pfds[0].revents & POLLIN) {
+            int cfd = accept4(lfd, NULL, NULL, SOCK_CLOEXEC | SOCK_NONBLOCK);
+            if (cfd != -1) {
+                t_conn *c = Malloc(sizeof(*c));
+                memset(c, 0, sizeof(*c));
+                c->fd = cfd;
+                c->out_fd = c->err_fd = c->pidfd = -1;
+                conns = Realloc(conns, (nconns + 1) * sizeof(*conns));
+                conns[nconns++] = c;
+            }
+        }
+    }
+}
+
+static int read_full(int fd, void *buf, size_t len) {
+    char *p = buf;
+    while (len > 0) {
+        ssize_t n = read(fd, p, len);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        p += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/**
+ * cell_client - Minimal client for server mode
+ * @path: Socket path of a running `cell --server`
+ * @ac: Number of remaining arguments
+ * @av: [-C dir] [-e KEY=VALUE]... [-v] [-c line | command words...]
+ * Return: exit status of the remote command
+ *
+ * Command words are sent one frame each and run as that exact argv; -c sends
+ * a whole line for the server's shell to parse.
+ */
+int cell_client(const char *path, int ac, char **av) {
+    struct sockaddr_un addr;
+    const char *line = NULL;
+    int verbose = 0, i = 0, fd;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd == -1 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        perror("connect");
+        return EX_UNAVAILABLE;
+    }
+    for (; i < ac && av[i][0] == '-'; i++) {
+        if (!strcmp(av[i], "-C") && i + 1 < ac) {
+            send_frame(fd, 'D', av[i + 1], strlen(av[i + 1]));
+            i++;
+        } else if (!strcmp(av[i], "-e") && i + 1 < ac) {
+            send_frame(fd, 'V', av[i + 1], strlen(av[i + 1]));
+            i++;
+        } else if (!strcmp(av[i], "-c") && i + 1 < ac) {
+            line = av[++i];
+        } else if (!strcmp(av[i], "-v")) {
+            verbose = 1;
+        } else if (!strcmp(av[i], "--")) {
+            i++;
+            break;
+        } else {
+            break;
+        }
+    }
+    // server cắt kết nối khi gặp frame quá FRAME_MAX: báo lỗi ngay ở đây
+    int too_long = line && strlen(line) > FRAME_MAX;
+    for (int k = i; k < ac; k++)
+        too_long |= strlen(av[k]) > FRAME_MAX;
+    if (too_long) {
+        fprintf(stderr, "cell: argument too long (max %d bytes)\n", FRAME_MAX);
+        close(fd);
+        return EX_USAGE;
+    }
+    if (line)
+        send_frame(fd, 'L', line, strlen(line));
+    for (; i < ac; i++)
+        send_frame(fd, 'A', av[i], strlen(av[i]));
+    send_frame(fd, 'G', NULL, 0);
+
+    char *buf = Malloc(FRAME_MAX + 1);
+    for (;;) {
+        unsigned char hdr[FRAME_HDR];
+        uint32_t be, len;
+        if (read_full(fd, hdr, FRAME_HDR) == -1)
+            break;
+        memcpy(&be, hdr + 1, 4);
+        len = ntohl(be);
+        if (len > FRAME_MAX || read_full(fd, buf, len) == -1)
+            break;
+        if (hdr[0] == 'O')
+            write_all(STDOUT_FILENO, buf, len);
+        else if (hdr[0] == 'E')
+            write_all(STDERR_FILENO, buf, len);
+        else if (hdr[0] == 'X') {
+            int rc = EX_PROTOCOL;
+            buf[len] = '\0';
+            sscanf(buf, "status=%d", &rc);
+            if (verbose)
+                fprintf(stderr, "%s\n", buf);
+            free(buf);
+            close(fd);
+            return rc;
+        }
+    }
+    fprintf(stderr, "cell: connection closed by server\n");
+    free(buf);
+    close(fd);
+    return EX_PROTOCOL;
+}
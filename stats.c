@@ -0,0 +1,117 @@
+#include "cell.h"
+#include "stats.h"
+#include <sys/mman.h>
+
+static t_stats local_stats;
+t_stats *g_stats = &local_stats;
+
+static const char *phase_names[STAT_NPHASES] = { "parse", "spawn", "wait" };
+
+/**
+ * stats_init - Moves the counters into memory shared with future children
+ * Falls back to the process-local struct if the mapping fails.
+ */
+void stats_init(void) {
+    void *m = mmap(NULL, sizeof(t_stats), PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (m == MAP_FAILED)
+        return;
+    memcpy(m, &local_stats, sizeof(t_stats));
+    g_stats = m;
+}
+
+void stats_record(int phase, uint64_t start_ns) {
+    uint64_t ns = stats_now() - start_ns;
+    int b = ns ? 63 - __builtin_clzll(ns) : 0;
+    if (b >= STATS_HIST_BUCKETS)
+        b = STATS_HIST_BUCKETS - 1;
+    STAT_INC(hist[phase][b]);
+    STAT_ADD(hist_sum_ns[phase], ns);
+}
+
+static void fmt_ns(char *buf, size_t size, uint64_t ns) {
+    if (ns >= 1000000000ULL) snprintf(buf, size, "%.1fs", ns / 1e9);
+    else if (ns >= 1000000ULL) snprintf(buf, size, "%.1fms", ns / 1e6);
+    else if (ns >= 1000ULL) snprintf(buf, size, "%.1fus", ns / 1e3);
+    else snprintf(buf, size, "%lluns", (unsigned long long)ns);
+}
+
+static uint64_t hist_count(int phase) {
+    uint64_t n = 0;
+    for (int b = 0; b < STATS_HIST_BUCKETS; b++)
+        n += g_stats->hist[phase][b];
+    return n;
+}
+
+static void print_human(const t_stats *s) {
+    printf("forks            %llu\n", (unsigned long long)s->forks);
+    printf("execs            %llu\n", (unsigned long long)s->execs);
+    printf("exec failures    %llu\n", (unsigned long long)s->exec_failures);
+    printf("alias expansions %llu\n", (unsigned long long)s->alias_expansions);
+    printf("tokens           %llu\n", (unsigned long long)s->tokens);
+    printf("split bytes      %llu\n", (unsigned long long)s->split_bytes);
+    printf("jobs created     %llu\n", (unsigned long long)s->jobs_created);
+    printf("jobs reaped      %llu\n", (unsigned long long)s->jobs_reaped);
+    printf("builtin calls:\n");
+    for (int i = 0; g_builtin[i].builtin_name && i < STATS_MAX_BUILTINS; i++)
+        if (s->builtin_calls[i])
+            printf("  %-14s %llu\n", g_builtin[i].builtin_name,
+                   (unsigned long long)s->builtin_calls[i]);
+    for (int ph = 0; ph < STAT_NPHASES; ph++) {
+        uint64_t n = hist_count(ph);
+        char lo[16], hi[16], avg[16];
+        fmt_ns(avg, sizeof(avg), n ? s->hist_sum_ns[ph] / n : 0);
+        printf("%s latency: %llu samples, avg %s\n", phase_names[ph],
+               (unsigned long long)n, avg);
+        for (int b = 0; b < STATS_HIST_BUCKETS; b++) {
+            if (!s->hist[ph][b]) continue;
+            fmt_ns(lo, sizeof(lo), 1ULL << b);
+            fmt_ns(hi, sizeof(hi), 1ULL << (b + 1));
+            printf("  [%7s, %7s) %llu\n", lo, hi, (unsigned long long)s->hist[ph][b]);
+        }
+    }
+}
+
+static void print_json(const t_stats *s) {
+    printf("{\"forks\":%llu,\"execs\":%llu,\"exec_failures\":%llu,"
+           "\"alias_expansions\":%llu,\"tokens\":%llu,\"split_bytes\":%llu,"
+           "\"jobs_created\":%llu,\"jobs_reaped\":%llu,\"builtin_calls\":{",
+           (unsigned long long)s->forks, (unsigned long long)s->execs,
+           (unsigned long long)s->exec_failures, (unsigned long long)s->alias_expansions,
+           (unsigned long long)s->tokens, (unsigned long long)s->split_bytes,
+           (unsigned long long)s->jobs_created, (unsigned long long)s->jobs_reaped);
+    const char *sep = "";
+    for (int i = 0; g_builtin[i].builtin_name && i < STATS_MAX_BUILTINS; i++) {
+        if (!s->builtin_calls[i]) continue;
+        printf("%s\"%s\":%llu", sep, g_builtin[i].builtin_name,
+               (unsigned long long)s->builtin_calls[i]);
+        sep = ",";
+    }
+    printf("},\"latency_ns\":{");
+    for (int ph = 0; ph < STAT_NPHASES; ph++) {
+        printf("%s\"%s\":{\"sum\":%llu,\"buckets\":[", ph ? "," : "", phase_names[ph],
+               (unsigned long long)s->hist_sum_ns[ph]);
+        for (int b = 0; b < STATS_HIST_BUCKETS; b++)
+            printf("%s%llu", b ? "," : "", (unsigned long long)s->hist[ph][b]);
+        printf("]}");
+    }
+    printf("}}\n");
+}
+
+// Lệnh cellstat: xem/đặt lại bộ đếm nội bộ của shell
+int cell_cellstat(char **args) {
+    if (!args[1]) {
+        print_human(g_stats);
+        return 0;
+    }
+    if (!strcmp(args[1], "-j") || !strcmp(args[1], "--json")) {
+        print_json(g_stats);
+        return 0;
+    }
+    if (!strcmp(args[1], "-r") || !strcmp(args[1], "--reset")) {
+        memset(g_stats, 0, sizeof(t_stats));
+        return 0;
+    }
+    fprintf(stderr, "cellstat: usage: cellstat [-j|--json] [-r|--reset]\n");
+    return 1;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <stdint.h>
+#include <time.h>
+
+#define STATS_MAX_BUILTINS 96
+#define STATS_HIST_BUCKETS 40   /* bucket i: [2^i, 2^(i+1)) ns */
+
+enum {
+    STAT_PARSE,
+    STAT_SPAWN,
+    STAT_WAIT,
+    STAT_NPHASES
+};
+
+/*
+** Internal counters of the shell itself. The struct lives in a shared
+** anonymous mapping so that increments done in forked children (exec
+** attempts and failures) are visible to the parent shell.
+*/
+typedef struct s_stats {
+    uint64_t forks;
+    uint64_t execs;
+    uint64_t exec_failures;
+    uint64_t alias_expansions;
+    uint64_t tokens;
+    uint64_t split_bytes;
+    uint64_t jobs_created;
+    uint64_t jobs_reaped;
+    uint64_t builtin_calls[STATS_MAX_BUILTINS];
+    uint64_t hist[STAT_NPHASES][STATS_HIST_BUCKETS];
+    uint64_t hist_sum_ns[STAT_NPHASES];
+} t_stats;
+
+extern t_stats *g_stats;
+
+#define STAT_INC(f)    __atomic_fetch_add(&g_stats->f, 1, __ATOMIC_RELAXED)
+#define STAT_ADD(f, n) __atomic_fetch_add(&g_stats->f, (n), __ATOMIC_RELAXED)
+
+static inline uint64_t stats_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void stats_init(void);
+void stats_record(int phase, uint64_t start_ns);
+int  cell_cellstat(char **args);
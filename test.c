@@ -0,0 +1,250 @@
+#include "cell.h"
+#include "vars.h"
+#include <fnmatch.h>
+#include <regex.h>
+#include <sys/stat.h>
+
+/*
+** test / [ / [[ chạy trong tiến trình shell, không fork.
+**
+** Kiểm tra file dùng đúng một stat (lstat cho -L/-h); -r/-w/-x dùng một
+** access(). [[ ]] thêm && || ( ), so khớp mẫu với == / != và regex với =~.
+** Trả về 0 (đúng), 1 (sai), 2 (lỗi cú pháp).
+*/
+
+typedef struct s_test {
+    char **av;
+    int pos;
+    int argc;
+    int dbl;        /* [[ ]] */
+    int err;
+} t_test;
+
+static int test_or(t_test *t);
+
+static const char *peek(t_test *t, int k) {
+    return t->pos + k < t->argc ? t->av[t->pos + k] : NULL;
+}
+
+static void syntax(t_test *t, const char *msg, const char *tok) {
+    if (!t->err)
+        fprintf(stderr, "%s: %s%s%s\n", t->dbl ? "[[" : "test", msg,
+                tok ? ": " : "", tok ? tok : "");
+    t->err = 1;
+}
+
+static int is_binop(t_test *t, const char *s) {
+    static const char *ops[] = { "=", "==", "!=", "<", ">", "-eq", "-ne", "-lt",
+                                 "-le", "-gt", "-ge", "-nt", "-ot", "-ef", NULL };
+    if (!s) return 0;
+    if (t->dbl && !strcmp(s, "=~")) return 1;
+    for (int i = 0; ops[i]; i++)
+        if (!strcmp(s, ops[i])) return 1;
+    return 0;
+}
+
+static int is_unop(const char *s) {
+    return s && s[0] == '-' && s[1] && !s[2] && strchr("bcdefghkprsuwxLSOGntz", s[1]);
+}
+
+static int to_int(t_test *t, const char *s, long long *v) {
+    char *end;
+    // [[ ]] tính số học như bash; test chỉ nhận số nguyên thuần
+    if (t->dbl)
+        return arith_eval(s, v) == 0 ? 1 : (t->err = 1, 0);
+    errno = 0;
+    *v = strtoll(s, &end, 10);
+    while (*end == ' ' || *end == '\t') end++;
+    if (errno || end == s || *end) {
+        syntax(t, "integer expression expected", s);
+        return 0;
+    }
+    return 1;
+}
+
+static int file_test(char op, const char *path) {
+    struct stat st;
+    if (op == 'r' || op == 'w' || op == 'x')
+        return !access(path, op == 'r' ? R_OK : op == 'w' ? W_OK : X_OK);
+    if (op == 'L' || op == 'h')
+        return !lstat(path, &st) && S_ISLNK(st.st_mode);
+    if (stat(path, &st))
+        return 0;
+    switch (op) {
+    case 'e': return 1;
+    case 'f': return S_ISREG(st.st_mode);
+    case 'd': return S_ISDIR(st.st_mode);
+    case 'b': return S_ISBLK(st.st_mode);
+    case 'c': return S_ISCHR(st.st_mode);
+    case 'p': return S_ISFIFO(st.st_mode);
+    case 'S': return S_ISSOCK(st.st_mode);
+    case 's': return st.st_size > 0;
+    case 'g': return (st.st_mode & S_ISGID) != 0;
+    case 'u': return (st.st_mode & S_ISUID) != 0;
+    case 'k': return (st.st_mode & S_ISVTX) != 0;
+    case 'O': return st.st_uid == geteuid();
+    case 'G': return st.st_gid == getegid();
+    }
+    return 0;
+}
+
+static int unary(t_test *t, const char *op, const char *arg) {
+    switch (op[1]) {
+    case 'n': return arg[0] != '\0';
+    case 'z': return arg[0] == '\0';
+    case 't': {
+        long long fd;
+        return to_int(t, arg, &fd) && isatty((int)fd);
+    }
+    }
+    return file_test(op[1], arg);
+}
+
+static int mtime_cmp(const char *a, const char *b, int newer) {
+    struct stat sa, sb;
+    int ha = !stat(a, &sa), hb = !stat(b, &sb);
+    if (!ha || !hb)
+        return newer ? ha && !hb : hb && !ha;
+    long long ta = sa.st_mtim.tv_sec * 1000000000LL + sa.st_mtim.tv_nsec;
+    long long tb = sb.st_mtim.tv_sec * 1000000000LL + sb.st_mtim.tv_nsec;
+    return newer ? ta > tb : ta < tb;
+}
+
+static int binary(t_test *t, const char *l, const char *op, const char *r) {
+    long long x, y;
+
+    if (!strcmp(op, "=") || !strcmp(op, "==") || !strcmp(op, "!=")) {
+        // [[ ]]: vế phải là mẫu glob
+        int eq = t->dbl ? !fnmatch(r, l, 0) : !strcmp(l, r);
+        return op[0] == '!' ? !eq : eq;
+    }
+    if (!strcmp(op, "<")) return strcmp(l, r) < 0;
+    if (!strcmp(op, ">")) return strcmp(l, r) > 0;
+    if (!strcmp(op, "=~")) {
+        regex_t re;
+        if (regcomp(&re, r, REG_EXTENDED | REG_NOSUB)) {
+            syntax(t, "invalid regular expression", r);
+            return 0;
+        }
+        int m = !regexec(&re, l, 0, NULL, 0);
+        regfree(&re);
+        return m;
+    }
+    if (!strcmp(op, "-nt")) return mtime_cmp(l, r, 1);
+    if (!strcmp(op, "-ot")) return mtime_cmp(l, r, 0);
+    if (!strcmp(op, "-ef")) {
+        struct stat sa, sb;
+        return !stat(l, &sa) && !stat(r, &sb) && sa.st_dev == sb.st_dev && sa.st_ino == sb.st_ino;
+    }
+    if (!to_int(t, l, &x) || !to_int(t, r, &y))
+        return 0;
+    if (!strcmp(op, "-eq")) return x == y;
+    if (!strcmp(op, "-ne")) return x != y;
+    if (!strcmp(op, "-lt")) return x < y;
+    if (!strcmp(op, "-le")) return x <= y;
+    if (!strcmp(op, "-gt")) return x > y;
+    return x >= y;  /* -ge */
+}
+
+static int test_primary(t_test *t) {
+    const char *a = peek(t, 0);
+
+    if (!a) {
+        syntax(t, "argument expected", NULL);
+        return 0;
+    }
+    if (!strcmp(a, "(") && !is_binop(t, peek(t, 1))) {
+        t->pos++;
+        int v = test_or(t);
+        if (!peek(t, 0) || strcmp(peek(t, 0), ")"))
+            syntax(t, "')' expected", peek(t, 0));
+        else
+            t->pos++;
+        return v;
+    }
+    if (is_binop(t, peek(t, 1)) && peek(t, 2)) {
+        t->pos += 3;
+        return binary(t, a, t->av[t->pos - 2], t->av[t->pos - 1]);
+    }
+    if (is_unop(a) && peek(t, 1)) {
+        t->pos += 2;
+        return unary(t, a, t->av[t->pos - 1]);
+    }
+    t->pos++;
+    return a[0] != '\0';
+}
+
+static int test_not(t_test *t) {
+    const char *a = peek(t, 0);
+    // "!" đứng cuối hoặc trước toán tử hai ngôi là chuỗi thường
+    if (a && !strcmp(a, "!") && peek(t, 1) && !is_binop(t, peek(t, 1))) {
+        t->pos++;
+        return !test_not(t);
+    }
+    return test_primary(t);
+}
+
+static int test_and(t_test *t) {
+    int v = test_not(t);
+    const char *op;
+    while ((op = peek(t, 0)) && !strcmp(op, t->dbl ? "&&" : "-a")) {
+        t->pos++;
+        int r = test_not(t);
+        v = v && r;
+    }
+    return v;
+}
+
+static int test_or(t_test *t) {
+    int v = test_and(t);
+    const char *op;
+    while ((op = peek(t, 0)) && !strcmp(op, t->dbl ? "||" : "-o")) {
+        t->pos++;
+        int r = test_and(t);
+        v = v || r;
+    }
+    return v;
+}
+
+static int test_run(char **av, int argc, int dbl) {
+    t_test t = { .av = av, .argc = argc, .dbl = dbl };
+    if (argc == 0)
+        return 1;
+    int v = test_or(&t);
+    if (!t.err && t.pos < argc)
+        syntax(&t, "unexpected argument", av[t.pos]);
+    return t.err ? 2 : !v;
+}
+
+/**
+ * cell_test - test and [ builtins
+ * @args: test expr... | [ expr... ]
+ * Return: 0 if true, 1 if false, 2 on error
+ */
+int cell_test(char **args) {
+    int argc = 0;
+    while (args[argc]) argc++;
+    if (!strcmp(args[0], "[")) {
+        if (strcmp(args[argc - 1], "]")) {
+            fprintf(stderr, "[: missing ']'\n");
+            return 2;
+        }
+        argc--;
+    }
+    return test_run(args + 1, argc - 1, 0);
+}
+
+/**
+ * cell_dbracket - [[ expr ]] with &&, ||, glob == and regex =~
+ * @args: [[ expr... ]]
+ * Return: 0 if true, 1 if false, 2 on error
+ */
+int cell_dbracket(char **args) {
+    int argc = 0;
+    while (args[argc]) argc++;
+    if (strcmp(args[argc - 1], "]]")) {
+        fprintf(stderr, "[[: missing ']]'\n");
+        return 2;
+    }
+    return test_run(args + 1, argc - 2, 1);
+}
@@ -0,0 +1,719 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include "textutil.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#if defined(__x86_64__)
+# include <immintrin.h>
+#endif
+
+extern int status;
+
+typedef struct s_counts {
+    size_t lines;
+    size_t words;
+    size_t bytes;
+} t_counts;
+
+static int is_space(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/*
+** Nhân quét. Bản đếm từ nhận *ws = 1 nếu byte ngay trước vùng là khoảng
+** trắng (đầu input cũng tính là khoảng trắng) và trả lại trạng thái cuối
+** vùng, nên gọi nối tiếp theo khối hay chia cho nhiều luồng đều ra cùng số.
+** Một từ bắt đầu ở byte không trắng đứng sau byte trắng.
+*/
+static size_t count_nl_scalar(const char *p, size_t n) {
+    size_t k = 0;
+    for (size_t i = 0; i < n; i++)
+        k += p[i] == '\n';
+    return k;
+}
+
+static void count_lw_scalar(const unsigned char *p, size_t n, int *ws, t_counts *c) {
+    int prev = *ws;
+    for (size_t i = 0; i < n; i++) {
+        int s = is_space(p[i]);
+        c->lines += p[i] == '\n';
+        c->words += prev && !s;
+        prev = s;
+    }
+    *ws = prev;
+}
+
+static const char *find_scalar(const char *h, size_t n, const char *s, size_t m) {
+    return memmem(h, n, s, m);
+}
+
+#if defined(__x86_64__)
+
+__attribute__((target("avx2")))
+static size_t count_nl_avx2(const char *p, size_t n) {
+    const __m256i nl = _mm256_set1_epi8('\n');
+    size_t i = 0, k = 0;
+    while (i + 32 <= n) {
+        // mỗi byte của acc đếm tới 255 lần rồi mới cộng dồn
+        __m256i acc = _mm256_setzero_si256();
+        size_t lim = n - i > 255 * 32 ? i + 255 * 32 : n;
+        for (; i + 32 <= lim; i += 32)
+            acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(
+                      _mm256_loadu_si256((const __m256i *)(p + i)), nl));
+        __m256i sum = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+        k += _mm256_extract_epi64(sum, 0) + _mm256_extract_epi64(sum, 1)
+           + _mm256_extract_epi64(sum, 2) + _mm256_extract_epi64(sum, 3);
+    }
+    return k + count_nl_scalar(p + i, n - i);
+}
+
+__attribute__((target("avx2,popcnt")))
+static void count_lw_avx2(const unsigned char *p, size_t n, int *ws, t_counts *c) {
+    const __m256i nl = _mm256_set1_epi8('\n'), sp = _mm256_set1_epi8(' ');
+    const __m256i tab = _mm256_set1_epi8('\t'), four = _mm256_set1_epi8(4);
+    uint32_t carry = *ws;
+    size_t i = 0, lines = 0, words = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(p + i));
+        // \t..\r: (v - '\t') <= 4 không dấu
+        __m256i t = _mm256_sub_epi8(v, tab);
+        __m256i s = _mm256_or_si256(_mm256_cmpeq_epi8(v, sp),
+                                    _mm256_cmpeq_epi8(_mm256_min_epu8(t, four), t));
+        uint32_t S = _mm256_movemask_epi8(s);
+        lines += __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, nl)));
+        words += __builtin_popcount(~S & ((S << 1) | carry));
+        carry = S >> 31;
+    }
+    c->lines += lines;
+    c->words += words;
+    *ws = carry;
+    count_lw_scalar(p + i, n - i, ws, c);
+}
+
+// Lọc theo byte đầu và byte cuối của mẫu, chỉ memcmp ở vị trí qua được lọc
+__attribute__((target("avx2")))
+static const char *find_avx2(const char *h, size_t n, const char *s, size_t m) {
+    if (m == 1)
+        return memchr(h, s[0], n);
+    if (m > n)
+        return NULL;
+    const __m256i first = _mm256_set1_epi8(s[0]), last = _mm256_set1_epi8(s[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 32 <= n; i += 32) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(h + i));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(h + i + m - 1));
+        uint32_t mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(a, first),
+                                                              _mm256_cmpeq_epi8(b, last)));
+        for (; mask; mask &= mask - 1) {
+            size_t k = i + __builtin_ctz(mask);
+            if (!memcmp(h + k + 1, s + 1, m - 2))
+                return h + k;
+        }
+    }
+    return memmem(h + i, n - i, s, m);
+}
+
+static size_t count_nl_sse2(const char *p, size_t n) {
+    const __m128i nl = _mm_set1_epi8('\n');
+    size_t i = 0, k = 0;
+    while (i + 16 <= n) {
+        __m128i acc = _mm_setzero_si128();
+        size_t lim = n - i > 255 * 16 ? i + 255 * 16 : n;
+        for (; i + 16 <= lim; i += 16)
+            acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + i)), nl));
+        __m128i sum = _mm_sad_epu8(acc, _mm_setzero_si128());
+        k += _mm_cvtsi128_si64(sum) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(sum, sum));
+    }
+    return k + count_nl_scalar(p + i, n - i);
+}
+
+static void count_lw_sse2(const unsigned char *p, size_t n, int *ws, t_counts *c) {
+    const __m128i nl = _mm_set1_epi8('\n'), sp = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t'), four = _mm_set1_epi8(4);
+    uint32_t carry = *ws;
+    size_t i = 0, lines = 0, words = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i *)(p + i));
+        __m128i t = _mm_sub_epi8(v, tab);
+        __m128i s = _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(_mm_min_epu8(t, four), t));
+        uint32_t S = _mm_movemask_epi8(s);
+        lines += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)));
+        words += __builtin_popcount(~S & ((S << 1) | carry) & 0xffff);
+        carry = S >> 15;
+    }
+    c->lines += lines;
+    c->words += words;
+    *ws = carry;
+    count_lw_scalar(p + i, n - i, ws, c);
+}
+
+static const char *find_sse2(const char *h, size_t n, const char *s, size_t m) {
+    if (m == 1)
+        return memchr(h, s[0], n);
+    if (m > n)
+        return NULL;
+    const __m128i first = _mm_set1_epi8(s[0]), last = _mm_set1_epi8(s[m - 1]);
+    size_t i = 0;
+    for (; i + m - 1 + 16 <= n; i += 16) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(h + i));
+        __m128i b = _mm_loadu_si128((const __m128i *)(h + i + m - 1));
+        uint32_t mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first),
+                                                        _mm_cmpeq_epi8(b, last)));
+        for (; mask; mask &= mask - 1) {
+            size_t k = i + __builtin_ctz(mask);
+            if (!memcmp(h + k + 1, s + 1, m - 2))
+                return h + k;
+        }
+    }
+    return memmem(h + i, n - i, s, m);
+}
+
+#endif
+
+static size_t (*count_nl)(const char *p, size_t n);
+static void (*count_lw)(const unsigned char *p, size_t n, int *ws, t_counts *c);
+static const char *(*find_str)(const char *h, size_t n, const char *s, size_t m);
+
+static void scan_init(void) {
+    if (count_nl)
+        return;
+    count_nl = count_nl_scalar;
+    count_lw = count_lw_scalar;
+    find_str = find_scalar;
+#if defined(__x86_64__)
+    const char *force = getenv("CELL_SIMD");
+    __builtin_cpu_init();
+    if (force && !strcmp(force, "scalar"))
+        return;
+    if (__builtin_cpu_supports("avx2") && !(force && !strcmp(force, "sse2"))) {
+        count_nl = count_nl_avx2;
+        count_lw = count_lw_avx2;
+        find_str = find_avx2;
+    } else {
+        count_nl = count_nl_sse2;   /* SSE2 có sẵn trên mọi x86-64 */
+        count_lw = count_lw_sse2;
+        find_str = find_sse2;
+    }
+#endif
+}
+
+// Số luồng cho size byte: mỗi luồng ít nhất TEXT_THREAD_MIN, không quá số CPU
+static int text_threads(size_t size) {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t n = size / TEXT_THREAD_MIN;
+    if (ncpu > 0 && n > (size_t)ncpu)
+        n = ncpu;
+    if (n > TEXT_MAX_THREADS)
+        n = TEXT_MAX_THREADS;
+    return n < 1 ? 1 : (int)n;
+}
+
+// Chạy fn trên n phần tử: phần tử 0 ở luồng hiện tại, còn lại mỗi cái một luồng
+static void run_parallel(void *(*fn)(void *), void *items, size_t size, int n) {
+    pthread_t tid[TEXT_MAX_THREADS];
+    int started[TEXT_MAX_THREADS] = {0};
+
+    for (int k = 1; k < n; k++)
+        started[k] = !pthread_create(&tid[k], NULL, fn, (char *)items + k * size);
+    fn(items);
+    for (int k = 1; k < n; k++) {
+        if (started[k])
+            pthread_join(tid[k], NULL);
+        else
+            fn((char *)items + k * size);   /* không tạo được luồng: tự làm */
+    }
+}
+
+/* ---------------------------------- wc ---------------------------------- */
+
+typedef struct s_wcpart {
+    const unsigned char *p;
+    size_t n;
+    int ws;
+    int words;
+    t_counts c;
+} t_wcpart;
+
+static void *wc_part(void *arg) {
+    t_wcpart *w = arg;
+    if (w->words)
+        count_lw(w->p, w->n, &w->ws, &w->c);
+    else
+        w->c.lines = count_nl((const char *)w->p, w->n);
+    return NULL;
+}
+
+// Chia vùng nhớ tùy ý: từ ở ranh giới được nhận ra nhờ byte ngay trước phần
+static void wc_mem(const unsigned char *p, size_t n, int words, t_counts *c) {
+    t_wcpart part[TEXT_MAX_THREADS] = {0};
+    int nt = text_threads(n);
+    size_t per = n / nt;
+
+    for (int k = 0; k < nt; k++) {
+        size_t start = k * per;
+        part[k].p = p + start;
+        part[k].n = k == nt - 1 ? n - start : per;
+        part[k].ws = start == 0 || is_space(p[start - 1]);
+        part[k].words = words;
+    }
+    run_parallel(wc_part, part, sizeof(*part), nt);
+    for (int k = 0; k < nt; k++) {
+        c->lines += part[k].c.lines;
+        c->words += part[k].c.words;
+    }
+}
+
+// Return: 0, hoặc -1 nếu đọc lỗi (số đếm được đến lúc đó vẫn hợp lệ)
+static int wc_fd(int fd, const struct stat *st, int words, int lines, t_counts *c) {
+    off_t off = S_ISREG(st->st_mode) ? lseek(fd, 0, SEEK_CUR) : -1;
+
+    if (off >= 0 && st->st_size > off) {
+        size_t n = st->st_size - off;
+        c->bytes = n;
+        if (!words && !lines)
+            return 0;   /* chỉ -c: kích thước là đủ */
+        unsigned char *map = mmap(NULL, st->st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, st->st_size, MADV_SEQUENTIAL);
+            wc_mem(map + off, n, words, c);
+            munmap(map, st->st_size);
+            return 0;
+        }
+        c->bytes = 0;
+    }
+    // pipe, tty, file trong /proc (size 0): đọc theo khối, giữ trạng thái từ qua khối
+    unsigned char *buf = Malloc(TEXT_BLOCK);
+    int ws = 1, rc = 0;
+    ssize_t r;
+    while ((r = read(fd, buf, TEXT_BLOCK)) != 0) {
+        if (r == -1) {
+            if (errno == EINTR)
+                continue;
+            rc = -1;
+            break;
+        }
+        c->bytes += r;
+        if (words)
+            count_lw(buf, r, &ws, c);
+        else if (lines)
+            c->lines += count_nl((const char *)buf, r);
+    }
+    free(buf);
+    return rc;
+}
+
+// Như coreutils: số đầu tiên cũng được canh theo độ rộng
+static void wc_print(const t_counts *c, const int show[3], int width, const char *name) {
+    const size_t v[3] = { c->lines, c->words, c->bytes };
+    const char *sep = "";
+    for (int k = 0; k < 3; k++) {
+        if (!show[k])
+            continue;
+        printf("%s%*zu", sep, width, v[k]);
+        sep = " ";
+    }
+    if (name)
+        printf(" %s", name);
+    putchar('\n');
+}
+
+/*
+** Độ rộng cột như coreutils: một file một số thì không canh; có input
+** không phải file thường (pipe, tty) thì ít nhất 7; còn lại là số chữ số
+** của tổng kích thước các file thường.
+*/
+static int wc_width(char **files, int nfiles, int nshow) {
+    struct stat st;
+    size_t total = 0;
+    int width = 1, minimum = 1;
+
+    if (nfiles <= 1 && nshow == 1)
+        return 1;
+    for (int i = 0; i < (nfiles ? nfiles : 1); i++) {
+        const char *f = nfiles ? files[i] : "-";
+        if ((!strcmp(f, "-") ? fstat(STDIN_FILENO, &st) : stat(f, &st)) == -1)
+            continue;
+        if (S_ISREG(st.st_mode))
+            total += st.st_size;
+        else
+            minimum = 7;
+    }
+    for (; total >= 10; total /= 10)
+        width++;
+    return width < minimum ? minimum : width;
+}
+
+// Tùy chọn wc mà builtin không làm (-m, -L, --files0-from...): dùng lệnh ngoài
+static int text_external(char **args) {
+    cell_launch(args, 0);
+    return status;
+}
+
+/**
+ * cell_wc - Counts lines, words and bytes without forking
+ * @args: wc [-l] [-w] [-c] [file...]; no file or "-" reads standard input
+ * Return: 0, or 1 if some file could not be read
+ */
+int cell_wc(char **args) {
+    int show[3] = {0}, nfiles = 0, rc = 0, opts = 1, argc = 0;
+    while (args[argc]) argc++;
+    char **files = Malloc(argc * sizeof(char *));
+
+    for (int i = 1; args[i]; i++) {
+        const char *a = args[i];
+        if (opts && !strcmp(a, "--")) {
+            opts = 0;
+        } else if (opts && a[0] == '-' && a[1] == '-') {
+            if (!strcmp(a, "--lines")) show[0] = 1;
+            else if (!strcmp(a, "--words")) show[1] = 1;
+            else if (!strcmp(a, "--bytes")) show[2] = 1;
+            else goto external;
+        } else if (opts && a[0] == '-' && a[1]) {
+            for (const char *o = a + 1; *o; o++) {
+                if (*o == 'l') show[0] = 1;
+                else if (*o == 'w') show[1] = 1;
+                else if (*o == 'c') show[2] = 1;
+                else goto external;
+            }
+        } else {
+            files[nfiles++] = args[i];
+        }
+    }
+    if (!show[0] && !show[1] && !show[2])
+        show[0] = show[1] = show[2] = 1;
+
+    scan_init();
+    int width = wc_width(files, nfiles, show[0] + show[1] + show[2]);
+    t_counts total = {0};
+    for (int i = 0; i < (nfiles ? nfiles : 1); i++) {
+        const char *name = nfiles ? files[i] : NULL;
+        int std = !name || !strcmp(name, "-");
+        int fd = std ? STDIN_FILENO : open(name, O_RDONLY | O_CLOEXEC);
+        t_counts c = {0};
+        struct stat st;
+        if (fd == -1 || fstat(fd, &st) == -1) {
+            fprintf(stderr, "wc: %s: %s\n", std ? "'standard input'" : name, strerror(errno));
+            rc = 1;
+            continue;
+        }
+        if (wc_fd(fd, &st, show[1], show[0], &c) == -1) {
+            fprintf(stderr, "wc: %s: %s\n", std ? "'standard input'" : name, strerror(errno));
+            rc = 1;
+        }
+        if (!std)
+            close(fd);
+        wc_print(&c, show, width, name);
+        total.lines += c.lines;
+        total.words += c.words;
+        total.bytes += c.bytes;
+    }
+    if (nfiles > 1)
+        wc_print(&total, show, width, "total");
+    free(files);
+    return rc;
+external:
+    free(files);
+    return text_external(args);
+}
+
+/* --------------------------------- grep --------------------------------- */
+
+typedef struct s_grep {
+    const char *pat;
+    size_t plen;
+    int count;          /* -c */
+    int invert;         /* -v */
+    int number;         /* -n */
+    int list;           /* -l */
+    int quiet;          /* -q */
+    int no_msg;         /* -s */
+    int with_name;      /* -H / nhiều file, -h tắt */
+    int matched;
+    int errors;
+} t_grep;
+
+typedef struct s_hit {
+    size_t start;
+    size_t end;         /* vị trí '\n' cuối dòng (hoặc cuối vùng) */
+    size_t line;        /* số thứ tự dòng trong phần, từ 0 */
+} t_hit;
+
+typedef struct s_gpart {
+    const char *p;
+    size_t start;       /* luôn ở đầu dòng */
+    size_t end;         /* ngay sau '\n', hoặc cuối input */
+    const t_grep *g;
+    int first_only;     /* chỉ cần biết có dòng được chọn hay không */
+    int keep;           /* giữ vị trí các dòng để in */
+    size_t lines;       /* số dòng trong phần (khi -n) */
+    size_t count;       /* số dòng được chọn */
+    t_hit *hits;
+    size_t nhits;
+    size_t cap;
+} t_gpart;
+
+// Return: 1 khi đã đủ (first_only)
+static int grep_select(t_gpart *gp, size_t start, size_t end, size_t line) {
+    gp->count++;
+    if (gp->keep) {
+        if (gp->nhits == gp->cap) {
+            gp->cap = gp->cap ? gp->cap * 2 : 256;
+            gp->hits = Realloc(gp->hits, gp->cap * sizeof(t_hit));
+        }
+        gp->hits[gp->nhits++] = (t_hit){ start, end, line };
+    }
+    return gp->first_only;
+}
+
+/*
+** Tìm mẫu trên cả phần một lần chứ không theo từng dòng: chỉ khi thấy mẫu
+** mới lùi về đầu dòng và tiến tới cuối dòng. Số dòng chỉ được đếm (bằng
+** count_nl) khi -n cần tới.
+*/
+static void *grep_part(void *arg) {
+    t_gpart *gp = arg;
+    const t_grep *g = gp->g;
+    const char *p = gp->p;
+    size_t pos = gp->start, end = gp->end, line = 0, counted = gp->start;
+
+    gp->count = gp->nhits = 0;
+    while (pos < end) {
+        const char *m = find_str(p + pos, end - pos, g->pat, g->plen);
+        size_t ls = end, le = end;
+        if (m) {
+            const char *b = memrchr(p + pos, '\n', m - (p + pos));
+            const char *e = memchr(m, '\n', p + end - m);
+            ls = b ? (size_t)(b - p) + 1 : pos;
+            le = e ? (size_t)(e - p) : end;
+        }
+        if (g->invert) {
+            // các dòng từ pos đến dòng có mẫu đều được chọn
+            while (pos < ls) {
+                const char *e = memchr(p + pos, '\n', ls - pos);
+                size_t stop = e ? (size_t)(e - p) : ls;
+                if (grep_select(gp, pos, stop, line++))
+                    return NULL;
+                pos = stop + 1;
+            }
+            if (!m)
+                break;
+            line++;
+        } else {
+            if (!m)
+                break;
+            if (g->number) {
+                line += count_nl(p + counted, ls - counted);
+                counted = ls;
+            }
+            if (grep_select(gp, ls, le, line))
+                return NULL;
+        }
+        pos = le + 1;
+    }
+    if (g->number)
+        gp->lines = g->invert ? line : line + count_nl(p + counted, end - counted);
+    return NULL;
+}
+
+static void grep_print(const t_grep *g, const char *name, const t_gpart *gp, size_t base) {
+    for (size_t k = 0; k < gp->nhits; k++) {
+        const t_hit *h = &gp->hits[k];
+        if (g->with_name)
+            printf("%s:", name);
+        if (g->number)
+            printf("%zu:", base + h->line + 1);
+        fwrite(gp->p + h->start, 1, h->end - h->start, stdout);
+        putchar('\n');
+    }
+}
+
+// Vị trí ngay sau '\n' đầu tiên từ off trở đi (hoặc n)
+static size_t line_after(const char *p, size_t off, size_t n) {
+    const char *e = off < n ? memchr(p + off, '\n', n - off) : NULL;
+    return e ? (size_t)(e - p) + 1 : n;
+}
+
+/*
+** Quét một vùng nhớ (mmap, hoặc phần dòng trọn vẹn của bộ đệm stream).
+** Vùng lớn đi theo từng đợt: mỗi đợt mỗi luồng một phần TEXT_THREAD_MIN
+** byte cắt ở ranh giới dòng, kết quả được in theo thứ tự phần.
+** @line: số dòng trước vùng, được cộng thêm số dòng của vùng
+** Return: số dòng được chọn
+*/
+static size_t grep_mem(const t_grep *g, const char *name, const char *p, size_t n,
+                       int binary, size_t *line, t_gpart *part) {
+    int first_only = g->quiet || g->list || (binary && !g->count);
+    int nt = text_threads(n);
+    size_t off = 0, total = 0;
+
+    while (off < n) {
+        for (int k = 0; k < nt; k++) {
+            part[k].p = p;
+            part[k].g = g;
+            part[k].first_only = first_only;
+            part[k].keep = !first_only && !g->count;
+            part[k].start = off;
+            part[k].end = off = line_after(p, off + TEXT_THREAD_MIN, n);
+        }
+        run_parallel(grep_part, part, sizeof(*part), nt);
+        for (int k = 0; k < nt; k++) {
+            total += part[k].count;
+            if (part[k].keep)
+                grep_print(g, name, &part[k], *line);
+            *line += part[k].lines;
+            if (first_only && total)
+                return total;
+        }
+    }
+    return total;
+}
+
+// Pipe, tty, /proc: chỉ quét phần dòng đã trọn, phần dở dang dời lên đầu bộ đệm
+static size_t grep_stream(const t_grep *g, const char *name, int fd, t_gpart *part, int *err) {
+    size_t cap = TEXT_BLOCK, len = 0, line = 0, total = 0;
+    char *buf = Malloc(cap);
+    int binary = -1, eof = 0;
+
+    while (!eof) {
+        ssize_t r = read(fd, buf + len, cap - len);
+        if (r == -1) {
+            if (errno == EINTR)
+                continue;
+            *err = errno;
+            break;
+        }
+        eof = r == 0;
+        len += r;
+        if (binary == -1 && (len || eof))
+            binary = memchr(buf, '\0', len < TEXT_BINARY_PEEK ? len : TEXT_BINARY_PEEK) != NULL;
+        const char *nl = memrchr(buf, '\n', len);
+        size_t whole = eof ? len : nl ? (size_t)(nl - buf) + 1 : 0;
+        if (!whole) {
+            if (len == cap)
+                buf = Realloc(buf, cap *= 2);   /* một dòng dài hơn bộ đệm */
+            continue;
+        }
+        total += grep_mem(g, name, buf, whole, binary, &line, part);
+        memmove(buf, buf + whole, len - whole);
+        len -= whole;
+        if (total && (g->quiet || g->list || (binary && !g->count)))
+            break;
+    }
+    free(buf);
+    if (binary == 1 && total && !g->count && !g->list && !g->quiet)
+        printf("grep: %s: binary file matches\n", name);
+    return total;
+}
+
+static void grep_file(t_grep *g, const char *file, t_gpart *part) {
+    int std = !strcmp(file, "-");
+    const char *name = std ? "(standard input)" : file;
+    int fd = std ? STDIN_FILENO : open(file, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    size_t total = 0, line = 0;
+    int err = 0;
+
+    if (fd == -1 || fstat(fd, &st) == -1) {
+        err = errno;
+    } else if (S_ISDIR(st.st_mode)) {
+        err = EISDIR;
+    } else {
+        off_t off = S_ISREG(st.st_mode) ? lseek(fd, 0, SEEK_CUR) : -1;
+        char *map = off >= 0 && st.st_size > off
+                    ? mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        if (map != MAP_FAILED) {
+            size_t n = st.st_size - off;
+            int binary = memchr(map + off, '\0', n < TEXT_BINARY_PEEK ? n : TEXT_BINARY_PEEK) != NULL;
+            madvise(map, st.st_size, MADV_SEQUENTIAL);
+            total = grep_mem(g, name, map + off, n, binary, &line, part);
+            munmap(map, st.st_size);
+            if (binary && total && !g->count && !g->list && !g->quiet)
+                printf("grep: %s: binary file matches\n", name);
+        } else {
+            total = grep_stream(g, name, fd, part, &err);
+        }
+    }
+    if (!std && fd != -1)
+        close(fd);
+    if (err) {
+        g->errors = 1;
+        if (!g->no_msg)
+            fprintf(stderr, "grep: %s: %s\n", name, strerror(err));
+        return;
+    }
+    if (total)
+        g->matched = 1;
+    if (g->quiet)
+        return;
+    if (g->count) {
+        if (g->with_name)
+            printf("%s:", name);
+        printf("%zu\n", total);
+    } else if (g->list && total) {
+        printf("%s\n", name);
+    }
+}
+
+/**
+ * cell_grep - Fixed-string grep without forking
+ * @args: grep [-F] [-c] [-v] [-n] [-l] [-q] [-H] [-h] [-s] string [file...]
+ *        Without -F the pattern must not use BRE operators; other options
+ *        and such patterns run the external grep instead.
+ * Return: 0 if a line was selected, 1 if none, 2 on error
+ */
+int cell_grep(char **args) {
+    t_grep g = {0};
+    int nfiles = 0, fixed = 0, no_name = 0, force_name = 0, opts = 1, argc = 0;
+    while (args[argc]) argc++;
+    char **files = Malloc(argc * sizeof(char *));
+
+    for (int i = 1; args[i]; i++) {
+        const char *a = args[i];
+        if (opts && !strcmp(a, "--")) {
+            opts = 0;
+        } else if (opts && a[0] == '-' && a[1]) {
+            for (const char *o = a + 1; *o; o++) {
+                switch (*o) {
+                case 'F': fixed = 1; break;
+                case 'c': g.count = 1; break;
+                case 'v': g.invert = 1; break;
+                case 'n': g.number = 1; break;
+                case 'l': g.list = 1; break;
+                case 'q': g.quiet = 1; break;
+                case 's': g.no_msg = 1; break;
+                case 'H': force_name = 1; no_name = 0; break;
+                case 'h': no_name = 1; force_name = 0; break;
+                default: goto external;     /* cả --long, -e, -i, -E... */
+                }
+            }
+        } else if (!g.pat) {
+            g.pat = a;
+        } else {
+            files[nfiles++] = args[i];
+        }
+    }
+    if (!g.pat || !*g.pat || strchr(g.pat, '\n') || (!fixed && strpbrk(g.pat, "\\.[]*^$")))
+        goto external;
+    g.plen = strlen(g.pat);
+    g.with_name = force_name || (nfiles > 1 && !no_name);
+
+    scan_init();
+    t_gpart part[TEXT_MAX_THREADS] = {0};
+    for (int i = 0; i < (nfiles ? nfiles : 1); i++) {
+        grep_file(&g, nfiles ? files[i] : "-", part);
+        if (g.quiet && g.matched)
+            break;
+    }
+    for (int k = 0; k < TEXT_MAX_THREADS; k++)
+        free(part[k].hits);
+    free(files);
+    if (g.errors && !(g.quiet && g.matched))
+        return 2;
+    return g.matched ? 0 : 1;
+external:
+    free(files);
+    return text_external(args);
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+/*
+** wc [-lwc] [file...] và grep [-F] [-cvnlqHhs] chuỗi [file...] chạy ngay
+** trong shell, không fork. File thường được mmap, pipe/stdin thì đọc theo
+** khối TEXT_BLOCK. Đếm '\n', đếm từ và tìm chuỗi dùng SSE2/AVX2 (chọn lúc
+** chạy theo CPU, có bản vô hướng dự phòng; CELL_SIMD=avx2|sse2|scalar để
+** ép một bản). File lớn được chia cho tối đa TEXT_MAX_THREADS luồng, mỗi
+** luồng ít nhất TEXT_THREAD_MIN byte; grep đi theo từng đợt cỡ đó nên bộ
+** nhớ giữ kết quả không lớn theo file.
+**
+** Kết quả giống coreutils wc và GNU grep. Từ là dãy byte không phải khoảng
+** trắng ASCII. Tùy chọn khác, hay mẫu có ký tự đặc biệt của BRE mà không
+** có -F, được chuyển cho lệnh ngoài cùng tên. File có byte NUL trong
+** TEXT_BINARY_PEEK byte đầu là file nhị phân: grep chỉ báo "binary file
+** matches" thay vì in dòng.
+*/
+#define TEXT_BLOCK (1 << 20)
+#define TEXT_MAX_THREADS 16
+#define TEXT_THREAD_MIN (8 << 20)
+#define TEXT_BINARY_PEEK 32768
+
+int cell_wc(char **args);
+int cell_grep(char **args);
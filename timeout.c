@@ -0,0 +1,286 @@
+#define _GNU_SOURCE
+#include "cell.h"
+#include "timeout.h"
+#include "jobctl.h"
+#include "stats.h"
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdint.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+
+/*
+** timeout [-s SIG] [-k grace] DURATION cmd...
+**
+** Hết DURATION thì gửi SIG (mặc định TERM) cho mọi tiến trình của lệnh,
+** nếu có -k thì sau thời gian grace gửi tiếp SIGKILL. Mã thoát 124 khi hết
+** giờ, 137 khi phải dùng SIGKILL. Builtin chạy trong shell nên không bị
+** giới hạn; chỉ tiến trình con được giám sát.
+**
+** Hạn chót tính cho cả lần gọi: một timerfd được đặt một lần, mọi lần đợi
+** con bên trong (các lệnh của một hàm hay vòng lặp) dùng chung nó. Hết giờ
+** thì phần còn lại của hàm / vòng lặp bị bỏ như khi Ctrl-C, lệnh con nào
+** chạy sau đó nhận tín hiệu ngay. Ctrl-Z đưa lệnh đang chạy vào danh sách
+** jobs, mang theo thời gian còn lại của hạn chót.
+*/
+
+typedef struct s_deadline {
+    double secs;
+    double grace;       /* 0 = không leo thang sang SIGKILL */
+    int sig;
+    int tfd;            /* timerfd của cả lần gọi, -1 nếu chạy nền */
+    int fired;          /* đã gửi sig */
+    int killed;         /* đã phải gửi SIGKILL */
+    int interrupted;    /* cell_interrupted được đặt do hết giờ, không phải Ctrl-C */
+} t_deadline;
+
+extern int status;
+
+static t_deadline *current = NULL;
+
+// "1.5", "30s", "2m", "1h", "1d"
+static int parse_duration(const char *s, double *out) {
+    char *end;
+    double v = strtod(s, &end);
+    if (end == s || v < 0)
+        return -1;
+    switch (*end) {
+    case '\0': case 's': break;
+    case 'm': v *= 60; break;
+    case 'h': v *= 3600; break;
+    case 'd': v *= 86400; break;
+    default: return -1;
+    }
+    if (*end && end[1])
+        return -1;
+    *out = v;
+    return 0;
+}
+
+static void arm(int tfd, double secs) {
+    struct itimerspec its = {0};
+    // 0 sẽ tắt timer; hết giờ ngay thì đặt 1ns
+    its.it_value.tv_sec = (time_t)secs;
+    its.it_value.tv_nsec = (long)((secs - (time_t)secs) * 1e9);
+    if (!its.it_value.tv_sec && !its.it_value.tv_nsec)
+        its.it_value.tv_nsec = 1;
+    timerfd_settime(tfd, 0, &its, NULL);
+}
+
+static int new_timer(double secs) {
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (tfd == -1)
+        perror("timeout: timerfd_create");
+    else
+        arm(tfd, secs);
+    return tfd;
+}
+
+// Cả nhóm tiến trình của job nhận tín hiệu, kể cả con cháu của từng stage
+static void send_sig(bg_proc *job, int sig) {
+    job_signal(job, sig);
+    if (sig != SIGKILL && sig != SIGCONT)
+        job_signal(job, SIGCONT);   /* tiến trình đang dừng cũng phải nhận được */
+}
+
+int timeout_active(void) {
+    return current != NULL;
+}
+
+static void on_sigchld(int sig) {
+    (void)sig;  /* chỉ để ppoll thức dậy khi con bị dừng */
+}
+
+// Timer hết hạn: lần đầu gửi sig (rồi đặt grace), lần sau SIGKILL
+static void deadline_fire(t_deadline *d, bg_proc *grp) {
+    if (d->fired) {
+        send_sig(grp, SIGKILL);
+        d->killed = 1;
+        return;
+    }
+    d->fired = 1;
+    send_sig(grp, d->sig);
+    if (d->grace > 0)
+        arm(d->tfd, d->grace);
+    if (!cell_interrupted) {
+        cell_interrupted = 1;   /* phần còn lại của hàm / vòng lặp không chạy */
+        d->interrupted = 1;
+    }
+}
+
+// Ctrl-Z: nhóm vào danh sách jobs, timerfd riêng giữ phần còn lại của hạn chót
+static int stop_job(t_deadline *d, pid_t *pids, int *done, int n, const char *label) {
+    bg_proc *job = job_new(pids[0], pids, n, label);
+    struct itimerspec left = {0};
+
+    for (int k = 0; k < n; k++) {
+        if (!done[k]) continue;
+        job->alive &= ~(1u << k);
+        if (job->pidfds[k] != -1) close(job->pidfds[k]);
+        job->pidfds[k] = -1;
+    }
+    timerfd_gettime(d->tfd, &left);
+    if (left.it_value.tv_sec || left.it_value.tv_nsec)   /* 0 = đã gửi sig, không còn grace */
+        job->timer_fd = new_timer(left.it_value.tv_sec + left.it_value.tv_nsec / 1e9);
+    job->timeout_sig = d->sig;
+    job->timeout_grace = d->grace;
+    job->timed_out = d->fired;
+    job->status = STOPPED;
+    job_link(job);
+    printf("\n[%d]+ Stopped\t%s\n", job->id, job->cmd);
+    return 128 + SIGTSTP;
+}
+
+/**
+ * timeout_wait - Waits for a set of children under the current deadline
+ * @pids: Children to wait for (a single command or every pipeline stage)
+ * @n: Number of children
+ * @label: Command line shown if the children are stopped with Ctrl-Z
+ * Return: 124 if the deadline fired, 137 if SIGKILL was needed, 128+SIGTSTP
+ *         if the children were stopped, else the exit code of the last child
+ */
+int timeout_wait(pid_t *pids, int n, const char *label) {
+    t_deadline *d = current;
+    int pfd[n], done[n], alive = n, last = 0, stopped = 0;
+    int jc = job_nested() ? 0 : WUNTRACED;
+    uint64_t t0 = stats_now();
+    bg_proc grp = { .pgid = pids[0], .nprocs = n, .alive = ~0u };
+    struct sigaction sa = { .sa_handler = on_sigchld }, old_sa;
+    sigset_t chld, old_mask, wait_mask;
+
+    for (int k = 0; k < n; k++) {
+        done[k] = 0;
+#ifdef SYS_pidfd_open
+        pfd[k] = syscall(SYS_pidfd_open, pids[k], 0);
+        if (pfd[k] != -1)
+            fcntl(pfd[k], F_SETFD, FD_CLOEXEC);
+#else
+        pfd[k] = -1;
+#endif
+        grp.procs[k] = pids[k];
+    }
+    // pidfd chỉ báo khi con kết thúc; con bị dừng thì SIGCHLD làm ppoll thức dậy.
+    // SIGCHLD bị chặn ngoài ppoll nên không lỡ lần nào.
+    sigemptyset(&chld);
+    sigaddset(&chld, SIGCHLD);
+    sigprocmask(SIG_BLOCK, &chld, &old_mask);
+    sigaction(SIGCHLD, &sa, &old_sa);
+    wait_mask = old_mask;
+    sigdelset(&wait_mask, SIGCHLD);
+
+    if (d->fired)   // hạn chót đã qua trong một lần đợi trước
+        send_sig(&grp, d->killed ? SIGKILL : d->sig);
+    while (alive && !stopped) {
+        for (int k = 0; k < n; k++) {
+            int ws;
+            if (done[k] || waitpid(pids[k], &ws, WNOHANG | jc) != pids[k])
+                continue;
+            if (WIFSTOPPED(ws)) {
+                stopped = 1;
+                continue;
+            }
+            done[k] = 1;
+            grp.alive &= ~(1u << k);
+            alive--;
+            if (pfd[k] != -1) close(pfd[k]);
+            if (k == n - 1)
+                last = WIFEXITED(ws) ? WEXITSTATUS(ws) : 128 + WTERMSIG(ws);
+        }
+        if (!alive || stopped)
+            break;
+
+        struct pollfd fds[n + 1];
+        struct timespec slow_ts = { 0, 20000000 };
+        int nf = 0, slow = 0;
+        if (d->tfd != -1)
+            fds[nf++] = (struct pollfd){ .fd = d->tfd, .events = POLLIN };
+        for (int k = 0; k < n; k++) {
+            if (done[k]) continue;
+            if (pfd[k] != -1) fds[nf++] = (struct pollfd){ .fd = pfd[k], .events = POLLIN };
+            else slow = 1;
+        }
+        if (ppoll(fds, nf, slow ? &slow_ts : NULL, &wait_mask) == -1 && errno != EINTR)
+            break;
+        uint64_t ticks;
+        if (d->tfd != -1 && read(d->tfd, &ticks, sizeof(ticks)) == sizeof(ticks))
+            deadline_fire(d, &grp);
+    }
+    sigaction(SIGCHLD, &old_sa, NULL);
+    sigprocmask(SIG_SETMASK, &old_mask, NULL);
+    stats_record(STAT_WAIT, t0);
+    if (stopped) {
+        for (int k = 0; k < n; k++)
+            if (!done[k] && pfd[k] != -1) close(pfd[k]);
+        return stop_job(d, pids, done, n, label);
+    }
+    if (d->fired)
+        return d->killed ? 128 + SIGKILL : TIMEOUT_STATUS;
+    return last;
+}
+
+// Job nền: timerfd nằm trong bản ghi job, được poll cùng input của readline
+void timeout_attach(bg_proc *job) {
+    job->timer_fd = new_timer(current->secs);
+    job->timeout_sig = current->sig;
+    job->timeout_grace = current->grace;
+}
+
+void timeout_fire(bg_proc *job) {
+    uint64_t ticks;
+    if (job->timer_fd == -1 || read(job->timer_fd, &ticks, sizeof(ticks)) != sizeof(ticks))
+        return;
+    if (job->status == DONE)
+        return;
+    if (job->timed_out) {
+        send_sig(job, SIGKILL);
+        return;
+    }
+    job->timed_out = 1;
+    send_sig(job, job->timeout_sig);
+    if (job->timeout_grace > 0)
+        arm(job->timer_fd, job->timeout_grace);
+}
+
+/**
+ * cell_timeout - Runs a command or pipeline under a deadline
+ * @args: timeout [-s SIG] [-k grace] DURATION cmd...
+ * @background: Run the command as a background job
+ * Return: Exit code of the command, 124/137 on expiry, 125 on bad usage
+ */
+int cell_timeout(char **args, int background) {
+    t_deadline d = { .sig = SIGTERM };
+    int i = 1;
+
+    for (; args[i] && args[i][0] == '-' && args[i + 1]; i += 2) {
+        if (!strcmp(args[i], "-s") && (d.sig = job_parse_signal(args[i + 1])) > 0)
+            continue;
+        if (!strcmp(args[i], "-k") && !parse_duration(args[i + 1], &d.grace))
+            continue;
+        fprintf(stderr, "timeout: invalid option %s %s\n", args[i], args[i + 1]);
+        return 125;
+    }
+    if (!args[i] || !args[i + 1] || parse_duration(args[i], &d.secs)) {
+        fprintf(stderr, "timeout: usage: timeout [-s SIG] [-k grace] DURATION cmd...\n");
+        return 125;
+    }
+    if (d.secs <= 0) {     /* DURATION 0 = không giới hạn */
+        cell_run_args(&args[i + 1], background);
+        return status;
+    }
+    // foreground: một timer cho cả lần gọi; nền: mỗi job có timer riêng
+    t_deadline *outer = current;
+    d.tfd = background ? -1 : new_timer(d.secs);
+    if (!background && d.tfd == -1)
+        return 125;
+    current = &d;
+    cell_run_args(&args[i + 1], background);
+    current = outer;
+    if (d.tfd != -1)
+        close(d.tfd);
+    if (d.interrupted)
+        cell_interrupted = 0;
+    if (d.fired && status != 128 + SIGTSTP)
+        status = d.killed ? 128 + SIGKILL : TIMEOUT_STATUS;
+    return status;
+}
@@ -0,0 +1,16 @@
+#pragma once
+#include <sys/types.h>
+#include "processlist.h"
+
+/*
+** Hạn chót do `timeout` đặt cho lệnh (hoặc cả pipeline) nó chạy. Shell tự
+** giám sát bằng timerfd + pidfd trong vòng poll lúc đợi con, không có tiến
+** trình watchdog riêng. Job nền giữ timerfd trong bản ghi job.
+*/
+#define TIMEOUT_STATUS 124          /* như coreutils timeout */
+
+int  timeout_active(void);
+int  timeout_wait(pid_t *pids, int n, const char *label);
+void timeout_attach(bg_proc *job);
+void timeout_fire(bg_proc *job);
+int  cell_timeout(char **args, int background);
@@ -1,4 +1,7 @@
 #include "cell.h"
+#include "stats.h"
+#include "vars.h"
+#include "memacct.h"
 
 /**
  * Chdir - Changes current working directory with error handling
@@ -7,16 +10,22 @@
  * - NULL path: prints error
  * - Non-existent path: prints error
  * - Permission denied: prints error
+ * Return: 0, or -1 after printing the error
  */
-void	Chdir(const char *path)
+int	Chdir(const char *path)
 {
 	if (!path)
 	{
 		fprintf(stderr, RED"cd: path argument required\n"RST);
-		return ;
+		return (-1);
 	}
 	if (chdir(path) == -1)
+	{
 		perror(RED"cd failed"RST);
+		return (-1);
+	}
+	prompt_invalidate();
+	return (0);
 }
 
 /**
@@ -29,8 +38,14 @@ void	Chdir(const char *path)
 pid_t	Fork(void)
 {
 	pid_t	pid;
+	uint64_t	t0 = stats_now();
 
+	STAT_INC(forks);
+	readbuf_release(); // trả phần đệm của read về file trước khi con dùng chung fd
+	fflush(NULL);      // output builtin còn trong bộ đệm stdio không bị in hai lần
 	pid = fork();
+	if (pid > 0)
+		stats_record(STAT_SPAWN, t0);
 	if (pid < 0)
 	{
 		perror(RED"Fork failed"RST);
@@ -55,8 +70,10 @@ void	Execvp(const char *file, char *const argv[])
 		fprintf(stderr, RED"Execvp: invalid arguments\n"RST);
 		exit(EXIT_FAILURE);
 	}
+	STAT_INC(execs);
 	if (execvp(file, argv) == -1)
 	{
+		STAT_INC(exec_failures);
 		perror(RED"💥CELL_Jr failed💥"RST);
 		exit(EX_UNAVAILABLE);
 	}
@@ -74,6 +91,7 @@ void	Execvp(const char *file, char *const argv[])
 pid_t	Wait(int *status)
 {
 	pid_t	result;
+	uint64_t	t0 = stats_now();
 
 	if (!status)
 	{
@@ -81,6 +99,7 @@ pid_t	Wait(int *status)
 		return (-1);
 	}
 	result = wait(status);
+	stats_record(STAT_WAIT, t0);
 	if (result == -1)
 		perror(RED"Wait failed"RST);
 	if (WIFEXITED(*status))
@@ -101,10 +120,13 @@ pid_t	Wait(int *status)
 pid_t	Waitpid(pid_t pid, int *status, int options)
 {
 	pid_t	result;
+	uint64_t	t0 = stats_now();
 
 	if (!status)
 		return (-1);
 	result = waitpid(pid, status, options);
+	if (!(options & WNOHANG))
+		stats_record(STAT_WAIT, t0);
 	if (result == -1)
 		perror(RED"Waitpid failed"RST);
 	if (WIFEXITED(*status))
@@ -132,6 +154,7 @@ void	*Malloc(size_t size)
 		perror(RED"Malloc failed"RST);
 		exit(EXIT_FAILURE);
 	}
+	mem_note_alloc(size, 0);
 	return (ptr);
 }
 
@@ -156,6 +179,7 @@ void	*Realloc(void *ptr, size_t size)
 		perror(RED"Realloc failed"RST);
 		exit(EXIT_FAILURE);
 	}
+	mem_note_alloc(size, 1);
 	return (new_ptr);
 }
 
@@ -0,0 +1,791 @@
+#include "cell.h"
+#include "vars.h"
+#include "func.h"
+#include "memacct.h"
+#include <ctype.h>
+#include <fnmatch.h>
+
+#define VAR_BUCKETS 256
+
+extern int status;
+
+typedef struct s_var {
+    char *name;
+    char *value;
+    char **arr;         /* mảng chỉ số (mapfile, read -a, a[i]=x); NULL nếu là biến thường */
+    size_t n;
+    struct s_var *next;
+} t_var;
+
+static t_var *vars[VAR_BUCKETS];
+static t_posargs pos_args;      /* $1..$n hiện tại; rỗng ở mức shell */
+
+typedef struct s_saved {
+    char *name;
+    t_var *var;         /* bản ghi cũ đã tháo khỏi bảng, NULL nếu chưa có */
+    char *env;          /* giá trị environ cũ nếu tên đã được export */
+    struct s_saved *next;
+} t_saved;
+
+typedef struct s_scope {
+    t_saved *saved;
+    struct s_scope *up;
+} t_scope;
+
+static t_scope *scope;
+
+int expand_failed = 0;   /* lần cell_expand gần nhất gặp lỗi $((...)) / ${...} */
+
+void str_putn(t_str *b, const char *s, size_t n) {
+    if (b->len + n + 1 > b->cap) {
+        b->cap = (b->len + n + 1) * 2;
+        b->s = Realloc(b->s, b->cap);
+    }
+    memcpy(b->s + b->len, s, n);
+    b->len += n;
+    b->s[b->len] = '\0';
+}
+
+void str_putc(t_str *b, char c) {
+    str_putn(b, &c, 1);
+}
+
+void str_puts(t_str *b, const char *s) {
+    str_putn(b, s, strlen(s));
+}
+
+static unsigned var_hash(const char *s) {
+    unsigned h = 2166136261u;
+    while (*s)
+        h = (h ^ (unsigned char)*s++) * 16777619u;
+    return h % VAR_BUCKETS;
+}
+
+static t_var *var_find(const char *name) {
+    for (t_var *v = vars[var_hash(name)]; v; v = v->next)
+        if (!strcmp(v->name, name))
+            return v;
+    return NULL;
+}
+
+const char *var_get(const char *name) {
+    t_var *v = var_find(name);
+    if (v && v->arr)
+        return v->n && v->arr[0] ? v->arr[0] : "";
+    return v ? v->value : getenv(name);
+}
+
+static t_var *var_new(const char *name) {
+    t_var *v = var_find(name);
+    if (!v) {
+        unsigned h = var_hash(name);
+        v = Malloc(sizeof(*v));
+        v->name = strdup(name);
+        v->value = NULL;
+        v->arr = NULL;
+        v->n = 0;
+        v->next = vars[h];
+        vars[h] = v;
+    }
+    return v;
+}
+
+static void var_clear(t_var *v) {
+    free(v->value);
+    v->value = NULL;
+    for (size_t i = 0; i < v->n; i++)
+        free(v->arr[i]);
+    free(v->arr);
+    v->arr = NULL;
+    v->n = 0;
+}
+
+/*
+** Gán biến shell. Nếu tên đã có trong environ (đã export) thì cập nhật luôn
+** environ để lệnh con thấy giá trị mới. Với mảng thì gán phần tử 0.
+*/
+void var_set(const char *name, const char *value) {
+    t_var *v = var_new(name);
+    if (v->arr) {
+        var_set_elem(name, 0, value);
+        return;
+    }
+    free(v->value);
+    v->value = strdup(value);
+    if (getenv(name))
+        setenv(name, value, 1);
+}
+
+void var_set_elem(const char *name, size_t idx, const char *value) {
+    t_var *v = var_new(name);
+    if (!v->arr) {
+        // biến thường trở thành phần tử 0 của mảng
+        char *old = v->value;
+        v->value = NULL;
+        v->arr = Malloc(sizeof(char *));
+        v->arr[0] = old;
+        v->n = old ? 1 : 0;
+    }
+    if (idx >= v->n) {
+        v->arr = Realloc(v->arr, (idx + 1) * sizeof(char *));
+        memset(v->arr + v->n, 0, (idx + 1 - v->n) * sizeof(char *));
+        v->n = idx + 1;
+    }
+    free(v->arr[idx]);
+    v->arr[idx] = strdup(value);
+}
+
+/*
+** var_set_array - Thay toàn bộ mảng; nhận quyền sở hữu vals và các chuỗi
+** bên trong (mapfile nạp hàng triệu dòng, không sao chép lại).
+*/
+void var_set_array(const char *name, char **vals, size_t n) {
+    t_var *v = var_new(name);
+    var_clear(v);
+    v->arr = vals ? vals : Malloc(sizeof(char *));
+    v->n = n;
+}
+
+const char *var_get_elem(const char *name, size_t idx) {
+    t_var *v = var_find(name);
+    if (v && v->arr)
+        return idx < v->n ? v->arr[idx] : NULL;
+    return idx == 0 ? var_get(name) : NULL;
+}
+
+// Số phần tử đã gán (phần tử rỗng trong mảng thưa không tính)
+size_t var_array_len(const char *name) {
+    t_var *v = var_find(name);
+    size_t count = 0;
+    if (!v || !v->arr)
+        return var_get(name) ? 1 : 0;
+    for (size_t i = 0; i < v->n; i++)
+        if (v->arr[i]) count++;
+    return count;
+}
+
+// Tháo bản ghi biến khỏi bảng (không giải phóng); NULL nếu không có
+static t_var *var_detach(const char *name) {
+    for (t_var **pp = &vars[var_hash(name)]; *pp; pp = &(*pp)->next) {
+        if (!strcmp((*pp)->name, name)) {
+            t_var *v = *pp;
+            *pp = v->next;
+            return v;
+        }
+    }
+    return NULL;
+}
+
+static void var_free(t_var *v) {
+    if (!v) return;
+    var_clear(v);
+    free(v->name);
+    free(v);
+}
+
+void var_unset(const char *name) {
+    var_free(var_detach(name));
+    unsetenv(name);
+}
+
+void vars_mem(t_memuse *u) {
+    for (int h = 0; h < VAR_BUCKETS; h++) {
+        for (t_var *v = vars[h]; v; v = v->next) {
+            u->objects++;
+            u->bytes += mem_size(v) + mem_size(v->name) + mem_size(v->value) + mem_size(v->arr);
+            for (size_t i = 0; i < v->n; i++)
+                u->bytes += mem_size(v->arr[i]);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/* Tham số vị trí và biến local                                            */
+/* ---------------------------------------------------------------------- */
+
+// Đặt $1..$n cho lời gọi hàm; bộ cũ được cất vào saved
+void var_args_push(char **argv, t_posargs *saved) {
+    int n = 0;
+    while (argv[n]) n++;
+    *saved = pos_args;
+    pos_args.v = Malloc((n + 1) * sizeof(char *));
+    for (int i = 0; i < n; i++)
+        pos_args.v[i] = strdup(argv[i]);
+    pos_args.v[n] = NULL;
+    pos_args.n = n;
+}
+
+void var_args_pop(t_posargs *saved) {
+    free_args(pos_args.v);
+    pos_args = *saved;
+}
+
+// $i (1-based); NULL nếu không có
+const char *var_arg(int i) {
+    return i >= 1 && i <= pos_args.n ? pos_args.v[i - 1] : NULL;
+}
+
+int var_argc(void) {
+    return pos_args.n;
+}
+
+void var_args_shift(int k) {
+    if (k > pos_args.n) k = pos_args.n;
+    for (int i = 0; i < k; i++)
+        free(pos_args.v[i]);
+    memmove(pos_args.v, pos_args.v + k, (pos_args.n - k + 1) * sizeof(char *));
+    pos_args.n -= k;
+}
+
+void var_scope_push(void) {
+    t_scope *sc = Malloc(sizeof(*sc));
+    sc->saved = NULL;
+    sc->up = scope;
+    scope = sc;
+}
+
+// Trả các biến local về giá trị trước lời gọi hàm
+void var_scope_pop(void) {
+    t_scope *sc = scope;
+    if (!sc) return;
+    scope = sc->up;
+    while (sc->saved) {
+        t_saved *sv = sc->saved;
+        sc->saved = sv->next;
+        var_free(var_detach(sv->name));
+        if (sv->var) {
+            unsigned h = var_hash(sv->name);
+            sv->var->next = vars[h];
+            vars[h] = sv->var;
+        }
+        if (sv->env) setenv(sv->name, sv->env, 1);
+        else unsetenv(sv->name);
+        free(sv->env);
+        free(sv->name);
+        free(sv);
+    }
+    free(sc);
+}
+
+/**
+ * var_local - Makes name local to the running function
+ * @name: Variable name; starts out unset until assigned
+ * Return: 0 on success, -1 outside a function
+ */
+int var_local(const char *name) {
+    if (!scope)
+        return -1;
+    for (t_saved *sv = scope->saved; sv; sv = sv->next)
+        if (!strcmp(sv->name, name))
+            return 0;   /* đã local trong hàm này */
+    t_saved *sv = Malloc(sizeof(*sv));
+    const char *env = getenv(name);
+    sv->name = strdup(name);
+    sv->var = var_detach(name);
+    sv->env = env ? strdup(env) : NULL;
+    sv->next = scope->saved;
+    scope->saved = sv;
+    if (env) unsetenv(name);
+    return 0;
+}
+
+int var_valid_name(const char *s, size_t len) {
+    if (len == 0 || !(isalpha((unsigned char)s[0]) || s[0] == '_'))
+        return 0;
+    for (size_t i = 1; i < len; i++)
+        if (!(isalnum((unsigned char)s[i]) || s[i] == '_'))
+            return 0;
+    return 1;
+}
+
+// "NAME=value" hoặc "NAME[i]=value" ở đầu lệnh là phép gán
+int is_assignment(const char *tok) {
+    const char *eq = strchr(tok, '=');
+    if (!eq)
+        return 0;
+    const char *br = memchr(tok, '[', eq - tok);
+    if (br)
+        return eq[-1] == ']' && var_valid_name(tok, br - tok);
+    return var_valid_name(tok, eq - tok);
+}
+
+/**
+ * var_assign - Applies an assignment token in place
+ * @tok: "NAME=value" or "NAME[expr]=value" (modified: '=' becomes '\0')
+ */
+void var_assign(char *tok) {
+    char *eq = strchr(tok, '=');
+    char *br = memchr(tok, '[', eq - tok);
+    *eq = '\0';
+    if (br) {
+        long long idx = 0;
+        eq[-1] = '\0';
+        *br = '\0';
+        if (arith_eval(br + 1, &idx) == 0 && idx >= 0)
+            var_set_elem(tok, idx, eq + 1);
+        else
+            fprintf(stderr, "cell: %s[%s]: bad array subscript\n", tok, br + 1);
+        return;
+    }
+    var_set(tok, eq + 1);
+}
+
+void free_args(char **args) {
+    if (!args) return;
+    for (int i = 0; args[i]; i++) free(args[i]);
+    free(args);
+}
+
+/* ---------------------------------------------------------------------- */
+/* Mở rộng                                                                 */
+/* ---------------------------------------------------------------------- */
+
+typedef struct s_fields {
+    char **v;
+    int n;
+    int cap;
+} t_fields;
+
+static void fields_push(t_fields *f, char *s) {
+    if (f->n + 2 > f->cap) {
+        f->cap = f->cap ? f->cap * 2 : 8;
+        f->v = Realloc(f->v, f->cap * sizeof(char *));
+    }
+    f->v[f->n++] = s;
+    f->v[f->n] = NULL;
+}
+
+// Giá trị của $?, $$, $NAME...; trả về chuỗi tạm trong buf hoặc giá trị biến
+static const char *special_or_var(const char *name, char *buf, size_t size) {
+    if (!strcmp(name, "?")) {
+        snprintf(buf, size, "%d", status);
+        return buf;
+    }
+    if (!strcmp(name, "$")) {
+        snprintf(buf, size, "%d", (int)getpid());
+        return buf;
+    }
+    if (!strcmp(name, "0"))
+        return "cell";
+    if (!strcmp(name, "#")) {
+        snprintf(buf, size, "%d", pos_args.n);
+        return buf;
+    }
+    if (isdigit((unsigned char)name[0]))
+        return var_arg(atoi(name));
+    if (!strcmp(name, "@") || !strcmp(name, "*")) {
+        // chưa nằm trong "...": nối bằng dấu cách rồi tách trường lại
+        static t_str all;
+        all.len = 0;
+        str_puts(&all, "");
+        for (int i = 0; i < pos_args.n; i++) {
+            if (i) str_putc(&all, ' ');
+            str_puts(&all, pos_args.v[i]);
+        }
+        return all.s;
+    }
+    return var_get(name);
+}
+
+// Xóa tiền tố/hậu tố khớp mẫu: ${v#p} ${v##p} ${v%p} ${v%%p}
+static void trim_pattern(t_str *out, const char *val, const char *pat, int suffix, int longest) {
+    size_t n = strlen(val);
+    char *tmp = Malloc(n + 1);
+    for (size_t k = 0; k <= n; k++) {
+        size_t len = longest ? n - k : k;   // độ dài phần bị xóa
+        int ok;
+        if (suffix) {
+            ok = !fnmatch(pat, val + n - len, 0);
+        } else {
+            memcpy(tmp, val, len);
+            tmp[len] = '\0';
+            ok = !fnmatch(pat, tmp, 0);
+        }
+        if (ok) {
+            if (suffix) str_putn(out, val, n - len);
+            else str_puts(out, val + len);
+            free(tmp);
+            return;
+        }
+    }
+    free(tmp);
+    str_puts(out, val);
+}
+
+// ${v/p/r} và ${v//p/r}: thay lần khớp dài nhất tại vị trí sớm nhất
+static void replace_pattern(t_str *out, const char *val, const char *pat,
+                            const char *rep, int all) {
+    size_t n = strlen(val), i = 0;
+    char *tmp = Malloc(n + 1);
+    int done = 0;
+    while (i < n) {
+        size_t best = 0;
+        if (!done) {
+            for (size_t len = n - i; len > 0; len--) {
+                memcpy(tmp, val + i, len);
+                tmp[len] = '\0';
+                if (!fnmatch(pat, tmp, 0)) { best = len; break; }
+            }
+        }
+        if (best) {
+            str_puts(out, rep);
+            i += best;
+            if (!all) done = 1;
+        } else {
+            str_putc(out, val[i++]);
+        }
+    }
+    free(tmp);
+}
+
+/*
+** ${...}: tên biến và các phép xử lý chuỗi
+**   ${#v} ${v:-d} ${v:=d} ${v:+a} ${v:off:len} ${v#p} ${v##p} ${v%p} ${v%%p}
+**   ${v/p/r} ${v//p/r}
+*/
+static void expand_brace(t_str *out, const char *body) {
+    char buf[32];
+    size_t nl = 0;
+
+    if (body[0] == '#' && body[1]) {
+        const char *br = strchr(body, '[');
+        if (br && (!strcmp(br, "[@]") || !strcmp(br, "[*]"))) {
+            char *name = strndup(body + 1, br - body - 1);
+            snprintf(buf, sizeof(buf), "%zu", var_array_len(name));
+            free(name);
+        } else {
+            t_str tmp = {0};
+            expand_brace(&tmp, body + 1);
+            snprintf(buf, sizeof(buf), "%zu", tmp.len);
+            free(tmp.s);
+        }
+        str_puts(out, buf);
+        return;
+    }
+    while (body[nl] && (isalnum((unsigned char)body[nl]) || body[nl] == '_'))
+        nl++;
+    if (nl == 0 && body[0] && strchr("?$#@*", body[0]))
+        nl = 1;
+    char *name = strndup(body, nl);
+    const char *op = body + nl;
+    const char *val;
+    t_str joined = {0};
+    if (*op == '[') {
+        // ${a[i]}, ${a[@]} / ${a[*]} (nối các phần tử bằng khoảng trắng)
+        const char *end = strchr(op, ']');
+        char *sub = strndup(op + 1, end ? (size_t)(end - op - 1) : strlen(op + 1));
+        if (!strcmp(sub, "@") || !strcmp(sub, "*")) {
+            size_t n = var_array_len(name);
+            for (size_t i = 0, k = 0; k < n; i++) {
+                const char *e = var_get_elem(name, i);
+                if (!e) continue;
+                if (k++) str_putc(&joined, ' ');
+                str_puts(&joined, e);
+            }
+            val = joined.s;
+        } else {
+            long long idx = 0;
+            arith_eval(sub, &idx);
+            val = idx >= 0 ? var_get_elem(name, idx) : NULL;
+        }
+        free(sub);
+        op = end ? end + 1 : op + strlen(op);
+    } else {
+        val = special_or_var(name, buf, sizeof(buf));
+    }
+    const char *v = val ? val : "";
+
+    if (!*op) {
+        str_puts(out, v);
+    } else if (op[0] == ':' && (op[1] == '-' || op[1] == '=' || op[1] == '+')) {
+        int empty = !val || !*val;
+        if (op[1] == '-') str_puts(out, empty ? op + 2 : v);
+        else if (op[1] == '+') str_puts(out, empty ? "" : op + 2);
+        else {
+            if (empty) var_set(name, op + 2);
+            str_puts(out, empty ? op + 2 : v);
+        }
+    } else if (op[0] == ':') {
+        long long off = 0, len = -1;
+        char *colon = strchr(op + 1, ':');
+        char *e1 = colon ? strndup(op + 1, colon - op - 1) : strdup(op + 1);
+        arith_eval(e1, &off);
+        if (colon) arith_eval(colon + 1, &len);
+        free(e1);
+        long long n = strlen(v);
+        if (off < 0) off = n + off < 0 ? 0 : n + off;
+        if (off > n) off = n;
+        if (len < 0 || off + len > n) len = n - off;
+        str_putn(out, v + off, len);
+    } else if (op[0] == '#' || op[0] == '%') {
+        int longest = op[1] == op[0];
+        trim_pattern(out, v, op + 1 + longest, op[0] == '%', longest);
+    } else if (op[0] == '/') {
+        int all = op[1] == '/';
+        const char *pat = op + 1 + all;
+        const char *slash = strchr(pat, '/');
+        char *p = slash ? strndup(pat, slash - pat) : strdup(pat);
+        replace_pattern(out, v, p, slash ? slash + 1 : "", all);
+        free(p);
+    } else {
+        fprintf(stderr, "cell: ${%s}: bad substitution\n", body);
+        expand_failed = 1;
+    }
+    free(joined.s);
+    free(name);
+}
+
+// Tìm vị trí đóng của $((...)) / ${...}; trả về con trỏ ngay sau dấu đóng
+static const char *match_close(const char *p, char open, char close) {
+    int depth = 0;
+    for (; *p; p++) {
+        if (*p == open) depth++;
+        else if (*p == close && --depth == 0) return p + 1;
+    }
+    return p;
+}
+
+/*
+** Mở rộng một '$' tại *pp; ghi kết quả vào out. Con trỏ được dịch qua phần
+** đã xử lý. Return: 1 nếu có mở rộng, 0 nếu '$' đứng một mình.
+*/
+static int expand_dollar(const char **pp, t_str *out) {
+    const char *p = *pp + 1;
+    char buf[32];
+
+    if (p[0] == '(' && p[1] == '(') {
+        const char *end = match_close(p, '(', ')');
+        // nội dung nằm giữa "$((" và "))"
+        size_t len = end - p >= 4 ? (size_t)(end - p) - 4 : 0;
+        char *expr = strndup(p + 2, len);
+        long long v = 0;
+        if (arith_expand_eval(expr, &v) == 0) {
+            snprintf(buf, sizeof(buf), "%lld", v);
+            str_puts(out, buf);
+        } else {
+            expand_failed = 1;
+        }
+        free(expr);
+        *pp = end;
+        return 1;
+    }
+    if (p[0] == '{') {
+        const char *end = match_close(p, '{', '}');
+        char *body = strndup(p + 1, end - p - 2 >= 0 ? end - p - 2 : 0);
+        expand_brace(out, body);
+        free(body);
+        *pp = end;
+        return 1;
+    }
+    size_t nl = 0;
+    if (isdigit((unsigned char)p[0]) || (p[0] && strchr("?$#@*", p[0])))
+        nl = 1;
+    else
+        while (isalnum((unsigned char)p[nl]) || p[nl] == '_') nl++;
+    if (nl == 0)
+        return 0;
+    char *name = strndup(p, nl);
+    const char *v = special_or_var(name, buf, sizeof(buf));
+    if (v) str_puts(out, v);
+    free(name);
+    *pp = p + nl;
+    return 1;
+}
+
+/**
+ * arith_expand_eval - Expands $-references in an expression, then evaluates it
+ * @expr: Text of $((...)), ((...)) or a for ((;;)) clause
+ * @out: Receives the result
+ * Return: 0 on success, -1 on error
+ */
+int arith_expand_eval(const char *expr, long long *out) {
+    t_str tmp = {0};
+    for (const char *q = expr; *q; ) {
+        if (*q == '$' && expand_dollar(&q, &tmp)) continue;
+        str_putc(&tmp, *q++);
+    }
+    int r = arith_eval(tmp.s ? tmp.s : "", out);
+    free(tmp.s);
+    return r;
+}
+
+/*
+** "$@", "${@}", "${a[@]}" trong nháy kép: mỗi phần tử là một trường riêng.
+** Trả về số phần tử và dịch *pp qua phần đã đọc; -1 nếu không phải dạng này.
+*/
+static int quoted_list(const char **pp, const char ***vals) {
+    const char *p = *pp + 1;
+    static const char **v;
+    int n = 0;
+
+    if (!strncmp(p, "@", 1) || !strncmp(p, "{@}", 3)) {
+        *pp = p + (*p == '@' ? 1 : 3);
+        v = Realloc(v, (pos_args.n + 1) * sizeof(char *));
+        for (int i = 0; i < pos_args.n; i++)
+            v[n++] = pos_args.v[i];
+        *vals = v;
+        return n;
+    }
+    size_t nl = 0;
+    if (*p++ != '{')
+        return -1;
+    while (isalnum((unsigned char)p[nl]) || p[nl] == '_') nl++;
+    if (!nl || strncmp(p + nl, "[@]}", 4))
+        return -1;
+    char *name = strndup(p, nl);
+    t_var *var = var_find(name);
+    free(name);
+    *pp = p + nl + 4;
+    if (!var || !var->arr) {
+        // biến thường: một phần tử nếu có giá trị
+        v = Realloc(v, 2 * sizeof(char *));
+        if (var && var->value) v[n++] = var->value;
+        *vals = v;
+        return n;
+    }
+    v = Realloc(v, (var->n + 1) * sizeof(char *));
+    for (size_t i = 0; i < var->n; i++)
+        if (var->arr[i]) v[n++] = var->arr[i];
+    *vals = v;
+    return n;
+}
+
+/*
+** Mở rộng một từ: bỏ dấu nháy, thay biến, tách trường các phần mở rộng
+** không nằm trong nháy theo khoảng trắng.
+*/
+static void expand_word(const char *w, t_fields *f) {
+    t_str cur = {0};
+    int have = 0;       /* trường hiện tại tồn tại (kể cả rỗng do "") */
+    int dq = 0;
+    size_t open_len = 0;
+    int open_have = 0, empty_list = 0;
+
+    for (const char *p = w; *p; ) {
+        const char **list;
+        int nlist;
+        if (dq && *p == '$' && (nlist = quoted_list(&p, &list)) >= 0) {
+            for (int k = 0; k < nlist; k++) {
+                if (k) {
+                    fields_push(f, cur.s ? cur.s : strdup(""));
+                    cur = (t_str){0};
+                }
+                str_puts(&cur, list[k]);
+            }
+            empty_list = nlist == 0;
+            continue;
+        }
+        if (!dq && *p == '\'') {
+            const char *end = strchr(p + 1, '\'');
+            if (!end) end = p + strlen(p);
+            str_putn(&cur, p + 1, end - p - 1);
+            have = 1;
+            p = *end ? end + 1 : end;
+        } else if (*p == '"') {
+            dq = !dq;
+            if (dq) {
+                open_len = cur.len;
+                open_have = have;
+                empty_list = 0;
+            } else if (empty_list && cur.len == open_len && !open_have) {
+                // "$@" không có tham số nào: không sinh trường rỗng
+                have = open_have;
+                p++;
+                continue;
+            }
+            have = 1;
+            p++;
+        } else if (*p == '\\' && p[1] && (!dq || strchr("$\"\\`", p[1]))) {
+            str_putc(&cur, p[1]);
+            have = 1;
+            p += 2;
+        } else if (*p == '$') {
+            t_str val = {0};
+            if (!expand_dollar(&p, &val)) {
+                str_putc(&cur, *p++);
+                have = 1;
+                continue;
+            }
+            if (dq) {
+                if (val.s) str_puts(&cur, val.s);
+                have = 1;
+            } else if (val.s) {
+                // tách trường theo khoảng trắng
+                for (char *q = val.s; *q; q++) {
+                    if (strchr(" \t\n", *q)) {
+                        if (have || cur.len) {
+                            fields_push(f, cur.s ? cur.s : strdup(""));
+                            cur = (t_str){0};
+                            have = 0;
+                        }
+                    } else {
+                        str_putc(&cur, *q);
+                        have = 1;
+                    }
+                }
+            }
+            free(val.s);
+        } else {
+            str_putc(&cur, *p++);
+            have = 1;
+        }
+    }
+    if (have || cur.len)
+        fields_push(f, cur.s ? cur.s : strdup(""));
+    else
+        free(cur.s);
+}
+
+/**
+ * cell_expand - Expands quotes, variables and $((...)) in a token vector
+ * @args: Raw tokens from cell_split_line
+ * Return: New malloc'd NULL-terminated vector (free with free_args); sets
+ * expand_failed when an expansion errored and the command must not run
+ */
+char **cell_expand(char **args) {
+    t_fields f = {0};
+    expand_failed = 0;
+    fields_push(&f, NULL);
+    f.n = 0;
+    for (int i = 0; args[i]; i++) {
+        // Token toán tử và process substitution giữ nguyên
+        if (!strpbrk(args[i], "'\"\\$"))
+            fields_push(&f, strdup(args[i]));
+        else
+            expand_word(args[i], &f);
+    }
+    return f.v;
+}
+
+// Lệnh export: export NAME[=value]...; không tham số thì in environ
+int cell_export(char **args) {
+    if (!args[1])
+        return cell_env(args);
+    for (int i = 1; args[i]; i++) {
+        char *eq = strchr(args[i], '=');
+        if (eq) {
+            *eq = '\0';
+            var_set(args[i], eq + 1);
+            setenv(args[i], eq + 1, 1);
+            *eq = '=';
+        } else {
+            const char *v = var_get(args[i]);
+            setenv(args[i], v ? v : "", 1);
+        }
+    }
+    return 0;
+}
+
+// Lệnh unset [-f|-v] NAME...: -f xóa hàm shell
+int cell_unset(char **args) {
+    int i = 1, funcs = 0;
+    if (args[1] && (!strcmp(args[1], "-f") || !strcmp(args[1], "-v"))) {
+        funcs = args[1][1] == 'f';
+        i++;
+    }
+    for (; args[i]; i++) {
+        if (funcs) func_unset(args[i]);
+        else var_unset(args[i]);
+    }
+    return 0;
+}
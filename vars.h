@@ -0,0 +1,70 @@
+#pragma once
+#include <stddef.h>
+
+/*
+** Biến shell, mở rộng tham số và số học.
+**
+** Biến shell nằm trong bảng băm riêng; biến đã export thì đồng bộ sang
+** environ. var_get tìm trong bảng trước rồi mới tới environ.
+*/
+
+typedef struct s_str {
+    char *s;
+    size_t len;
+    size_t cap;
+} t_str;
+
+void        str_putc(t_str *b, char c);
+void        str_putn(t_str *b, const char *s, size_t n);
+void        str_puts(t_str *b, const char *s);
+
+const char *var_get(const char *name);
+void        var_set(const char *name, const char *value);
+void        var_unset(const char *name);
+void        var_set_elem(const char *name, size_t idx, const char *value);
+void        var_set_array(const char *name, char **vals, size_t n);
+const char *var_get_elem(const char *name, size_t idx);
+size_t      var_array_len(const char *name);
+void        var_assign(char *tok);
+int         var_valid_name(const char *s, size_t len);
+int         is_assignment(const char *tok);
+
+/*
+** Tham số vị trí $1..$n / $# / $@ của lời gọi hàm đang chạy, và phạm vi biến
+** `local` (phạm vi động như bash: hàm được gọi thấy biến local của hàm gọi).
+*/
+typedef struct s_posargs {
+    char **v;
+    int n;
+} t_posargs;
+
+void        var_args_push(char **argv, t_posargs *saved);
+void        var_args_pop(t_posargs *saved);
+const char *var_arg(int i);
+int         var_argc(void);
+void        var_args_shift(int k);
+void        var_scope_push(void);
+void        var_scope_pop(void);
+int         var_local(const char *name);
+
+extern int  expand_failed;
+char      **cell_expand(char **args);
+void        free_args(char **args);
+
+int         arith_eval(const char *expr, long long *out);
+int         arith_expand_eval(const char *expr, long long *out);
+
+int         cell_export(char **args);
+int         cell_unset(char **args);
+
+/*
+** Đọc có đệm cho read/mapfile. File thường được lseek trả lại phần chưa
+** dùng trước mỗi fork (readbuf_release) để tiến trình con thấy đúng offset.
+*/
+void        readbuf_release(void);
+void        readbuf_own(int fd);
+void        readbuf_close(int fd);
+struct s_rbuf *readbuf_detach(int fd);
+void        readbuf_attach(int fd, struct s_rbuf *rb);
+int         cell_read(char **args);
+int         cell_mapfile(char **args);